@@ -0,0 +1,588 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file CACG.cpp
+
+ HPCG routine
+ */
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <vector>
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#endif
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#include "hpcg.hpp"
+
+#include "CACG.hpp"
+#include "CG.hpp"
+#include "mytimer.hpp"
+#include "ComputeSPMV.hpp"
+#include "ComputeMG.hpp"
+#include "ComputeDotProduct.hpp"
+#include "TrackedAllocator.hpp"
+#include "CommThread.hpp"
+
+#ifndef HPCG_NO_MPI
+#include "ExchangeHalo.hpp"
+#endif
+
+// Use TICK and TOCK to time a code section in MATLAB-like fashion
+#define TICK()  t0 = mytimer() //!< record current time in 't0'
+#define TOCK(t) t += mytimer() - t0 //!< store time difference in 't' using time in 't0'
+
+#define HPCG_CACG_MAX_BASIS (2*HPCG_CACG_MAX_STEPS+1)
+
+static CACGComparison cacgComparison = { 0, 0, 0, 0.0, 0, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0} };
+
+// x = M^{-1} w, or a copy of w without preconditioning
+static void ApplyPreconditioner(const SparseMatrix & A, const CACGData & cadata, const Vector & w, Vector & v) {
+  if (cadata.preconditioned) ComputeMG(A, w, v);
+  else if (w.values != v.values) CopyVector(w, v);
+}
+
+// w = (A*v - theta*wprev)/sigma, the next vector of a Newton basis
+static void NextBasisVector(const SparseMatrix & A, const CACGData & cadata, Vector & v, const Vector * wprev, double theta, Vector & w) {
+  ComputeSPMV(A, v, w);
+  const local_int_t nrow = A.localNumberOfRows;
+  const double scale = 1.0/cadata.sigma;
+  double * const wv = w.values;
+  if (wprev == 0 || theta == 0.0) {
+#ifndef HPCG_NO_OPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t i=0; i<nrow; ++i) wv[i] *= scale;
+  } else {
+    const double * const pv = wprev->values;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t i=0; i<nrow; ++i) wv[i] = scale*(wv[i] - theta*pv[i]);
+  }
+}
+
+/*
+  Unpreconditioned basis V[first+1..first+count] from V[first] with the matrix powers kernel:
+  a single exchange fills width ghost layers of V[first] and every product is computed on
+  one ring less than the previous one, so no further communication is needed.
+*/
+static void ComputeMatrixPowers(const SparseMatrix & A, const CACGData & cadata, int first, int count) {
+  const DeepHalo & halo = *cadata.deepHalo;
+#ifndef HPCG_NO_MPI
+  ExchangeDeepHalo(A, cadata.V[first]);
+#endif
+  const double scale = 1.0/cadata.sigma;
+  for (int i=0; i<count; ++i) {
+    const int rings = halo.width-1-i;
+    Vector & v = cadata.V[first+i];
+    Vector & w = cadata.V[first+i+1];
+    ComputeDeepHaloSPMV(halo, v, w, rings);
+    const local_int_t n = DeepHaloRows(halo, rings);
+    const double theta = cadata.theta[i];
+    const double * const vv = v.values;
+    double * const wv = w.values;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t j=0; j<n; ++j) wv[j] = scale*(wv[j] - theta*vv[j]);
+  }
+}
+
+/*
+  Local part of the Gram matrices W^T V and W^T W. W[0] is never formed: its row of the
+  first matrix and its row and column of the second one are zero.
+*/
+static void ComputeLocalGram(const CACGData & cadata, local_int_t nrow, double * gram) {
+  const int m = cadata.m;
+  const double * Wp[HPCG_CACG_MAX_BASIS];
+  const double * Vp[HPCG_CACG_MAX_BASIS];
+  for (int j=0; j<m; ++j) {
+    Wp[j] = cadata.W[j].values;
+    Vp[j] = cadata.V[j].values;
+  }
+  memset(gram, 0, 2*m*m*sizeof(double));
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    double local[2*HPCG_CACG_MAX_BASIS*HPCG_CACG_MAX_BASIS];
+    memset(local, 0, 2*m*m*sizeof(double));
+    double * const G = local;
+    double * const H = local + m*m;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp for nowait
+#endif
+    for (local_int_t i=0; i<nrow; ++i) {
+      double w[HPCG_CACG_MAX_BASIS], v[HPCG_CACG_MAX_BASIS];
+      w[0] = 0.0;
+      for (int j=1; j<m; ++j) w[j] = Wp[j][i];
+      for (int j=0; j<m; ++j) v[j] = Vp[j][i];
+      for (int a=1; a<m; ++a) {
+        for (int b=0; b<m; ++b) G[a*m+b] += w[a]*v[b];
+        for (int b=a; b<m; ++b) H[a*m+b] += w[a]*w[b];
+      }
+    }
+#ifndef HPCG_NO_OPENMP
+    #pragma omp critical (CACGGram)
+#endif
+    for (int k=0; k<2*m*m; ++k) gram[k] += local[k];
+  }
+  // W^T W is symmetric, only the upper triangle was summed
+  double * const H = gram + m*m;
+  for (int a=0; a<m; ++a)
+    for (int b=0; b<a; ++b) H[a*m+b] = H[b*m+a];
+}
+
+// x^T M y for a dense m x m matrix M
+static double BilinearForm(int m, const double * x, const double * M, const double * y) {
+  double sum = 0.0;
+  for (int a=0; a<m; ++a) {
+    if (x[a] == 0.0) continue;
+    double row = 0.0;
+    for (int b=0; b<m; ++b) row += M[a*m+b]*y[b];
+    sum += x[a]*row;
+  }
+  return sum;
+}
+
+/*
+  Maps the coefficients back to vectors: x += V*xc, and the next outer iteration starts
+  from p = V*pc (stored in V[0]), r = W*rc (stored in W[s+1]) and z = V*rc (stored in V[s+1]).
+  Each row is read completely before it is written, so the update can be done in place.
+*/
+static void CombineBasis(const CACGData & cadata, local_int_t nrow, const double * xc, const double * rc, const double * pc, Vector & x) {
+  const int m = cadata.m;
+  const int s = cadata.s;
+  const double * Wp[HPCG_CACG_MAX_BASIS];
+  const double * Vp[HPCG_CACG_MAX_BASIS];
+  for (int j=0; j<m; ++j) {
+    Wp[j] = cadata.W[j].values;
+    Vp[j] = cadata.V[j].values;
+  }
+  double * const xv = x.values;
+  double * const pv = cadata.V[0].values;
+  double * const zv = cadata.V[s+1].values;
+  double * const rv = cadata.W[s+1].values;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<nrow; ++i) {
+    double xs = 0.0, rs = 0.0, zs = 0.0, ps = 0.0;
+    for (int j=0; j<m; ++j) {
+      const double v = Vp[j][i];
+      xs += xc[j]*v;
+      zs += rc[j]*v;
+      ps += pc[j]*v;
+      if (j > 0) rs += rc[j]*Wp[j][i];
+    }
+    xv[i] += xs;
+    pv[i] = ps;
+    zv[i] = zs;
+    rv[i] = rs;
+  }
+}
+
+/*!
+  Allocates the basis of the s-step solver and chooses its Newton basis.
+
+  The largest eigenvalue of the operator (A, or M^{-1}A with the MG preconditioner) is
+  estimated by ten power iterations started from b. The shifts are Chebyshev points of
+  [0, lambdaMax] in Leja order, with theta[0] = 0 since the first direction vector is only
+  known on the V side, and the basis is scaled by the capacity lambdaMax/4 of the interval.
+
+  @param[in]  A                 The known system matrix
+  @param[in]  b                 Right hand side used to start the power iterations
+  @param[in]  s                 Number of CG iterations per outer iteration, 1 to HPCG_CACG_MAX_STEPS
+  @param[in]  doPreconditioning Build the basis for the MG preconditioned operator
+  @param[out] cadata            The solver data
+
+  @return Returns zero on success and a non-zero value if s is out of range.
+*/
+int InitializeCACGData(const SparseMatrix & A, const Vector & b, int s, bool doPreconditioning, CACGData & cadata) {
+  if (s < 1 || s > HPCG_CACG_MAX_STEPS) return 1;
+  const local_int_t nrow = A.localNumberOfRows;
+  const local_int_t ncol = A.localNumberOfColumns;
+  const int m = 2*s+1;
+
+  cadata.s = s;
+  cadata.m = m;
+  cadata.preconditioned = doPreconditioning;
+  cadata.deepHalo = 0;
+  const struct optData * optData = (const struct optData *) A.optimizationData;
+  if (!doPreconditioning && optData != 0 && optData->deepHalo != 0 && optData->deepHalo->width >= s)
+    cadata.deepHalo = optData->deepHalo;
+  cadata.V = new Vector[m];
+  cadata.W = new Vector[m];
+  for (int j=0; j<m; ++j) {
+    if (cadata.deepHalo) InitializeDeepHaloVector(*cadata.deepHalo, cadata.V[j], ncol);
+    else InitializeVector(cadata.V[j], ncol);
+    if (j > 0 && doPreconditioning) InitializeVector(cadata.W[j], nrow);
+    else if (j > 0) cadata.W[j] = cadata.V[j];
+    else {
+      cadata.W[j].localLength = 0;
+      cadata.W[j].values = 0;
+      cadata.W[j].optimizationData = 0;
+    }
+  }
+  cadata.theta = (double *) TrackedMalloc(s*sizeof(double), HPCG_MEM_SCRATCH);
+  cadata.B = (double *) TrackedMalloc(m*m*sizeof(double), HPCG_MEM_SCRATCH);
+  cadata.gram = (double *) TrackedMalloc(4*m*m*sizeof(double), HPCG_MEM_SCRATCH);
+
+  // Power iterations on V[0] and V[1], W[1] holds A*V[0]
+  double t_allreduce = 0.0, norm = 0.0;
+  bool isOptimized = true;
+  ComputeDotProduct(nrow, b, b, norm, t_allreduce, isOptimized);
+  norm = sqrt(norm);
+  for (local_int_t i=0; i<nrow; ++i) cadata.V[0].values[i] = b.values[i]/norm;
+  double lambda = 1.0;
+  for (int k=0; k<10; ++k) {
+    ComputeSPMV(A, cadata.V[0], cadata.W[1]);
+    ApplyPreconditioner(A, cadata, cadata.W[1], cadata.V[1]);
+    ComputeDotProduct(nrow, cadata.V[1], cadata.V[1], norm, t_allreduce, isOptimized);
+    lambda = sqrt(norm);
+    for (local_int_t i=0; i<nrow; ++i) cadata.V[0].values[i] = cadata.V[1].values[i]/lambda;
+  }
+  // Power iterations approach the largest eigenvalue from below
+  cadata.lambdaMax = 1.1*lambda;
+  cadata.sigma = cadata.lambdaMax/4.0;
+
+  // Leja ordering of the s-1 Chebyshev points, starting from the end point 0
+  cadata.theta[0] = 0.0;
+  std::vector<double> candidates(s > 1 ? s-1 : 0);
+  for (int k=0; k<s-1; ++k)
+    candidates[k] = 0.5*cadata.lambdaMax*(1.0 - cos((2.0*k+1.0)*M_PI/(2.0*(s-1))));
+  for (int j=1; j<s; ++j) {
+    int best = 0;
+    double bestProduct = -1.0;
+    for (int k=0; k<(int) candidates.size(); ++k) {
+      double product = 1.0;
+      for (int l=0; l<j; ++l) product *= fabs(candidates[k] - cadata.theta[l]);
+      if (product > bestProduct) {
+        bestProduct = product;
+        best = k;
+      }
+    }
+    cadata.theta[j] = candidates[best];
+    candidates.erase(candidates.begin()+best);
+  }
+
+  // A*V[j] = sigma*W[j+1] + theta*W[j] inside each of the two blocks
+  for (int k=0; k<m*m; ++k) cadata.B[k] = 0.0;
+  for (int i=0; i<s; ++i) {
+    cadata.B[(i+1)*m+i] = cadata.sigma;
+    cadata.B[i*m+i] = cadata.theta[i];
+  }
+  for (int i=0; i<s-1; ++i) {
+    const int c = s+1+i;
+    cadata.B[(c+1)*m+c] = cadata.sigma;
+    cadata.B[c*m+c] = cadata.theta[i];
+  }
+  return 0;
+}
+
+/*!
+  Deallocates the data of the s-step solver.
+
+  @param[inout] cadata The solver data
+*/
+void DeleteCACGData(CACGData & cadata) {
+  for (int j=0; j<cadata.m; ++j) {
+    DeleteVector(cadata.V[j]);
+    if (j > 0 && cadata.preconditioned) DeleteVector(cadata.W[j]);
+  }
+  delete [] cadata.V;
+  delete [] cadata.W;
+  TrackedFree(cadata.theta);
+  TrackedFree(cadata.B);
+  TrackedFree(cadata.gram);
+  cadata.m = 0;
+  return;
+}
+
+/*!
+  Routine to compute an approximate solution to Ax = b with the s-step (communication-avoiding)
+  formulation of preconditioned CG.
+
+  Every outer iteration builds the Newton basis V of the direction and preconditioned residual
+  Krylov spaces together with W = M*V, computes the Gram matrices W^T V and W^T W with a single
+  global reduction and then performs s CG iterations on coefficient vectors of length 2s+1.
+  In exact arithmetic the iterates are those of CG. Building the basis costs 2s-1 SpMVs and
+  preconditioner applications per s iterations, which is the price of removing all but one of
+  the 3s reductions. Without preconditioning, and with a deep halo of width at least s, the
+  basis is built by the matrix powers kernel with two halo exchanges per outer iteration.
+
+  @param[in]    A         The known system matrix
+  @param[inout] data      The CG vectors, p and Ap are used for the initial residual
+  @param[inout] cadata    The basis set up by InitializeCACGData
+  @param[in]    b         The known right hand side vector
+  @param[inout] x         On entry: the initial guess; on exit: the new approximate solution
+  @param[in]    max_iter  The maximum number of iterations to perform, even if tolerance is not met.
+  @param[in]    tolerance The stopping criterion to assert convergence: if norm of residual is <= to tolerance.
+  @param[out]   niters    The number of iterations actually performed.
+  @param[out]   normr     The 2-norm of the residual vector after the last iteration, from the recurrence.
+  @param[out]   normr0    The 2-norm of the residual vector before the first iteration.
+  @param[out]   times     The 7-element vector of the timing information accumulated during all of the iterations.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see CG()
+*/
+int CACG(const SparseMatrix & A, CGData & data, CACGData & cadata, const Vector & b, Vector & x,
+    const int max_iter, const double tolerance, int & niters, double & normr, double & normr0,
+    double * times) {
+
+  double t0 = 0.0, t1 = 0.0, t2 = 0.0, t3 = 0.0, t4 = 0.0, t5 = 0.0;
+  double t_begin = mytimer();  // Start timing right away
+
+  const local_int_t nrow = A.localNumberOfRows;
+  const int s = cadata.s;
+  const int m = cadata.m;
+  Vector & r = cadata.W[s+1];
+  Vector & z = cadata.V[s+1];
+  Vector & p = cadata.V[0];
+
+  // r = b - A*x, x has no halo part so the product goes through p
+  TICK(); CopyVector(x, data.p); TOCK(t2);
+  TICK(); ComputeSPMV(A, data.p, data.Ap); TOCK(t3);
+  TICK();
+  double normr_tmp = 0.0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for reduction(+:normr_tmp)
+#endif
+  for (local_int_t i=0; i<nrow; ++i) {
+    r.values[i] = b.values[i] - data.Ap.values[i];
+    normr_tmp += r.values[i]*r.values[i];
+  }
+  TOCK(t2);
+  TICK();
+#ifndef HPCG_NO_MPI
+  CommRequest request;
+  double global_result = 0.0;
+  CommAllreduceSum(&normr_tmp, &global_result, 1, request);
+  CommWait(request);
+  normr_tmp = global_result;
+#endif
+  TOCK(t4);
+  normr = sqrt(normr_tmp);
+  normr0 = normr;
+  double ff = normr/normr0-tolerance*(1.0 + 1e-6);
+
+  TICK(); ApplyPreconditioner(A, cadata, r, z); TOCK(t5);
+  TICK(); CopyVector(z, p); TOCK(t2);
+
+  double * const G = cadata.gram;
+  double * const H = cadata.gram + m*m;
+  double * const localGram = cadata.gram + 2*m*m;
+  double xc[HPCG_CACG_MAX_BASIS], rc[HPCG_CACG_MAX_BASIS], pc[HPCG_CACG_MAX_BASIS], Bp[HPCG_CACG_MAX_BASIS];
+
+  niters = 0;
+  while (niters < max_iter && ff >= DBL_EPSILON) {
+    // Basis of the direction block, V[0..s], and of the residual block, V[s+1..2s]
+    if (cadata.deepHalo) {
+      TICK();
+      ComputeMatrixPowers(A, cadata, 0, s);
+      ComputeMatrixPowers(A, cadata, s+1, s-1);
+      TOCK(t3);
+    } else {
+      for (int i=0; i<s; ++i) {
+        TICK(); NextBasisVector(A, cadata, cadata.V[i], i > 0 ? &cadata.W[i] : 0, cadata.theta[i], cadata.W[i+1]); TOCK(t3);
+        TICK(); ApplyPreconditioner(A, cadata, cadata.W[i+1], cadata.V[i+1]); TOCK(t5);
+      }
+      for (int i=0; i<s-1; ++i) {
+        const int c = s+1+i;
+        TICK(); NextBasisVector(A, cadata, cadata.V[c], &cadata.W[c], cadata.theta[i], cadata.W[c+1]); TOCK(t3);
+        TICK(); ApplyPreconditioner(A, cadata, cadata.W[c+1], cadata.V[c+1]); TOCK(t5);
+      }
+    }
+
+    // The only global reduction of the outer iteration
+    TICK(); ComputeLocalGram(cadata, nrow, localGram); TOCK(t1);
+    TICK();
+#ifndef HPCG_NO_MPI
+    CommAllreduceSum(localGram, G, 2*m*m, request);
+    CommWait(request);
+#else
+    for (int k=0; k<2*m*m; ++k) G[k] = localGram[k];
+#endif
+    TOCK(t4);
+
+    // s iterations of CG on the coefficients
+    TICK();
+    for (int j=0; j<m; ++j) xc[j] = rc[j] = pc[j] = 0.0;
+    pc[0] = 1.0;
+    rc[s+1] = 1.0;
+    double rtz = BilinearForm(m, rc, G, rc);
+    for (int j=0; j<s && niters < max_iter; ++j) {
+      for (int a=0; a<m; ++a) {
+        Bp[a] = 0.0;
+        for (int c=0; c<m; ++c) Bp[a] += cadata.B[a*m+c]*pc[c];
+      }
+      const double pAp = BilinearForm(m, Bp, G, pc);
+      const double alpha = rtz/pAp;
+      for (int a=0; a<m; ++a) {
+        xc[a] += alpha*pc[a];
+        rc[a] -= alpha*Bp[a];
+      }
+      normr = sqrt(fabs(BilinearForm(m, rc, H, rc)));
+      ff = normr/normr0-tolerance;
+      niters++;
+      const double oldrtz = rtz;
+      rtz = BilinearForm(m, rc, G, rc);
+      const double beta = rtz/oldrtz;
+      for (int a=0; a<m; ++a) pc[a] = rc[a] + beta*pc[a];
+#ifdef HPCG_DEBUG
+      if (A.geom->rank==0) HPCG_fout << "Iteration = "<< niters << "   Scaled Residual = "<< normr/normr0 << std::endl;
+#endif
+      if (ff < DBL_EPSILON) break;
+    }
+    TOCK(t1);
+
+    TICK(); CombineBasis(cadata, nrow, xc, rc, pc, x); TOCK(t2);
+  }
+
+  // Store times
+  times[0] += mytimer() - t_begin;  // Total time. All done...
+  times[1] += t1; // Gram matrix and coefficient time
+  times[2] += t2; // vector update time
+  times[3] += t3; // SPMV time
+  times[4] += t4; // AllReduce time
+  times[5] += t5; // preconditioner apply time
+  return 0;
+}
+
+// Reductions, halo exchanges and halo bytes on this rank so far
+static void GetCommunicationCounters(double * counters) {
+  CommThreadStats stats;
+  GetCommThreadStats(stats);
+  counters[0] = (double) stats.reductions;
+  counters[1] = 0.0;
+  counters[2] = 0.0;
+#ifndef HPCG_NO_MPI
+  long long exchanges = 0;
+  GetHaloExchangeStats(exchanges, counters[2]);
+  counters[1] = (double) exchanges;
+#endif
+}
+
+/*!
+  Runs max_iter iterations of the optimized CG and of CA-CG from a zero initial guess and
+  records, for each solver, the time, the global reductions and the halo traffic per iteration.
+  Both solvers use the MG preconditioner, unless the fine level has a deep halo of width s or
+  more: then both run unpreconditioned and CA-CG uses the matrix powers kernel. The results
+  are kept for ReportResults.
+
+  @param[in]    A        The known system matrix
+  @param[inout] data     The CG vectors
+  @param[in]    b        The known right hand side vector
+  @param[inout] x        Work vector, overwritten
+  @param[in]    s        Number of CG iterations per outer iteration of CA-CG
+  @param[in]    max_iter Number of iterations to run with each solver
+
+  @return Returns zero on success and a non-zero value otherwise.
+*/
+int CompareCACG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x, int s, int max_iter) {
+  // With a deep enough ghost region the unpreconditioned solvers are compared, since only
+  // those can build the basis with the matrix powers kernel
+  const struct optData * optData = (const struct optData *) A.optimizationData;
+  const bool matrixPowers = optData != 0 && optData->deepHalo != 0 && optData->deepHalo->width >= s;
+  CACGData cadata;
+  int ierr = InitializeCACGData(A, b, s, !matrixPowers, cadata);
+  if (ierr) return ierr;
+
+  CACGComparison & cmp = cacgComparison;
+  cmp.s = s;
+  cmp.preconditioned = matrixPowers ? 0 : 1;
+  cmp.matrixPowers = matrixPowers ? optData->deepHalo->width : 0;
+  cmp.lambdaMax = cadata.lambdaMax;
+  cmp.iterations = max_iter;
+
+  for (int solver=0; solver<2; ++solver) {
+    std::vector< double > times(9, 0.0);
+    double before[3], after[3];
+    int niters = 0;
+    double normr = 0.0, normr0 = 0.0;
+    ZeroVector(x);
+#ifndef HPCG_NO_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    GetCommunicationCounters(before);
+    if (solver == 0)
+      ierr += CG(A, data, b, x, max_iter, 0.0, niters, normr, normr0, &times[0], !matrixPowers);
+    else
+      ierr += CACG(A, data, cadata, b, x, max_iter, 0.0, niters, normr, normr0, &times[0]);
+    GetCommunicationCounters(after);
+
+    // True residual, the CA-CG norm comes from the coefficient recurrence
+    CopyVector(x, data.p);
+    ComputeSPMV(A, data.p, data.Ap);
+    double localResidual = 0.0, residual = 0.0;
+    for (local_int_t i=0; i<A.localNumberOfRows; ++i) {
+      const double d = b.values[i] - data.Ap.values[i];
+      localResidual += d*d;
+    }
+    residual = localResidual;
+
+    double local[3] = { after[0]-before[0], after[1]-before[1], after[2]-before[2] };
+    double global[3] = { local[0], local[1], local[2] };
+    double time = times[0];
+#ifndef HPCG_NO_MPI
+    MPI_Allreduce(local, global, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&times[0], &time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&localResidual, &residual, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+    const double ranks = A.geom->size;
+    const double iterations = niters > 0 ? niters : 1;
+    cmp.time[solver] = time;
+    cmp.reductions[solver] = global[0]/ranks/iterations;
+    cmp.haloExchanges[solver] = global[1]/ranks/iterations;
+    cmp.haloBytes[solver] = global[2]/ranks/iterations;
+    cmp.scaledResidual[solver] = sqrt(residual)/normr0;
+  }
+
+  DeleteCACGData(cadata);
+  return ierr;
+}
+
+/*!
+  Returns the results of CompareCACG, with s = 0 if it was not run.
+
+  @param[out] comparison The recorded comparison
+*/
+void GetCACGComparison(CACGComparison & comparison) {
+  comparison = cacgComparison;
+  return;
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file CACG.hpp
+
+ HPCG s-step (communication-avoiding) conjugate gradient solver
+ */
+
+#ifndef CACG_HPP
+#define CACG_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+#include "CGData.hpp"
+
+#define HPCG_CACG_MAX_STEPS 8 //!< largest supported number of steps per outer iteration
+
+struct CACGData_STRUCT {
+  int s;                 //!< number of CG iterations per outer iteration
+  int m;                 //!< number of basis vectors, 2*s+1
+  bool preconditioned;   //!< true if the basis is built for the MG preconditioned operator
+  const DeepHalo * deepHalo; //!< ghost region used by the matrix powers kernel, NULL for single layer exchanges
+  double lambdaMax;      //!< estimate of the largest eigenvalue of the (preconditioned) operator
+  double sigma;          //!< scaling of the Newton basis
+  double * theta;        //!< s Newton basis shifts, Leja ordered, theta[0] = 0
+  Vector * V;            //!< m basis vectors: s+1 for the direction, s for the preconditioned residual
+  Vector * W;            //!< A-side basis vectors, W = M*V column by column (W[0] is not formed, W[j] shares V[j] without preconditioning)
+  double * B;            //!< m x m change of basis matrix, A*V[j] = sum_i B[i*m+j]*W[i]
+  double * gram;         //!< 2*m*m entries: W^T V followed by W^T W
+};
+typedef struct CACGData_STRUCT CACGData;
+
+struct CACGComparison_STRUCT {
+  int s;                     //!< number of steps per outer iteration, 0 if no comparison was run
+  int preconditioned;        //!< 1 if both solvers used the MG preconditioner
+  int matrixPowers;          //!< ghost width of the matrix powers kernel, 0 if CA-CG exchanged a single layer per SpMV
+  double lambdaMax;          //!< eigenvalue estimate the basis was built from
+  int iterations;            //!< number of iterations run by each solver
+  double time[2];            //!< solve time of CG and of CA-CG (max over ranks)
+  double reductions[2];      //!< global reductions per iteration
+  double haloExchanges[2];   //!< halo exchanges per iteration and rank, all MG levels
+  double haloBytes[2];       //!< bytes sent by halo exchanges per iteration, averaged over ranks
+  double scaledResidual[2];  //!< final scaled true residual ||b-Ax||/||b||
+};
+typedef struct CACGComparison_STRUCT CACGComparison;
+
+int InitializeCACGData(const SparseMatrix & A, const Vector & b, int s, bool doPreconditioning, CACGData & cadata);
+void DeleteCACGData(CACGData & cadata);
+int CACG(const SparseMatrix & A, CGData & data, CACGData & cadata, const Vector & b, Vector & x,
+    const int max_iter, const double tolerance, int & niters, double & normr, double & normr0,
+    double * times);
+int CompareCACG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x, int s, int max_iter);
+void GetCACGComparison(CACGComparison & comparison);
+
+#endif // CACG_HPP
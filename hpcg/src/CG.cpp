@@ -46,15 +46,78 @@
 #include "ComputeMG.hpp"
 #include "ComputeDotProduct.hpp"
 #include "ComputeWAXPBY.hpp"
+#include "ThreadTeam.hpp"
 
 #ifndef HPCG_NO_MPI
 #include "ExchangeHalo.hpp"
+#include "CommThread.hpp"
 #endif
 
 // Use TICK and TOCK to time a code section in MATLAB-like fashion
 #define TICK()  t0 = mytimer() //!< record current time in 't0'
 #define TOCK(t) t += mytimer() - t0 //!< store time difference in 't' using time in 't0'
 
+// Arguments of the vector kernels of the CG iteration, run through ThreadTeamRun
+struct CGKernelArgs {
+  local_int_t n;
+  double scalar;
+  double * out;
+  const double * in1;
+  const double * in2;
+};
+
+// out = in1, partial sum of in1*in2
+static void CopyDotKernel(int tid, int numberOfThreads, void * args) {
+  const CGKernelArgs * a = (const CGKernelArgs *) args;
+  local_int_t begin, end;
+  ThreadTeamRange(a->n, tid, numberOfThreads, begin, end);
+  double sum = 0.0;
+  for (local_int_t i = begin; i < end; i++) {
+    a->out[i] = a->in1[i];
+    sum += a->in1[i]*a->in2[i];
+  }
+  ThreadTeamPartials()[tid*HPCG_TEAM_PAD] = sum;
+}
+
+// partial sum of in1*in2
+static void DotKernel(int tid, int numberOfThreads, void * args) {
+  const CGKernelArgs * a = (const CGKernelArgs *) args;
+  local_int_t begin, end;
+  ThreadTeamRange(a->n, tid, numberOfThreads, begin, end);
+  double sum = 0.0;
+  for (local_int_t i = begin; i < end; i++) sum += a->in1[i]*a->in2[i];
+  ThreadTeamPartials()[tid*HPCG_TEAM_PAD] = sum;
+}
+
+// out = scalar*out + in1
+static void ScaleAddKernel(int tid, int numberOfThreads, void * args) {
+  const CGKernelArgs * a = (const CGKernelArgs *) args;
+  local_int_t begin, end;
+  ThreadTeamRange(a->n, tid, numberOfThreads, begin, end);
+  for (local_int_t i = begin; i < end; i++) a->out[i] = a->scalar*a->out[i] + a->in1[i];
+}
+
+// out += scalar*in1
+static void AxpyKernel(int tid, int numberOfThreads, void * args) {
+  const CGKernelArgs * a = (const CGKernelArgs *) args;
+  local_int_t begin, end;
+  ThreadTeamRange(a->n, tid, numberOfThreads, begin, end);
+  for (local_int_t i = begin; i < end; i++) a->out[i] += a->scalar*a->in1[i];
+}
+
+// out += scalar*in1, partial sum of out*out
+static void AxpyNormKernel(int tid, int numberOfThreads, void * args) {
+  const CGKernelArgs * a = (const CGKernelArgs *) args;
+  local_int_t begin, end;
+  ThreadTeamRange(a->n, tid, numberOfThreads, begin, end);
+  double sum = 0.0;
+  for (local_int_t i = begin; i < end; i++) {
+    a->out[i] += a->scalar*a->in1[i];
+    sum += a->out[i]*a->out[i];
+  }
+  ThreadTeamPartials()[tid*HPCG_TEAM_PAD] = sum;
+}
+
 /*!
   Routine to compute an approximate solution to Ax = b
 
@@ -87,10 +150,9 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
     double t_begin = mytimer();  // Start timing right away
 
 #ifndef HPCG_NO_MPI
-    MPI_Request *request = new MPI_Request();
+    CommRequest request;
 #endif
     normr = 0.0;
-    local_int_t nthr = A.nproc;
     local_int_t nrow = A.localNumberOfRows;
     Vector & r = data.r; // Residual vector
     Vector & z = data.z; // Preconditioned residual vector
@@ -109,19 +171,15 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
     double normr_tmp = 0.0;
 
     TICK();
-    #ifndef HPCG_NO_OPENMP
-    #pragma omp parallel for num_threads(nthr) reduction(+:normr_tmp)
-    #endif
-    for ( local_int_t i = 0; i < nrow; ++i )
-    {
-        r.values[i] = b.values[i];
-        normr_tmp += r.values [i] * r.values [i];
-    }
+    CGKernelArgs args = { nrow, 0.0, r.values, b.values, b.values };
+    ThreadTeamRun(CopyDotKernel, &args); // r = b
+    normr_tmp = ThreadTeamSumPartials();
     TOCK(t2);
     TICK();
 #ifndef HPCG_NO_MPI
     double global_result = 0.0;
-    MPI_Allreduce(&normr_tmp, &global_result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    CommAllreduceSum(&normr_tmp, &global_result, 1, request);
+    CommWait(request);
     normr_tmp = global_result;
 #endif
     normr = sqrt(normr_tmp);
@@ -154,20 +212,17 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
 
         if (k == 1) {
             TICK();
-            normr_tmp = 0.0;
-            #ifndef HPCG_NO_OPENMP
-            #pragma omp parallel for reduction(+:normr_tmp)
-            #endif
-            for ( local_int_t i = 0; i < nrow; i++ )
-            {
-                p.values[i] = z.values[i];
-                normr_tmp += r.values[i]*z.values[i];
-            }
+            args.out = p.values;
+            args.in1 = z.values;
+            args.in2 = r.values;
+            ThreadTeamRun(CopyDotKernel, &args); // p = z
+            normr_tmp = ThreadTeamSumPartials();
             TOCK(t2);
             TICK();
 #ifndef HPCG_NO_MPI
             global_result = 0.0;
-            MPI_Allreduce(&normr_tmp, &global_result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            CommAllreduceSum(&normr_tmp, &global_result, 1, request);
+            CommWait(request);
             rtz = global_result;
 #else
             rtz = normr_tmp;
@@ -176,17 +231,16 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
         } else {
             TICK();
             oldrtz = rtz;
-            normr_tmp = 0.0;
-            #ifndef HPCG_NO_OPENMP
-            #pragma omp parallel for reduction(+:normr_tmp)
-            #endif
-            for ( local_int_t i = 0; i < nrow; i++ )
-                normr_tmp += r.values[i]*z.values[i];
+            args.in1 = r.values;
+            args.in2 = z.values;
+            ThreadTeamRun(DotKernel, &args);
+            normr_tmp = ThreadTeamSumPartials();
             TOCK(t1);
             TICK();
 #ifndef HPCG_NO_MPI
             global_result = 0.0;
-            MPI_Allreduce(&normr_tmp, &global_result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            CommAllreduceSum(&normr_tmp, &global_result, 1, request);
+            CommWait(request);
             rtz = global_result;
 #else
             rtz = normr_tmp;
@@ -194,13 +248,10 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
             beta = rtz/oldrtz;
             TOCK(t4);
             TICK();
-            #ifndef HPCG_NO_OPENMP
-            #pragma omp parallel for
-            #endif
-            for ( local_int_t i = 0; i < nrow; i++ )
-            {
-                p.values[i] = beta*p.values[i] + z.values[i];
-            }
+            args.scalar = beta;
+            args.out = p.values;
+            args.in1 = z.values;
+            ThreadTeamRun(ScaleAddKernel, &args); // p = beta*p + z
             TOCK(t2);
         }
 
@@ -211,7 +262,8 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
             TICK();
 #ifndef HPCG_NO_MPI
             global_result = 0.0;
-            MPI_Allreduce(&normr_tmp, &global_result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            CommAllreduceSum(&normr_tmp, &global_result, 1, request);
+            CommWait(request);
             pAp = global_result;
 #else
             pAp = normr_tmp;
@@ -234,32 +286,25 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
 
         TICK();
         alpha = rtz/pAp;
-        normr_tmp = 0.0;
-        #ifndef HPCG_NO_OPENMP
-        #pragma omp parallel for reduction(+:normr_tmp)
-        #endif
-        for ( local_int_t i = 0; i < nrow; i++ )
-        {
-            r.values[i] -= alpha * Ap.values[i];
-            normr_tmp += r.values[i]*r.values[i];
-        }
+        args.scalar = -alpha;
+        args.out = r.values;
+        args.in1 = Ap.values;
+        ThreadTeamRun(AxpyNormKernel, &args);
+        normr_tmp = ThreadTeamSumPartials();
         TOCK(t2);// r = r - alpha*Ap
 
         TICK();
 #ifndef HPCG_NO_MPI
         global_result = 0.0;
-        MPI_Iallreduce(&normr_tmp, &global_result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, (MPI_Request *)request);
+        CommAllreduceSum(&normr_tmp, &global_result, 1, request);
 #endif
 
-        #ifndef HPCG_NO_OPENMP
-        #pragma omp parallel for
-        #endif
-        for ( local_int_t i = 0; i < nrow; i++ )
-        {
-            x.values[i] += alpha *  p.values[i];
-        }
+        args.scalar = alpha;
+        args.out = x.values;
+        args.in1 = p.values;
+        ThreadTeamRun(AxpyKernel, &args); // x = x + alpha*p
 #ifndef HPCG_NO_MPI
-        MPI_Wait((MPI_Request *)request, MPI_STATUS_IGNORE);
+        CommWait(request);
         normr_tmp = global_result;
 #endif
 
@@ -281,9 +326,6 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
     times[4] += t4; // AllReduce time
     times[5] += t5; // preconditioner apply time
 
-#ifndef HPCG_NO_MPI
-    delete (MPI_Request *)request;
-#endif
 #endif
     return 0;
 }
@@ -39,14 +39,16 @@
 #include <omp.h>
 #endif
 
-#if defined(HPCG_DEBUG) || defined(HPCG_DETAILED_DEBUG)
 #include <fstream>
 using std::endl;
 #include "hpcg.hpp"
-#endif
 #include <cassert>
+#include <algorithm>
+#include <climits>
 
 #include "CheckProblem.hpp"
+#include "RowIndexing.hpp"
+#include "mytimer.hpp"
 
 
 /*!
@@ -97,9 +99,9 @@ void CheckProblem(const SparseMatrix & A, Vector * b, Vector * x, Vector * xexac
         global_int_t gix = gix0+ix;
         local_int_t currentLocalRow = iz*nx*ny+iy*nx+ix;
         global_int_t currentGlobalRow = giz*gnx*gny+giy*gnx+gix;
-        assert(A.localToGlobalMap[currentLocalRow] == currentGlobalRow);
+        assert(GlobalRowOfLocalRow(A, currentLocalRow) == currentGlobalRow);
 #ifdef HPCG_DETAILED_DEBUG
-        HPCG_fout << " rank, globalRow, localRow = " << A.geom->rank << " " << currentGlobalRow << " " << A.globalToLocalMap.find(currentGlobalRow)->second << endl;
+        HPCG_fout << " rank, globalRow, localRow = " << A.geom->rank << " " << currentGlobalRow << " " << LocalRowOfGlobalRow(A, currentGlobalRow) << endl;
 #endif
         char numberOfNonzerosInRow = 0;
         double * currentValuePointer = A.matrixValues[currentLocalRow]; // Pointer to current value in current row
@@ -162,3 +164,521 @@ void CheckProblem(const SparseMatrix & A, Vector * b, Vector * x, Vector * xexac
 
   return;
 }
+
+static int checkProblemMode = HPCG_CHECK_REFERENCE;
+static double checkProblemTime = 0.0;
+static double checkOptimizedTime = 0.0;
+
+// What a mismatch was found in
+#define CHECK_ROW_LENGTH      0
+#define CHECK_HALO_LENGTH     1
+#define CHECK_COLUMN          2
+#define CHECK_NEIGHBOR        3
+#define CHECK_DUPLICATE       4
+#define CHECK_VALUE           5
+#define CHECK_DIAGONAL        6
+#define CHECK_RHS             7
+#define CHECK_INITIAL_GUESS   8
+#define CHECK_EXACT_SOLUTION  9
+#define CHECK_HALO_ROW       10
+#define CHECK_ITEMS          11
+
+static const char * checkItemName[CHECK_ITEMS] = { "row length", "halo row length", "column", "column",
+  "column", "value", "diagonal", "right hand side", "initial guess", "exact solution", "halo block row" };
+// Items without a single expected value are reported with the offending value only
+static const char * checkItemReason[CHECK_ITEMS] = { NULL, NULL, NULL, "not a stencil neighbor of the row",
+  "listed twice", NULL, NULL, NULL, NULL, NULL, "not a local row in increasing order" };
+
+/*!
+  First mismatch found by a check. Rows are compared by global number, so every thread and rank
+  can keep its own and the smallest one wins.
+*/
+struct CheckMismatch {
+  global_int_t row; //!< global row of the mismatch, -1 while none was found
+  int entry;        //!< position inside the row, -1 for per-row items
+  int item;         //!< one of the CHECK_* values above
+  double expected;  //!< value the row should hold
+  double found;     //!< value the row holds
+};
+
+static inline void RecordMismatch(CheckMismatch & m, global_int_t row, int entry, int item, double expected, double found) {
+  if (m.row >= 0 && m.row <= row) return;
+  m.row = row;
+  m.entry = entry;
+  m.item = item;
+  m.expected = expected;
+  m.found = found;
+  return;
+}
+
+/*!
+  Agrees on the mismatch with the smallest global row over all ranks and has rank 0 report it.
+
+  @return 0 if no rank found a mismatch, 1 otherwise, on every rank
+*/
+static int ReportMismatch(const Geometry & geom, int level, const char * stage, const CheckMismatch & m) {
+  long long row = m.row < 0 ? -1 : (long long) m.row;
+  int owner = geom.rank;
+  double details[4] = { (double) m.entry, (double) m.item, m.expected, m.found };
+#ifndef HPCG_NO_MPI
+  long long localRow = (row < 0) ? LLONG_MAX : row;
+  MPI_Allreduce(&localRow, &row, 1, MPI_LONG_LONG_INT, MPI_MIN, MPI_COMM_WORLD);
+  if (row == LLONG_MAX) return 0;
+  int candidate = (m.row >= 0 && (long long) m.row == row) ? geom.rank : geom.size;
+  MPI_Allreduce(&candidate, &owner, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Bcast(details, 4, MPI_DOUBLE, owner, MPI_COMM_WORLD);
+#else
+  if (row < 0) return 0;
+#endif
+  if (geom.rank == 0) {
+    const int item = (int) details[1];
+    HPCG_fout << "CheckProblem: " << stage << " level " << level << " differs at global row " << row
+              << " (rank " << owner;
+    if (details[0] >= 0.0) HPCG_fout << ", entry " << (int) details[0];
+    HPCG_fout << "): " << checkItemName[item] << " is " << details[3];
+    if (checkItemReason[item] != NULL) HPCG_fout << ", " << checkItemReason[item] << endl;
+    else HPCG_fout << ", expected " << details[2] << endl;
+  }
+  return 1;
+}
+
+/*!
+  Compares the local and global nonzero counts of a level with the ones recorded in the matrix.
+
+  @return 0 if both match, 1 otherwise, on every rank
+*/
+static int CheckNonzeroCount(const SparseMatrix & A, int level, const char * stage, local_int_t localNumberOfNonzeros) {
+  int localError = (localNumberOfNonzeros != A.localNumberOfNonzeros), ierr = localError;
+  long long gnnz = localNumberOfNonzeros;
+#ifndef HPCG_NO_MPI
+  long long lnnz = localNumberOfNonzeros;
+  MPI_Allreduce(&lnnz, &gnnz, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  if (gnnz != (long long) A.totalNumberOfNonzeros) ierr = 1;
+  if (ierr && A.geom->rank == 0)
+    HPCG_fout << "CheckProblem: " << stage << " level " << level << " holds " << gnnz
+              << " nonzeros, the matrix records " << A.totalNumberOfNonzeros << endl;
+  return ierr;
+}
+
+/*!
+  Selects how CheckGeneratedProblem and CheckOptimizedProblem verify the levels.
+
+  @param[in] mode One of HPCG_CHECK_REFERENCE, HPCG_CHECK_FAST or HPCG_CHECK_OPTIMIZED.
+                  Unknown values select HPCG_CHECK_REFERENCE.
+*/
+void InitializeCheckProblem(int mode) {
+  if (mode < HPCG_CHECK_REFERENCE || mode > HPCG_CHECK_OPTIMIZED) mode = HPCG_CHECK_REFERENCE;
+  checkProblemMode = mode;
+  return;
+}
+
+/*!
+  Full check of one generated row: the columns, values and diagonal pointer are derived again
+  from the stencil, in the order GenerateProblem emits them.
+
+  @return true if the row is correct, false after recording the first mismatch in m
+*/
+static bool CheckGeneratedRow(const SparseMatrix & A, local_int_t row, global_int_t gix, global_int_t giy, global_int_t giz,
+    int expectedLength, CheckMismatch & m) {
+  const global_int_t gnx = A.geom->gnx, gny = A.geom->gny, gnz = A.geom->gnz;
+  const global_int_t globalRow = (giz*gny+giy)*gnx+gix;
+  const int length = A.nonzerosInRow[row];
+  if (length != expectedLength) {
+    RecordMismatch(m, globalRow, -1, CHECK_ROW_LENGTH, expectedLength, length);
+    return false;
+  }
+  const double * values = A.matrixValues[row];
+  const global_int_t * columns = A.mtxIndG[row];
+  int k = 0;
+  for (int sz=-1; sz<=1; sz++) {
+    if (giz+sz<0 || giz+sz>=gnz) continue;
+    for (int sy=-1; sy<=1; sy++) {
+      if (giy+sy<0 || giy+sy>=gny) continue;
+      for (int sx=-1; sx<=1; sx++) {
+        if (gix+sx<0 || gix+sx>=gnx) continue;
+        const global_int_t column = globalRow+sz*gnx*gny+sy*gnx+sx;
+        const double value = (column==globalRow) ? 26.0 : -1.0;
+        if (columns[k] != column) {
+          RecordMismatch(m, globalRow, k, CHECK_COLUMN, (double) column, (double) columns[k]);
+          return false;
+        }
+        if (values[k] != value) {
+          RecordMismatch(m, globalRow, k, CHECK_VALUE, value, values[k]);
+          return false;
+        }
+        if (column==globalRow && A.matrixDiagonal[row] != values+k) {
+          RecordMismatch(m, globalRow, k, CHECK_DIAGONAL, value, *A.matrixDiagonal[row]);
+          return false;
+        }
+        k++;
+      }
+    }
+  }
+  return true;
+}
+
+/*!
+  Checks the vectors of the fine level at one row.
+
+  @return true if the row is correct, false after recording the first mismatch in m
+*/
+static inline bool CheckVectorRow(const double * bv, const double * xv, const double * xexactv, local_int_t row,
+    global_int_t globalRow, int expectedLength, CheckMismatch & m) {
+  if (bv != 0 && bv[row] != 26.0 - ((double) (expectedLength-1))) {
+    RecordMismatch(m, globalRow, -1, CHECK_RHS, 26.0 - ((double) (expectedLength-1)), bv[row]);
+    return false;
+  }
+  if (xv != 0 && xv[row] != 0.0) {
+    RecordMismatch(m, globalRow, -1, CHECK_INITIAL_GUESS, 0.0, xv[row]);
+    return false;
+  }
+  if (xexactv != 0 && xexactv[row] != 1.0) {
+    RecordMismatch(m, globalRow, -1, CHECK_EXACT_SOLUTION, 1.0, xexactv[row]);
+    return false;
+  }
+  return true;
+}
+
+/*!
+  Fast check of a generated level. Rows away from the global boundary hold the full 27-point
+  stencil, so their global columns minus the row and their values are compared with one fixed
+  pattern; the comparison is an OR-reduction over the row that vectorizes. The other rows, and
+  interior rows that fail the comparison, are re-derived entry by entry. Threads stop at their
+  first mismatch and the smallest one over all ranks is reported.
+
+  @return 0 if the level is correct, 1 otherwise, on every rank
+*/
+static int CheckGeneratedProblemFast(const SparseMatrix & A, int level, Vector * b, Vector * x, Vector * xexact) {
+  const local_int_t nx = A.geom->nx, ny = A.geom->ny, nz = A.geom->nz;
+  const global_int_t gnx = A.geom->gnx, gny = A.geom->gny, gnz = A.geom->gnz;
+  const global_int_t gix0 = A.geom->gix0, giy0 = A.geom->giy0, giz0 = A.geom->giz0;
+  const double * bv = (b!=0) ? b->values : 0;
+  const double * xv = (x!=0) ? x->values : 0;
+  const double * xexactv = (xexact!=0) ? xexact->values : 0;
+
+  // Column offsets and values of an interior row, in the order GenerateProblem emits them
+  global_int_t stencil[27];
+  double pattern[27];
+  for (int k=0; k<27; k++) {
+    stencil[k] = (k/9-1)*gnx*gny + (k/3%3-1)*gnx + (k%3-1);
+    pattern[k] = (k==13) ? 26.0 : -1.0;
+  }
+
+  CheckMismatch first = { -1, 0, 0, 0.0, 0.0 };
+  int failed = 0;
+  local_int_t localNumberOfNonzeros = 0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel reduction(+:localNumberOfNonzeros)
+#endif
+  {
+    CheckMismatch mine = { -1, 0, 0, 0.0, 0.0 };
+#ifndef HPCG_NO_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for (local_int_t line=0; line<ny*nz; line++) {
+      int stop;
+#ifndef HPCG_NO_OPENMP
+      #pragma omp atomic read
+#endif
+      stop = failed;
+      if (stop) continue;
+      const global_int_t giz = giz0+line/ny, giy = giy0+line%ny;
+      const int extentZY = (1+(giz>0)+(giz<gnz-1))*(1+(giy>0)+(giy<gny-1));
+      const bool interiorLine = (extentZY==9);
+      for (local_int_t ix=0; ix<nx; ix++) {
+        const local_int_t row = line*nx+ix;
+        const global_int_t gix = gix0+ix;
+        const global_int_t globalRow = (giz*gny+giy)*gnx+gix;
+        const int expectedLength = extentZY*(1+(gix>0)+(gix<gnx-1));
+        localNumberOfNonzeros += A.nonzerosInRow[row];
+        bool ok = false;
+        if (interiorLine && expectedLength==27 && A.nonzerosInRow[row]==27) {
+          const double * values = A.matrixValues[row];
+          const global_int_t * columns = A.mtxIndG[row];
+          global_int_t columnDiff = 0;
+          int valueDiff = 0;
+#ifndef HPCG_NO_OPENMP
+          #pragma omp simd reduction(|:columnDiff,valueDiff)
+#endif
+          for (int k=0; k<27; k++) {
+            columnDiff |= (columns[k]-globalRow) ^ stencil[k];
+            valueDiff |= (values[k] != pattern[k]);
+          }
+          ok = (columnDiff==0 && valueDiff==0 && A.matrixDiagonal[row]==values+13);
+        }
+        if (!ok) ok = CheckGeneratedRow(A, row, gix, giy, giz, expectedLength, mine);
+        if (ok) ok = CheckVectorRow(bv, xv, xexactv, row, globalRow, expectedLength, mine);
+        if (!ok) {
+#ifndef HPCG_NO_OPENMP
+          #pragma omp atomic write
+#endif
+          failed = 1;
+          break;
+        }
+      }
+    }
+    if (mine.row >= 0) {
+#ifndef HPCG_NO_OPENMP
+      #pragma omp critical
+#endif
+      RecordMismatch(first, mine.row, mine.entry, mine.item, mine.expected, mine.found);
+    }
+  }
+
+  int ierr = ReportMismatch(*A.geom, level, "generated", first);
+  if (ierr == 0) ierr = CheckNonzeroCount(A, level, "generated", localNumberOfNonzeros);
+  return ierr;
+}
+
+/*!
+  Checks a generated level of the problem, before OptimizeProblem, with the method selected
+  in InitializeCheckProblem.
+
+  @param[in]    A      The matrix of the level
+  @param[in]    level  The level number, 0 for the fine grid, used in the report
+  @param[inout] b      The right hand side vector, or 0 on coarse levels
+  @param[inout] x      The initial guess, or 0 on coarse levels
+  @param[inout] xexact The exact solution, or 0 on coarse levels
+
+  @return 0 if the level is correct (always for the reference check, which asserts), 1 otherwise
+
+  @see CheckProblem
+*/
+int CheckGeneratedProblem(const SparseMatrix & A, int level, Vector * b, Vector * x, Vector * xexact) {
+  double t0 = mytimer();
+  int ierr = 0;
+  if (checkProblemMode == HPCG_CHECK_REFERENCE) CheckProblem(A, b, x, xexact);
+  else ierr = CheckGeneratedProblemFast(A, level, b, x, xexact);
+  checkProblemTime += mytimer() - t0;
+  return ierr;
+}
+
+#ifndef HPCG_LOCAL_LONG_LONG
+/*!
+  Full check of one row of the optimized CSR arrays. The local columns are mapped back to
+  grid points of this rank through the local ordering; together they must be the distinct
+  stencil neighbors inside the box of the rank, and the halo block must hold the remaining
+  neighbors of the row.
+
+  @return true if the row is correct, false after recording the first mismatch in m
+*/
+static bool CheckOptimizedRow(const SparseMatrix & A, const OptimizedCsr & csr, const struct optData & optData,
+    local_int_t row, local_int_t haloLength, CheckMismatch & m) {
+  const Geometry & geom = *A.geom;
+  const local_int_t nx = geom.nx, ny = geom.ny, nz = geom.nz;
+  const local_int_t generated = (optData.localOrder != NULL) ? optData.localOrder[row] : row;
+  const local_int_t ix = generated%nx, iy = generated/nx%ny, iz = generated/(nx*ny);
+  const global_int_t gix = geom.gix0+ix, giy = geom.giy0+iy, giz = geom.giz0+iz;
+  const global_int_t globalRow = LocalToGlobalRow(geom, generated);
+
+  const int length = (1+(gix>0)+(gix<geom.gnx-1))*(1+(giy>0)+(giy<geom.gny-1))*(1+(giz>0)+(giz<geom.gnz-1));
+  const int localLength = (1+(ix>0)+(ix<nx-1))*(1+(iy>0)+(iy<ny-1))*(1+(iz>0)+(iz<nz-1));
+  if (csr.ia[row+1]-csr.ia[row] != localLength) {
+    RecordMismatch(m, globalRow, -1, CHECK_ROW_LENGTH, localLength, csr.ia[row+1]-csr.ia[row]);
+    return false;
+  }
+  if (haloLength != length-localLength) {
+    RecordMismatch(m, globalRow, -1, CHECK_HALO_LENGTH, length-localLength, haloLength);
+    return false;
+  }
+  if (optData.diag[row] != 26.0) {
+    RecordMismatch(m, globalRow, -1, CHECK_DIAGONAL, 26.0, optData.diag[row]);
+    return false;
+  }
+  int seen = 0; // one bit per stencil position
+  for (local_int_t p=csr.ia[row]; p<csr.ia[row+1]; p++) {
+    const int entry = p-csr.ia[row];
+    const local_int_t column = csr.ja[p];
+    if (column < 0 || column >= csr.nrow) {
+      RecordMismatch(m, globalRow, entry, CHECK_NEIGHBOR, 0.0, column);
+      return false;
+    }
+    const local_int_t c = (optData.localOrder != NULL) ? optData.localOrder[column] : column;
+    const local_int_t dx = c%nx-ix, dy = c/nx%ny-iy, dz = c/(nx*ny)-iz;
+    if (dx < -1 || dx > 1 || dy < -1 || dy > 1 || dz < -1 || dz > 1) {
+      RecordMismatch(m, globalRow, entry, CHECK_NEIGHBOR, 0.0, (double) LocalToGlobalRow(geom, c));
+      return false;
+    }
+    const int position = (dz+1)*9+(dy+1)*3+(dx+1);
+    if (seen & (1<<position)) {
+      RecordMismatch(m, globalRow, entry, CHECK_DUPLICATE, 0.0, (double) LocalToGlobalRow(geom, c));
+      return false;
+    }
+    seen |= 1<<position;
+    const double value = (position==13) ? 26.0 : -1.0;
+    if (csr.a[p] != value) {
+      RecordMismatch(m, globalRow, entry, CHECK_VALUE, value, csr.a[p]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+  Checks a level after OptimizeProblem against the CSR arrays behind its MKL handles, which
+  OptimizeProblem keeps when RetainOptimizedCsr was called. Rows of the box interior in the
+  natural ordering are compared with one fixed pattern of local column offsets, the others
+  are checked entry by entry; the halo block must hold the remaining neighbors of each row,
+  with halo columns and values of -1. Catches corruption of the layout OptimizeProblem built,
+  including the renumbering of --local-order.
+
+  @param[in] A      The matrix of the level, after OptimizeProblem
+  @param[in] level  The level number, 0 for the fine grid, used in the report
+  @param[in] b      The right hand side vector in the optimized ordering, or 0
+  @param[in] x      The initial guess in the optimized ordering, or 0
+  @param[in] xexact The exact solution in the optimized ordering, or 0
+
+  @return 0 if the level is correct or not checked in the selected mode, 1 otherwise
+*/
+int CheckOptimizedProblem(const SparseMatrix & A, int level, const Vector * b, const Vector * x, const Vector * xexact) {
+  if (checkProblemMode != HPCG_CHECK_OPTIMIZED) return 0;
+  double t0 = mytimer();
+  const struct optData * optData = (const struct optData *) A.optimizationData;
+  int localError = (optData == NULL || optData->csr == NULL);
+  if (!localError) localError = (optData->csr->nrow != A.localNumberOfRows || optData->csr->ncol != A.localNumberOfColumns
+                                 || optData->csr->nrow_b != optData->nrow_b);
+  int ierr = localError;
+#ifndef HPCG_NO_MPI
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  if (ierr) {
+    if (A.geom->rank == 0)
+      HPCG_fout << "CheckProblem: optimized level " << level << " kept no CSR arrays of the size of the level" << endl;
+    checkOptimizedTime += mytimer() - t0;
+    return ierr;
+  }
+
+  const OptimizedCsr & csr = *optData->csr;
+  const Geometry & geom = *A.geom;
+  const local_int_t nx = geom.nx, ny = geom.ny, nz = geom.nz;
+  const local_int_t nrow = csr.nrow;
+  const double * bv = (b!=0) ? b->values : 0;
+  const double * xv = (x!=0) ? x->values : 0;
+  const double * xexactv = (xexact!=0) ? xexact->values : 0;
+
+  // Local column offsets of a row of the box interior in the natural ordering
+  local_int_t stencil[27];
+  double pattern[27];
+  for (int k=0; k<27; k++) {
+    stencil[k] = (k/9-1)*nx*ny + (k/3%3-1)*nx + (k%3-1);
+    pattern[k] = (k==13) ? 26.0 : -1.0;
+  }
+
+  CheckMismatch first = { -1, 0, 0, 0.0, 0.0 };
+  int failed = 0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    CheckMismatch mine = { -1, 0, 0, 0.0, 0.0 };
+    // Halo block: rows listed once each in increasing order, columns in the halo, values -1
+#ifndef HPCG_NO_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for (local_int_t k=0; k<csr.nrow_b; k++) {
+      int stop;
+#ifndef HPCG_NO_OPENMP
+      #pragma omp atomic read
+#endif
+      stop = failed;
+      if (stop) continue;
+      const local_int_t row = optData->bmap[k];
+      if (row < 0 || row >= nrow || (k > 0 && optData->bmap[k-1] >= row)) {
+        const local_int_t previous = (k > 0 && optData->bmap[k-1] >= 0 && optData->bmap[k-1] < nrow) ? optData->bmap[k-1] : 0;
+        RecordMismatch(mine, GlobalRowOfLocalRow(A, previous), -1, CHECK_HALO_ROW, 0.0, row);
+      } else {
+        const global_int_t globalRow = GlobalRowOfLocalRow(A, row);
+        for (local_int_t p=csr.ia_b[k]; p<csr.ia_b[k+1]; p++) {
+          if (csr.ja_b[p] < nrow || csr.ja_b[p] >= csr.ncol) {
+            RecordMismatch(mine, globalRow, p-csr.ia_b[k], CHECK_COLUMN, nrow, csr.ja_b[p]);
+            break;
+          }
+          if (csr.a_b[p] != -1.0) {
+            RecordMismatch(mine, globalRow, p-csr.ia_b[k], CHECK_VALUE, -1.0, csr.a_b[p]);
+            break;
+          }
+        }
+      }
+      if (mine.row >= 0) {
+#ifndef HPCG_NO_OPENMP
+        #pragma omp atomic write
+#endif
+        failed = 1;
+      }
+    }
+
+    // Local block and vectors, row by row
+#ifndef HPCG_NO_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for (local_int_t row=0; row<nrow; row++) {
+      int stop;
+#ifndef HPCG_NO_OPENMP
+      #pragma omp atomic read
+#endif
+      stop = failed;
+      if (stop) continue;
+      const local_int_t * halo = std::lower_bound(optData->bmap, optData->bmap+csr.nrow_b, row);
+      const local_int_t haloRow = halo-optData->bmap;
+      const local_int_t haloLength = (haloRow < csr.nrow_b && *halo == row) ? csr.ia_b[haloRow+1]-csr.ia_b[haloRow] : 0;
+      const local_int_t ix = row%nx, iy = row/nx%ny, iz = row/(nx*ny);
+      bool ok = false;
+      if (optData->localOrder == NULL && haloLength == 0 && csr.ia[row+1]-csr.ia[row] == 27 && optData->diag[row] == 26.0
+          && ix > 0 && ix < nx-1 && iy > 0 && iy < ny-1 && iz > 0 && iz < nz-1) {
+        const local_int_t * columns = csr.ja+csr.ia[row];
+        const double * values = csr.a+csr.ia[row];
+        local_int_t columnDiff = 0;
+        int valueDiff = 0;
+#ifndef HPCG_NO_OPENMP
+        #pragma omp simd reduction(|:columnDiff,valueDiff)
+#endif
+        for (int k=0; k<27; k++) {
+          columnDiff |= (columns[k]-row) ^ stencil[k];
+          valueDiff |= (values[k] != pattern[k]);
+        }
+        ok = (columnDiff==0 && valueDiff==0);
+      }
+      if (!ok) ok = CheckOptimizedRow(A, csr, *optData, row, haloLength, mine);
+      if (ok && (bv != 0 || xv != 0 || xexactv != 0)) {
+        const local_int_t length = csr.ia[row+1]-csr.ia[row]+haloLength;
+        ok = CheckVectorRow(bv, xv, xexactv, row, GlobalRowOfLocalRow(A, row), length, mine);
+      }
+      if (!ok) {
+#ifndef HPCG_NO_OPENMP
+        #pragma omp atomic write
+#endif
+        failed = 1;
+      }
+    }
+    if (mine.row >= 0) {
+#ifndef HPCG_NO_OPENMP
+      #pragma omp critical
+#endif
+      RecordMismatch(first, mine.row, mine.entry, mine.item, mine.expected, mine.found);
+    }
+  }
+
+  ierr = ReportMismatch(geom, level, "optimized", first);
+  if (ierr == 0) ierr = CheckNonzeroCount(A, level, "optimized", csr.ia[nrow]+(csr.nrow_b > 0 ? csr.ia_b[csr.nrow_b] : 0));
+  checkOptimizedTime += mytimer() - t0;
+  return ierr;
+}
+#else
+int CheckOptimizedProblem(const SparseMatrix & A, int level, const Vector * b, const Vector * x, const Vector * xexact) {
+  return 0;
+}
+#endif
+
+/*!
+  Reports the selected check and the time spent in it on this rank.
+
+  @param[out] stats Mode and seconds spent in CheckGeneratedProblem and CheckOptimizedProblem
+*/
+void GetCheckProblemStats(CheckProblemStats & stats) {
+  stats.mode = checkProblemMode;
+  stats.time = checkProblemTime;
+  stats.optimizedTime = checkOptimizedTime;
+  return;
+}
@@ -30,5 +30,20 @@
 #include "SparseMatrix.hpp"
 #include "Vector.hpp"
 
+#define HPCG_CHECK_REFERENCE 0 //!< every row re-derived with asserts, which NDEBUG builds compile out
+#define HPCG_CHECK_FAST      1 //!< pattern check of the interior rows, full check of the boundary rows
+#define HPCG_CHECK_OPTIMIZED 2 //!< fast check, plus the CSR arrays of every level after OptimizeProblem
+
+struct CheckProblemStats_STRUCT {
+  int mode;             //!< one of the HPCG_CHECK_* values
+  double time;          //!< seconds spent checking the generated levels on this rank
+  double optimizedTime; //!< seconds spent checking the optimized levels on this rank
+};
+typedef struct CheckProblemStats_STRUCT CheckProblemStats;
+
 void CheckProblem(const SparseMatrix & A, Vector * b, Vector * x, Vector * xexact);
+void InitializeCheckProblem(int mode);
+int CheckGeneratedProblem(const SparseMatrix & A, int level, Vector * b, Vector * x, Vector * xexact);
+int CheckOptimizedProblem(const SparseMatrix & A, int level, const Vector * b, const Vector * x, const Vector * xexact);
+void GetCheckProblemStats(CheckProblemStats & stats);
 #endif // CHECKPROBLEM_HPP
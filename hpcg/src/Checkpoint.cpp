@@ -0,0 +1,543 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file Checkpoint.cpp
+
+ HPCG routine
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#endif
+
+#include "Checkpoint.hpp"
+#include "GenerateGeometry.hpp"
+#include "LocalOrdering.hpp"
+#include "OptimizeProblem.hpp"
+#include "mytimer.hpp"
+
+#define HPCG_CHECKPOINT_VERSION 2
+#define HPCG_CHECKPOINT_ALIGNMENT 4096 // every section starts on a page, so mapping it faults in only its own pages
+#define HPCG_CHECKPOINT_MAX_LEVELS 8
+
+// Sections of one level, in file order
+#define CKPT_ELEMENTS_TO_SEND 0
+#define CKPT_NEIGHBORS        1
+#define CKPT_RECEIVE_LENGTH   2
+#define CKPT_SEND_LENGTH      3
+#define CKPT_SCOUNTS          4
+#define CKPT_RCOUNTS          5
+#define CKPT_SDISPLS          6
+#define CKPT_RDISPLS          7
+#define CKPT_DIAG             8
+#define CKPT_BMAP             9
+#define CKPT_IA              10
+#define CKPT_JA              11
+#define CKPT_A               12
+#define CKPT_IA_B            13
+#define CKPT_JA_B            14
+#define CKPT_A_B             15
+#define CKPT_F2C             16
+#define CKPT_LOCAL_ORDER     17
+#define CKPT_B               18
+#define CKPT_XEXACT          19
+#define CKPT_SECTIONS        20
+
+struct CheckpointLevel {
+  long long totalNumberOfRows;
+  long long totalNumberOfNonzeros;
+  long long localNumberOfRows;
+  long long localNumberOfColumns;
+  long long localNumberOfNonzeros;
+  long long numberOfExternalValues;
+  long long numberOfSendNeighbors;
+  long long totalToBeSent;
+  long long nrow_b;
+  long long nnz;
+  long long nnz_b;
+  unsigned long long offset[CKPT_SECTIONS];
+  unsigned long long bytes[CKPT_SECTIONS];
+};
+
+struct CheckpointHeader {
+  char magic[8];
+  int version;
+  int numberOfLevels;
+  unsigned long long configHash; //!< hash of everything that determines the contents, see ConfigurationHash
+  unsigned long long fileBytes;
+  CheckpointLevel level[HPCG_CHECKPOINT_MAX_LEVELS];
+};
+
+static const char checkpointMagic[8] = { 'H', 'P', 'C', 'G', 'C', 'K', 'P', 'T' };
+static CheckpointStats checkpointStats = { HPCG_CHECKPOINT_OFF, 0.0, 0.0 };
+
+static unsigned long long RoundUp(unsigned long long bytes) {
+  return (bytes + HPCG_CHECKPOINT_ALIGNMENT - 1)/HPCG_CHECKPOINT_ALIGNMENT*HPCG_CHECKPOINT_ALIGNMENT;
+}
+
+/*
+  FNV-1a hash of the format version, the integer sizes of the build, the local and process grid
+  dimensions of this rank and the options that change the optimized problem.
+*/
+static unsigned long long ConfigurationHash(const Geometry & geom, int numberOfMgLevels) {
+  std::vector<long long> key;
+  key.push_back(HPCG_CHECKPOINT_VERSION);
+  key.push_back(sizeof(local_int_t));
+  key.push_back(sizeof(global_int_t));
+  key.push_back(geom.size);
+  key.push_back(geom.rank);
+  key.push_back(geom.nx);
+  key.push_back(geom.ny);
+  key.push_back(geom.nz);
+  key.push_back(geom.npx);
+  key.push_back(geom.npy);
+  key.push_back(geom.npz);
+  key.push_back(geom.pz);
+  for (int i = 0; i < geom.npartz; i++) {
+    key.push_back(geom.partz_ids[i]);
+    key.push_back(geom.partz_nz[i]);
+  }
+  key.push_back(numberOfMgLevels);
+  key.push_back(UseLocalOrdering() ? 1 : 0);
+
+  unsigned long long hash = 14695981039346656037ULL;
+  const unsigned char * p = (const unsigned char *) &key[0];
+  for (size_t i = 0; i < key.size()*sizeof(long long); i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static void CheckpointPath(const char * directory, const Geometry & geom, char * path, size_t length) {
+  snprintf(path, length, "%s/hpcg-checkpoint.%d.%d.bin", directory, geom.size, geom.rank);
+  return;
+}
+
+// Same coarsening as GenerateCoarseProblem
+static Geometry * CoarseGeometry(const Geometry & geomf) {
+  Geometry * geomc = new Geometry;
+  local_int_t zlc = 0, zuc = 0;
+  if (geomf.pz > 0) {
+    zlc = geomf.partz_nz[0]/2;
+    zuc = geomf.partz_nz[1]/2;
+  }
+  GenerateGeometry(geomf.size, geomf.rank, geomf.numThreads, geomf.pz, zlc, zuc, geomf.nx/2, geomf.ny/2, geomf.nz/2,
+      geomf.npx, geomf.npy, geomf.npz, geomc);
+  return geomc;
+}
+
+#if defined(__linux__) && !defined(HPCG_LOCAL_LONG_LONG)
+static int WriteFully(int fd, const void * data, unsigned long long bytes, unsigned long long offset) {
+  const char * p = (const char *) data;
+  while (bytes > 0) {
+    size_t chunk = (bytes < (1ULL << 30)) ? (size_t) bytes : ((size_t) 1 << 30);
+    ssize_t written = pwrite(fd, p, chunk, (off_t) offset);
+    if (written <= 0) return 1;
+    p += written;
+    bytes -= written;
+    offset += written;
+  }
+  return 0;
+}
+
+// Copies one section into tracked storage, NULL for an empty section
+static void * CopySection(const char * map, const CheckpointLevel & level, int section, int subsystem) {
+  if (level.bytes[section] == 0) return NULL;
+  void * p = TrackedMalloc(level.bytes[section], subsystem);
+  if (p != NULL) memcpy(p, map + level.offset[section], level.bytes[section]);
+  return p;
+}
+
+/*!
+  @return true if CopySection returned NULL for a section that is not empty
+*/
+static bool SectionMissing(const void * p, const CheckpointLevel & level, int section) {
+  return p == NULL && level.bytes[section] > 0;
+}
+
+/*!
+  Releases everything ReadCheckpoint attached to A, coarse levels and MKL handles included,
+  and restores the fine level as it was on entry. The geometry belongs to the caller.
+
+  @param[inout] A         The fine level matrix
+  @param[in]    untouched Copy of A taken on entry
+*/
+static void RollBackCheckpoint(SparseMatrix & A, const SparseMatrix & untouched) {
+  A.geom = NULL;
+  DeleteMatrix(A);
+  A = untouched;
+  return;
+}
+#endif
+
+/*!
+  Writes the snapshot of this rank: geometry key, halo lists, the CSR
+  arrays behind the MKL handles, diagonal, bmap, f2cOperator and local ordering of every level,
+  and the right hand side and exact solution of the fine level. Every section starts on a page
+  boundary and is written with one large write. The file is written under a temporary name and
+  renamed, so a snapshot is either complete or absent.
+
+  Needs the CSR arrays that OptimizeProblem keeps after RetainOptimizedCsr(true); they are
+  released here whether or not the write succeeds.
+
+  @param[in]    directory        Directory of the snapshots, created if missing
+  @param[inout] A                The fine level matrix after OptimizeProblem
+  @param[in]    b                The right hand side in the order of the optimized problem
+  @param[in]    xexact           The exact solution in the order of the optimized problem
+  @param[in]    numberOfMgLevels Number of levels of the hierarchy
+
+  @return Returns zero if every rank wrote its snapshot and a non-zero value otherwise
+
+  @see ReadCheckpoint
+*/
+int WriteCheckpoint(const char * directory, SparseMatrix & A, const Vector & b, const Vector & xexact,
+    int numberOfMgLevels) {
+  double t0 = mytimer();
+  int ierr = 0;
+#if defined(__linux__) && !defined(HPCG_LOCAL_LONG_LONG)
+  CheckpointHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+  header.version = HPCG_CHECKPOINT_VERSION;
+  header.numberOfLevels = numberOfMgLevels;
+  header.configHash = ConfigurationHash(*A.geom, numberOfMgLevels);
+
+  // The compressed index copy is not part of the snapshot
+  if (UseCompressedMatrix() || numberOfMgLevels > HPCG_CHECKPOINT_MAX_LEVELS) ierr = 1;
+
+  std::vector<const void *> data(CKPT_SECTIONS*HPCG_CHECKPOINT_MAX_LEVELS, (const void *) NULL);
+  unsigned long long offset = RoundUp(sizeof(header));
+  const SparseMatrix * Al = &A;
+  for (int l = 0; l < numberOfMgLevels && ierr == 0; l++, Al = Al->Ac) {
+    const struct optData * optData = (Al != NULL) ? (const struct optData *) Al->optimizationData : NULL;
+    if (optData == NULL || optData->csr == NULL) { ierr = 1; break; }
+    const OptimizedCsr & csr = *optData->csr;
+    const local_int_t nrow = Al->localNumberOfRows;
+    CheckpointLevel & level = header.level[l];
+    level.totalNumberOfRows = Al->totalNumberOfRows;
+    level.totalNumberOfNonzeros = Al->totalNumberOfNonzeros;
+    level.localNumberOfRows = nrow;
+    level.localNumberOfColumns = Al->localNumberOfColumns;
+    level.localNumberOfNonzeros = Al->localNumberOfNonzeros;
+    level.nrow_b = csr.nrow_b;
+    level.nnz = csr.nnz;
+    level.nnz_b = csr.nnz_b;
+
+    const void ** section = &data[CKPT_SECTIONS*l];
+#ifndef HPCG_NO_MPI
+    level.numberOfExternalValues = Al->numberOfExternalValues;
+    level.numberOfSendNeighbors = Al->numberOfSendNeighbors;
+    level.totalToBeSent = Al->totalToBeSent;
+    if (Al->geom->size > 1) {
+      const local_int_t neighbors = Al->numberOfSendNeighbors;
+      const local_int_t ranks = Al->geom->size;
+      section[CKPT_ELEMENTS_TO_SEND] = Al->elementsToSend; level.bytes[CKPT_ELEMENTS_TO_SEND] = Al->totalToBeSent*sizeof(local_int_t);
+      section[CKPT_NEIGHBORS] = Al->neighbors;             level.bytes[CKPT_NEIGHBORS] = neighbors*sizeof(int);
+      section[CKPT_RECEIVE_LENGTH] = Al->receiveLength;    level.bytes[CKPT_RECEIVE_LENGTH] = neighbors*sizeof(local_int_t);
+      section[CKPT_SEND_LENGTH] = Al->sendLength;          level.bytes[CKPT_SEND_LENGTH] = neighbors*sizeof(local_int_t);
+      section[CKPT_SCOUNTS] = Al->scounts;                 level.bytes[CKPT_SCOUNTS] = ranks*sizeof(local_int_t);
+      section[CKPT_RCOUNTS] = Al->rcounts;                 level.bytes[CKPT_RCOUNTS] = ranks*sizeof(local_int_t);
+      section[CKPT_SDISPLS] = Al->sdispls;                 level.bytes[CKPT_SDISPLS] = ranks*sizeof(local_int_t);
+      section[CKPT_RDISPLS] = Al->rdispls;                 level.bytes[CKPT_RDISPLS] = ranks*sizeof(local_int_t);
+    }
+#endif
+    section[CKPT_DIAG] = optData->diag;  level.bytes[CKPT_DIAG] = nrow*sizeof(double);
+    section[CKPT_BMAP] = optData->bmap;  level.bytes[CKPT_BMAP] = csr.nrow_b*sizeof(local_int_t);
+    section[CKPT_IA] = csr.ia;           level.bytes[CKPT_IA] = (nrow+1)*sizeof(local_int_t);
+    section[CKPT_JA] = csr.ja;           level.bytes[CKPT_JA] = csr.nnz*sizeof(local_int_t);
+    section[CKPT_A] = csr.a;             level.bytes[CKPT_A] = csr.nnz*sizeof(double);
+    section[CKPT_IA_B] = csr.ia_b;       level.bytes[CKPT_IA_B] = (csr.nrow_b+1)*sizeof(local_int_t);
+    section[CKPT_JA_B] = csr.ja_b;       level.bytes[CKPT_JA_B] = csr.nnz_b*sizeof(local_int_t);
+    section[CKPT_A_B] = csr.a_b;         level.bytes[CKPT_A_B] = csr.nnz_b*sizeof(double);
+    if (Al->mgData != NULL && Al->mgData->f2cOperator != NULL) {
+      section[CKPT_F2C] = Al->mgData->f2cOperator;
+      level.bytes[CKPT_F2C] = Al->Ac->localNumberOfRows*sizeof(local_int_t);
+    }
+    if (optData->localOrder != NULL) {
+      section[CKPT_LOCAL_ORDER] = optData->localOrder;
+      level.bytes[CKPT_LOCAL_ORDER] = nrow*sizeof(local_int_t);
+    }
+    if (l == 0) {
+      section[CKPT_B] = b.values;           level.bytes[CKPT_B] = nrow*sizeof(double);
+      section[CKPT_XEXACT] = xexact.values; level.bytes[CKPT_XEXACT] = nrow*sizeof(double);
+    }
+    for (int s = 0; s < CKPT_SECTIONS; s++) {
+      if (section[s] == NULL) level.bytes[s] = 0;
+      level.offset[s] = offset;
+      offset += RoundUp(level.bytes[s]);
+    }
+  }
+  header.fileBytes = offset;
+
+  if (ierr == 0) {
+    char path[2048], temporary[2100];
+    CheckpointPath(directory, *A.geom, path, sizeof(path));
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    mkdir(directory, 0755);
+    int fd = open(temporary, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) ierr = 1;
+    if (ierr == 0) ierr = WriteFully(fd, &header, sizeof(header), 0);
+    for (int l = 0; l < numberOfMgLevels && ierr == 0; l++)
+      for (int s = 0; s < CKPT_SECTIONS && ierr == 0; s++)
+        if (header.level[l].bytes[s] > 0)
+          ierr = WriteFully(fd, data[CKPT_SECTIONS*l+s], header.level[l].bytes[s], header.level[l].offset[s]);
+    if (ierr == 0 && ftruncate(fd, (off_t) header.fileBytes) != 0) ierr = 1;
+    if (fd >= 0 && close(fd) != 0) ierr = 1;
+    if (ierr == 0 && rename(temporary, path) != 0) ierr = 1;
+    if (ierr != 0) unlink(temporary);
+  }
+
+  ReleaseOptimizedCsr(A);
+  checkpointStats.bytes = (ierr == 0) ? (double) header.fileBytes : 0.0;
+#else
+  ierr = 1;
+#endif
+#ifndef HPCG_NO_MPI
+  int localError = ierr;
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  checkpointStats.status = (ierr == 0) ? HPCG_CHECKPOINT_WRITTEN : HPCG_CHECKPOINT_FAILED;
+  checkpointStats.time = mytimer() - t0;
+  return ierr;
+}
+
+/*!
+  Builds the optimized problem hierarchy from the snapshots written by WriteCheckpoint instead of
+  generating, checking and optimizing it. The file of every rank is mapped; its pages are faulted in
+  as the sections are read, and the CSR sections go to MKL straight from the mapping. The other
+  arrays are copied into tracked storage so that DeleteMatrix releases them as usual.
+
+  Nothing is built unless every rank finds a snapshot whose version and configuration hash match
+  its own geometry and options.
+
+  @param[in]    directory        Directory of the snapshots
+  @param[inout] A                Fine level matrix, initialized with the geometry of this run
+  @param[out]   b                Right hand side in the order of the optimized problem
+  @param[out]   x                Initial guess, zero
+  @param[out]   xexact           Exact solution in the order of the optimized problem
+  @param[in]    numberOfMgLevels Number of levels of the hierarchy
+  @param[out]   t7               Time spent inside MKL creating the handles
+
+  @return Returns zero if the hierarchy was loaded on every rank and a non-zero value otherwise,
+          in which case A, b, x and xexact are unchanged
+
+  @see WriteCheckpoint
+*/
+int ReadCheckpoint(const char * directory, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact,
+    int numberOfMgLevels, double & t7) {
+  double t0 = mytimer();
+  t7 = 0.0;
+  int ierr = 0;
+#if defined(__linux__) && !defined(HPCG_LOCAL_LONG_LONG)
+  char path[2048];
+  CheckpointPath(directory, *A.geom, path, sizeof(path));
+  char * map = NULL;
+  size_t mapBytes = 0;
+  if (UseCompressedMatrix() || numberOfMgLevels > HPCG_CHECKPOINT_MAX_LEVELS) ierr = 1;
+  int fd = (ierr == 0) ? open(path, O_RDONLY) : -1;
+  if (fd < 0) ierr = 1;
+  struct stat st;
+  if (ierr == 0 && (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(CheckpointHeader))) ierr = 1;
+  if (ierr == 0) {
+    mapBytes = st.st_size;
+    // Private writable mapping: pages stay shared with the page cache until something writes to them
+    map = (char *) mmap(NULL, mapBytes, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (map == (char *) MAP_FAILED) { map = NULL; ierr = 1; }
+  }
+  if (fd >= 0) close(fd);
+
+  const CheckpointHeader * header = (const CheckpointHeader *) map;
+  if (ierr == 0) {
+    if (memcmp(header->magic, checkpointMagic, sizeof(checkpointMagic)) != 0 || header->version != HPCG_CHECKPOINT_VERSION
+        || header->numberOfLevels != numberOfMgLevels || header->fileBytes != mapBytes
+        || header->configHash != ConfigurationHash(*A.geom, numberOfMgLevels)) ierr = 1;
+    for (int l = 0; l < numberOfMgLevels && ierr == 0; l++)
+      for (int s = 0; s < CKPT_SECTIONS; s++)
+        if (header->level[l].offset[s] + header->level[l].bytes[s] > mapBytes) ierr = 1;
+  }
+#else
+  ierr = 1;
+#endif
+#ifndef HPCG_NO_MPI
+  int localError = ierr;
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+#if defined(__linux__) && !defined(HPCG_LOCAL_LONG_LONG)
+  if (ierr != 0) {
+    if (map != NULL) munmap(map, mapBytes);
+    checkpointStats.status = HPCG_CHECKPOINT_FAILED;
+    return ierr;
+  }
+
+  // Every rank builds the whole hierarchy and the ranks agree on the outcome before anyone uses it
+  const SparseMatrix untouched = A;
+  std::vector<SparseMatrix *> levels(numberOfMgLevels, (SparseMatrix *) NULL);
+  levels[0] = &A;
+  for (int l = 0; l < numberOfMgLevels && ierr == 0; l++) {
+    const CheckpointLevel & level = header->level[l];
+    if (l > 0) {
+      levels[l] = new SparseMatrix;
+      InitializeSparseMatrix(*levels[l], CoarseGeometry(*levels[l-1]->geom));
+      levels[l]->nproc = A.nproc;
+      levels[l-1]->Ac = levels[l];
+    }
+    SparseMatrix & Al = *levels[l];
+    const local_int_t nrow = (local_int_t) level.localNumberOfRows;
+    Al.totalNumberOfRows = level.totalNumberOfRows;
+    Al.totalNumberOfNonzeros = level.totalNumberOfNonzeros;
+    Al.localNumberOfRows = nrow;
+    Al.localNumberOfColumns = (local_int_t) level.localNumberOfColumns;
+    Al.localNumberOfNonzeros = (local_int_t) level.localNumberOfNonzeros;
+#ifndef HPCG_NO_MPI
+    Al.haloPrecision = NULL;
+    Al.neighborHalo = NULL;
+    Al.rmaHalo = NULL;
+    Al.haloDatatypes = NULL;
+    Al.numberOfExternalValues = (local_int_t) level.numberOfExternalValues;
+    Al.numberOfSendNeighbors = (int) level.numberOfSendNeighbors;
+    Al.totalToBeSent = (local_int_t) level.totalToBeSent;
+    Al.elementsToSend = (local_int_t *) CopySection(map, level, CKPT_ELEMENTS_TO_SEND, HPCG_MEM_HALO);
+    Al.neighbors = (int *) CopySection(map, level, CKPT_NEIGHBORS, HPCG_MEM_HALO);
+    Al.receiveLength = (local_int_t *) CopySection(map, level, CKPT_RECEIVE_LENGTH, HPCG_MEM_HALO);
+    Al.sendLength = (local_int_t *) CopySection(map, level, CKPT_SEND_LENGTH, HPCG_MEM_HALO);
+    Al.scounts = (local_int_t *) CopySection(map, level, CKPT_SCOUNTS, HPCG_MEM_HALO);
+    Al.rcounts = (local_int_t *) CopySection(map, level, CKPT_RCOUNTS, HPCG_MEM_HALO);
+    Al.sdispls = (local_int_t *) CopySection(map, level, CKPT_SDISPLS, HPCG_MEM_HALO);
+    Al.rdispls = (local_int_t *) CopySection(map, level, CKPT_RDISPLS, HPCG_MEM_HALO);
+    if (Al.totalToBeSent > 0) Al.sendBuffer = (double *) TrackedMalloc(sizeof(double)*Al.totalToBeSent, HPCG_MEM_HALO);
+    if (SectionMissing(Al.elementsToSend, level, CKPT_ELEMENTS_TO_SEND) || SectionMissing(Al.neighbors, level, CKPT_NEIGHBORS)
+        || SectionMissing(Al.receiveLength, level, CKPT_RECEIVE_LENGTH) || SectionMissing(Al.sendLength, level, CKPT_SEND_LENGTH)
+        || SectionMissing(Al.scounts, level, CKPT_SCOUNTS) || SectionMissing(Al.rcounts, level, CKPT_RCOUNTS)
+        || SectionMissing(Al.sdispls, level, CKPT_SDISPLS) || SectionMissing(Al.rdispls, level, CKPT_RDISPLS)
+        || (Al.totalToBeSent > 0 && Al.sendBuffer == NULL)) {
+      ierr = 1;
+      break;
+    }
+#endif
+
+    struct optData * optData = (struct optData *) TrackedMalloc(sizeof(struct optData), HPCG_MEM_MATRIX);
+    local_int_t * bmap = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*nrow, HPCG_MEM_MATRIX);
+    double * diag = (double *) CopySection(map, level, CKPT_DIAG, HPCG_MEM_MATRIX);
+    local_int_t * localOrder = (local_int_t *) CopySection(map, level, CKPT_LOCAL_ORDER, HPCG_MEM_MATRIX);
+    if (optData == NULL || bmap == NULL || diag == NULL || SectionMissing(localOrder, level, CKPT_LOCAL_ORDER)) {
+      TrackedFree(optData); TrackedFree(bmap); TrackedFree(diag); TrackedFree(localOrder);
+      ierr = 1;
+      break;
+    }
+    memcpy(bmap, map + level.offset[CKPT_BMAP], level.bytes[CKPT_BMAP]);
+    optData->diag = diag;
+    optData->bmap = bmap;
+    optData->nrow_b = (local_int_t) level.nrow_b;
+    optData->cmat = NULL;
+    optData->deepHalo = NULL;
+    optData->localOrder = localOrder;
+    optData->csr = NULL;
+
+    OptimizedCsr csr = { nrow, Al.localNumberOfColumns, (local_int_t) level.nnz, (local_int_t) level.nrow_b, (local_int_t) level.nnz_b,
+        (local_int_t *) (map + level.offset[CKPT_IA]), (local_int_t *) (map + level.offset[CKPT_JA]), (double *) (map + level.offset[CKPT_A]),
+        (local_int_t *) (map + level.offset[CKPT_IA_B]), (local_int_t *) (map + level.offset[CKPT_JA_B]), (double *) (map + level.offset[CKPT_A_B]),
+        false };
+    // On failure nothing was attached to Al, so the level data is released here
+    if (CreateOptimizedLevel(Al, optData, csr, t7) != 0) {
+      TrackedFree(optData); TrackedFree(bmap); TrackedFree(diag); TrackedFree(localOrder);
+      ierr = 1;
+    }
+  }
+
+  // Grid transfer data, as GenerateCoarseProblem leaves it after OptimizeProblem
+  for (int l = 0; l < numberOfMgLevels-1 && ierr == 0; l++) {
+    const SparseMatrix & Af = *levels[l];
+    const SparseMatrix & Ac = *levels[l+1];
+    Vector * rc = new Vector;
+    Vector * xc = new Vector;
+    Vector * Axf = new Vector;
+    InitializeVector(*rc, Ac.localNumberOfRows, HPCG_MEM_MG);
+    InitializeVector(*xc, Ac.localNumberOfColumns, HPCG_MEM_MG);
+    InitializeVector(*Axf, Af.localNumberOfColumns, HPCG_MEM_MG);
+    local_int_t * f2c = (local_int_t *) CopySection(map, header->level[l], CKPT_F2C, HPCG_MEM_MG);
+    MGData * mgData = new MGData;
+    InitializeMGData(f2c, rc, xc, Axf, *mgData);
+    Af.mgData = mgData;
+    if (rc->values == NULL || xc->values == NULL || Axf->values == NULL || SectionMissing(f2c, header->level[l], CKPT_F2C)) {
+      ierr = 1;
+      break;
+    }
+    ZeroVector(*rc);
+    ZeroVector(*xc);
+    ZeroVector(*Axf);
+  }
+
+#ifndef HPCG_NO_MPI
+  localError = ierr;
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  if (ierr != 0) {
+    RollBackCheckpoint(A, untouched);
+    munmap(map, mapBytes);
+    checkpointStats.status = HPCG_CHECKPOINT_FAILED;
+    return ierr;
+  }
+
+  const local_int_t nrow = A.localNumberOfRows;
+  InitializeVector(b, nrow);
+  InitializeVector(x, nrow);
+  InitializeVector(xexact, nrow);
+  memcpy(b.values, map + header->level[0].offset[CKPT_B], nrow*sizeof(double));
+  memcpy(xexact.values, map + header->level[0].offset[CKPT_XEXACT], nrow*sizeof(double));
+  ZeroVector(x);
+
+  checkpointStats.bytes = (double) mapBytes;
+  munmap(map, mapBytes);
+  checkpointStats.status = HPCG_CHECKPOINT_LOADED;
+  checkpointStats.time = mytimer() - t0;
+#endif
+  return ierr;
+}
+
+/*!
+  Reports whether this run wrote or loaded a snapshot, its size on this rank and the time spent.
+
+  @param[out] stats Snapshot statistics of this rank
+*/
+void GetCheckpointStats(CheckpointStats & stats) {
+  stats = checkpointStats;
+  return;
+}
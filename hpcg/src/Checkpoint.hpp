@@ -0,0 +1,59 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file Checkpoint.hpp
+
+ HPCG per-rank binary snapshot of the optimized problem hierarchy
+ */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "Geometry.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+#define HPCG_CHECKPOINT_OFF     0 //!< no --checkpoint directory given
+#define HPCG_CHECKPOINT_WRITTEN 1 //!< the problem was generated and a snapshot written
+#define HPCG_CHECKPOINT_LOADED  2 //!< the problem was mapped from a snapshot
+#define HPCG_CHECKPOINT_FAILED  3 //!< a directory was given but no snapshot could be read or written
+
+struct CheckpointStats_STRUCT {
+  int status;   //!< one of the HPCG_CHECKPOINT_* values
+  double bytes; //!< size of the snapshot of this rank
+  double time;  //!< seconds spent writing or loading the snapshot on this rank
+};
+typedef struct CheckpointStats_STRUCT CheckpointStats;
+
+int ReadCheckpoint(const char * directory, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact,
+    int numberOfMgLevels, double & t7);
+int WriteCheckpoint(const char * directory, SparseMatrix & A, const Vector & b, const Vector & xexact,
+    int numberOfMgLevels);
+void GetCheckpointStats(CheckpointStats & stats);
+
+#endif // CHECKPOINT_HPP
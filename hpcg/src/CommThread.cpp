@@ -0,0 +1,280 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file CommThread.cpp
+
+ HPCG routine
+ */
+
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__linux__) && !defined(HPCG_NO_OPENMP)
+#include <pthread.h>
+#include <sched.h>
+#define HPCG_COMM_AFFINITY
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMM_PAUSE() _mm_pause()
+#else
+#define COMM_PAUSE()
+#endif
+
+#include "CommThread.hpp"
+#include "mytimer.hpp"
+
+// Polls of an empty queue or an incomplete request before the waiting thread yields its core
+#define COMM_SPIN_LIMIT 1000
+
+static CommThreadStats commStats = { 0, 0, 0, 0, 0.0, 0.0 };
+
+/*!
+  Returns true if --comm-thread=1 is on the command line.
+
+  Needed before MPI_Init_thread, that is before HPCG_Init parses the options.
+*/
+bool CommThreadRequested(int argc, char ** argv) {
+  for (int i = 1; i < argc && argv[i]; ++i)
+    if (strncmp(argv[i], "--comm-thread=", 14) == 0 && atoi(argv[i]+14) != 0) return true;
+  return false;
+}
+
+#ifndef HPCG_NO_MPI
+
+// Single producer (the master thread), single consumer (the agent) ring of pending steps
+#define COMM_QUEUE_SIZE 64
+
+struct CommCommand {
+  CommPostFunction post;
+  void * args;
+  CommRequest * request;
+};
+
+static CommCommand commQueue[COMM_QUEUE_SIZE];
+static std::atomic<unsigned int> commHead(0); // next slot written by the producer
+static std::atomic<unsigned int> commTail(0); // next slot read by the agent
+static std::atomic<int> commStop(0);
+static std::thread commAgent;
+
+static void AgentLoop(void) {
+  std::vector<CommRequest *> active;
+  int idle = 0;
+  while (true) {
+    const unsigned int head = commHead.load(std::memory_order_acquire);
+    unsigned int tail = commTail.load(std::memory_order_relaxed);
+    while (tail != head) {
+      CommCommand & command = commQueue[tail % COMM_QUEUE_SIZE];
+      CommRequest * request = command.request;
+      request->count = command.post(command.args, &request->requests[0]);
+      active.push_back(request);
+      commTail.store(++tail, std::memory_order_release);
+    }
+    // Every test drives the progress engine of the MPI library
+    for (size_t i = 0; i < active.size(); ) {
+      int flag = 0;
+      MPI_Testall(active[i]->count, &active[i]->requests[0], &flag, MPI_STATUSES_IGNORE);
+      if (flag) {
+        active[i]->completeTime = mytimer();
+        active[i]->done.store(1, std::memory_order_release);
+        active[i] = active.back();
+        active.pop_back();
+      } else {
+        ++i;
+      }
+    }
+    if (active.empty() && head == commHead.load(std::memory_order_acquire)) {
+      if (commStop.load(std::memory_order_acquire)) break;
+      if (++idle < COMM_SPIN_LIMIT) COMM_PAUSE();
+      else std::this_thread::yield();
+    } else {
+      idle = 0;
+    }
+  }
+  return;
+}
+
+/*!
+  Starts a communication step.
+
+  With the agent running the step is queued and posted by the agent, which keeps testing it
+  until it completes. Otherwise post is called right away on the calling thread. Either way
+  the step is finished by CommWait on the same request, and only the master thread may
+  call CommPost.
+
+  @param[in]    post        Function posting the MPI operations
+  @param[in]    args        Arguments of post, must stay valid until CommWait returns
+  @param[in]    maxRequests Upper bound on the number of requests post creates
+  @param[inout] request     Request object of the step, must not be in use by another step
+*/
+void CommPost(CommPostFunction post, void * args, int maxRequests, CommRequest & request) {
+  if ((int) request.requests.size() < maxRequests) request.requests.resize(maxRequests);
+  if (request.requests.empty()) request.requests.resize(1);
+  request.done.store(0, std::memory_order_relaxed);
+  request.postTime = mytimer();
+  if (!commStats.enabled) {
+    request.count = post(args, &request.requests[0]);
+    return;
+  }
+  const unsigned int head = commHead.load(std::memory_order_relaxed);
+  while (head - commTail.load(std::memory_order_acquire) >= COMM_QUEUE_SIZE) COMM_PAUSE(); // queue full
+  commQueue[head % COMM_QUEUE_SIZE].post = post;
+  commQueue[head % COMM_QUEUE_SIZE].args = args;
+  commQueue[head % COMM_QUEUE_SIZE].request = &request;
+  commHead.store(head + 1, std::memory_order_release);
+  return;
+}
+
+/*!
+  Waits for the step started by CommPost and records how much of its lifetime was hidden.
+
+  @param[inout] request Request given to CommPost
+*/
+void CommWait(CommRequest & request) {
+  const double t0 = mytimer();
+  if (commStats.enabled) {
+    for (int spin = 0; !request.done.load(std::memory_order_acquire); ++spin) {
+      if (spin < COMM_SPIN_LIMIT) COMM_PAUSE();
+      else std::this_thread::yield();
+    }
+  } else {
+    MPI_Waitall(request.count, &request.requests[0], MPI_STATUSES_IGNORE);
+    request.completeTime = mytimer();
+    request.done.store(1, std::memory_order_relaxed);
+  }
+  // Only the part of the wait before completion counts; noticing it late is not communication
+  const double t1 = mytimer();
+  const double complete = (request.completeTime < t1) ? request.completeTime : t1;
+  commStats.operations++;
+  commStats.waitTime += (complete > t0) ? complete - t0 : 0.0;
+  commStats.lifetime += complete - request.postTime;
+  return;
+}
+
+static int PostAllreduceSum(void * args, MPI_Request * requests) {
+  CommRequest * request = (CommRequest *) args;
+  MPI_Iallreduce(request->sendBuffer, request->recvBuffer, request->bufferCount, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, requests);
+  return 1;
+}
+
+/*!
+  Starts a global sum of count doubles; recvBuffer holds the result after CommWait.
+
+  @param[in]    sendBuffer Local values, must stay valid until CommWait returns
+  @param[out]   recvBuffer Global sums
+  @param[in]    count      Number of values
+  @param[inout] request    Request object of the step
+*/
+void CommAllreduceSum(const double * sendBuffer, double * recvBuffer, int count, CommRequest & request) {
+  request.sendBuffer = sendBuffer;
+  request.recvBuffer = recvBuffer;
+  request.bufferCount = count;
+  commStats.reductions++;
+  CommPost(PostAllreduceSum, &request, 1, request);
+  return;
+}
+#endif
+
+/*!
+  Starts the communication agent.
+
+  The agent is a dedicated thread that owns one hardware thread of the rank: the number of
+  OpenMP threads is reduced by one and, on Linux, the agent is bound to the CPU set of the
+  OpenMP thread that was given up. Requires MPI_THREAD_MULTIPLE, since the master thread
+  keeps calling MPI directly outside the solver.
+
+  @param[in] enabled     Non-zero to start the agent
+  @param[in] threadLevel Thread support level returned by MPI_Init_thread
+
+  @return The number of OpenMP threads left for computation
+*/
+int InitializeCommThread(int enabled, int threadLevel) {
+  int numberOfThreads = 1;
+#ifndef HPCG_NO_OPENMP
+  numberOfThreads = omp_get_max_threads();
+#endif
+  commStats.threadLevel = threadLevel;
+#ifndef HPCG_NO_MPI
+  if (!enabled || threadLevel < MPI_THREAD_MULTIPLE || commStats.enabled) return numberOfThreads;
+
+#ifdef HPCG_COMM_AFFINITY
+  cpu_set_t mask;
+  int haveMask = 0;
+#pragma omp parallel
+  {
+    if (omp_get_thread_num() == omp_get_num_threads()-1 && omp_get_num_threads() > 1)
+      haveMask = (sched_getaffinity(0, sizeof(cpu_set_t), &mask) == 0);
+  }
+#endif
+  if (numberOfThreads > 1) {
+    --numberOfThreads;
+#ifndef HPCG_NO_OPENMP
+    omp_set_num_threads(numberOfThreads);
+#endif
+  }
+  commStop.store(0);
+  commAgent = std::thread(AgentLoop);
+#ifdef HPCG_COMM_AFFINITY
+  if (haveMask) pthread_setaffinity_np(commAgent.native_handle(), sizeof(cpu_set_t), &mask);
+#endif
+  commStats.enabled = 1;
+#endif
+  return numberOfThreads;
+}
+
+/*!
+  Stops the communication agent once all queued steps are done. Must be called before MPI_Finalize.
+*/
+void FinalizeCommThread(void) {
+#ifndef HPCG_NO_MPI
+  if (!commStats.enabled) return;
+  commStop.store(1, std::memory_order_release);
+  commAgent.join();
+  commStats.enabled = 0;
+#endif
+  return;
+}
+
+bool UseCommThread(void) {
+  return commStats.enabled != 0;
+}
+
+/*!
+  Returns the counters of CommWait. The fraction of communication time hidden behind
+  computation is 1 - waitTime/lifetime.
+*/
+void GetCommThreadStats(CommThreadStats & stats) {
+  stats = commStats;
+  return;
+}
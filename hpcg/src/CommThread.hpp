@@ -0,0 +1,86 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file CommThread.hpp
+
+ HPCG communication agent that progresses non-blocking MPI operations
+ */
+
+#ifndef COMMTHREAD_HPP
+#define COMMTHREAD_HPP
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#include <vector>
+#include <atomic>
+
+/*!
+  Posts the MPI operations of one communication step.
+
+  @param[in]  args     Arguments given to CommPost
+  @param[out] requests Room for the maxRequests requests given to CommPost
+
+  @return The number of requests posted
+*/
+typedef int (*CommPostFunction)(void * args, MPI_Request * requests);
+
+struct CommRequest_STRUCT {
+  std::vector<MPI_Request> requests; //!< requests of the posted operations
+  int count;                         //!< number of requests in use
+  std::atomic<int> done;             //!< set once all requests have completed
+  double postTime;                   //!< time CommPost was called
+  double completeTime;               //!< time completion was detected
+  const double * sendBuffer;         //!< operands of CommAllreduceSum
+  double * recvBuffer;
+  int bufferCount;
+  CommRequest_STRUCT() : count(0), done(1), postTime(0.0), completeTime(0.0), sendBuffer(0), recvBuffer(0), bufferCount(0) {}
+};
+typedef struct CommRequest_STRUCT CommRequest;
+
+void CommPost(CommPostFunction post, void * args, int maxRequests, CommRequest & request);
+void CommWait(CommRequest & request);
+void CommAllreduceSum(const double * sendBuffer, double * recvBuffer, int count, CommRequest & request);
+#endif
+
+struct CommThreadStats_STRUCT {
+  int enabled;              //!< 1 if the communication agent is running
+  int threadLevel;          //!< MPI thread support level provided by MPI_Init_thread
+  long long operations;     //!< number of communication steps waited for
+  long long reductions;     //!< number of CommAllreduceSum calls
+  double lifetime;          //!< sum over steps of the time from posting to completion
+  double waitTime;          //!< sum over steps of the time the caller was blocked in CommWait
+};
+typedef struct CommThreadStats_STRUCT CommThreadStats;
+
+bool CommThreadRequested(int argc, char ** argv);
+int InitializeCommThread(int enabled, int threadLevel);
+void FinalizeCommThread(void);
+bool UseCommThread(void);
+void GetCommThreadStats(CommThreadStats & stats);
+
+#endif // COMMTHREAD_HPP
@@ -0,0 +1,595 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file CompressedMatrix.cpp
+
+ HPCG routine
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include "SparseMatrix.hpp"
+#include "CompressedMatrix.hpp"
+#include "TrackedAllocator.hpp"
+#include "ParallelScan.hpp"
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+static bool compressedMatrixEnabled = false;
+
+/*!
+  Selects whether OptimizeProblem builds the compressed index format next to the MKL handles.
+
+  @param[in] enabled Non-zero to build and use the compressed format
+*/
+void InitializeCompressedMatrix(int enabled) {
+  compressedMatrixEnabled = (enabled != 0);
+  return;
+}
+
+bool UseCompressedMatrix(void) {
+  return compressedMatrixEnabled;
+}
+
+/*!
+  Builds the compressed index format of the local rows of A.
+
+  Must be called while A still holds the row-wise arrays (nonzerosInRow, mtxIndL, matrixValues),
+  i.e. inside OptimizeProblem before they are released.
+
+  @param[in] A The matrix, with local column indices from SetupHalo
+
+  @return The new matrix or NULL if no memory is available
+*/
+CompressedMatrix * BuildCompressedMatrix(const SparseMatrix & A) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+  CompressedMatrix * M = (CompressedMatrix *) TrackedMalloc(sizeof(CompressedMatrix), HPCG_MEM_MATRIX);
+  local_int_t * rowStart = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(nrow+1), HPCG_MEM_MATRIX);
+  unsigned char * pattern = (unsigned char *) TrackedMalloc(sizeof(unsigned char)*nrow, HPCG_MEM_MATRIX);
+  if (M == NULL || rowStart == NULL || pattern == NULL) return NULL;
+
+  // Rows with halo columns always go to the exception list
+  rowStart[0] = 0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<nrow; i++) {
+    const local_int_t * const cur_inds = A.mtxIndL[i];
+    bool local = true;
+    for (int j=0; j<A.nonzerosInRow[i]; j++)
+      if (cur_inds[j] >= nrow) local = false;
+    pattern[i] = local ? 0 : HPCG_PATTERN_EXCEPTION;
+    rowStart[i+1] = A.nonzerosInRow[i];
+  }
+  const local_int_t nnz = ParallelPrefixSum(rowStart+1, nrow);
+
+  // Assign pattern ids; consecutive rows usually share a pattern, so try the previous one first
+  std::vector<local_int_t> patternStart(1, 0);
+  std::vector<local_int_t> patternOffsets;
+  local_int_t numberOfExceptions = 0, exceptionNonzeros = 0;
+  int last = -1;
+  for (local_int_t i=0; i<nrow; i++) {
+    const local_int_t * const cur_inds = A.mtxIndL[i];
+    const int len = A.nonzerosInRow[i];
+    int id = HPCG_PATTERN_EXCEPTION;
+    if (pattern[i] != HPCG_PATTERN_EXCEPTION) {
+      const int numberOfPatterns = patternStart.size() - 1;
+      for (int t=0; t<=numberOfPatterns && id == HPCG_PATTERN_EXCEPTION; t++) {
+        int p = (t == 0) ? last : t - 1;
+        if (p < 0 || (t > 0 && p == last)) continue;
+        if (patternStart[p+1] - patternStart[p] != len) continue;
+        const local_int_t * off = &patternOffsets[patternStart[p]];
+        bool match = true;
+        for (int j=0; j<len && match; j++) match = (cur_inds[j] - i == off[j]);
+        if (match) id = p;
+      }
+      if (id == HPCG_PATTERN_EXCEPTION && numberOfPatterns < HPCG_PATTERN_MAX) {
+        for (int j=0; j<len; j++) patternOffsets.push_back(cur_inds[j] - i);
+        patternStart.push_back(patternOffsets.size());
+        id = numberOfPatterns;
+      }
+      if (id != HPCG_PATTERN_EXCEPTION) last = id;
+    }
+    pattern[i] = (unsigned char) id;
+    if (id == HPCG_PATTERN_EXCEPTION) {
+      numberOfExceptions++;
+      exceptionNonzeros += len;
+    }
+  }
+
+  const int numberOfPatterns = patternStart.size() - 1;
+  double * values = (double *) TrackedMalloc(sizeof(double)*nnz, HPCG_MEM_MATRIX);
+  local_int_t * pStart = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(numberOfPatterns+1), HPCG_MEM_MATRIX);
+  local_int_t * pOffsets = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(patternOffsets.size()+1), HPCG_MEM_MATRIX);
+  local_int_t * exceptionRows = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(numberOfExceptions+1), HPCG_MEM_MATRIX);
+  local_int_t * exceptionStart = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(numberOfExceptions+1), HPCG_MEM_MATRIX);
+  local_int_t * exceptionCols = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(exceptionNonzeros+1), HPCG_MEM_MATRIX);
+  if (values == NULL || pStart == NULL || pOffsets == NULL || exceptionRows == NULL || exceptionStart == NULL || exceptionCols == NULL) return NULL;
+
+  for (int p=0; p<=numberOfPatterns; p++) pStart[p] = patternStart[p];
+  for (size_t k=0; k<patternOffsets.size(); k++) pOffsets[k] = patternOffsets[k];
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<nrow; i++) {
+    const double * const cur_vals = A.matrixValues[i];
+    double * const v = values + rowStart[i];
+    for (int j=0; j<A.nonzerosInRow[i]; j++) v[j] = cur_vals[j];
+  }
+
+  // Exception columns are stored row after row, their values are found through rowStart
+  local_int_t e = 0, k = 0;
+  exceptionStart[0] = 0;
+  for (local_int_t i=0; i<nrow; i++) {
+    if (pattern[i] != HPCG_PATTERN_EXCEPTION) continue;
+    for (int j=0; j<A.nonzerosInRow[i]; j++) exceptionCols[k++] = A.mtxIndL[i][j];
+    exceptionRows[e] = i;
+    exceptionStart[++e] = k;
+  }
+
+  M->nrow = nrow;
+  M->nnz = nnz;
+  M->values = values;
+  M->rowStart = rowStart;
+  M->pattern = pattern;
+  M->numberOfPatterns = numberOfPatterns;
+  M->patternStart = pStart;
+  M->patternOffsets = pOffsets;
+  M->numberOfExceptions = numberOfExceptions;
+  M->exceptionRows = exceptionRows;
+  M->exceptionStart = exceptionStart;
+  M->exceptionCols = exceptionCols;
+  return M;
+}
+
+/*!
+  Releases a matrix created by BuildCompressedMatrix.
+
+  @param[in] M The matrix, may be NULL
+*/
+void DeleteCompressedMatrix(CompressedMatrix * M) {
+  if (M == NULL) return;
+  TrackedFree(M->values);
+  TrackedFree(M->rowStart);
+  TrackedFree(M->pattern);
+  TrackedFree(M->patternStart);
+  TrackedFree(M->patternOffsets);
+  TrackedFree(M->exceptionRows);
+  TrackedFree(M->exceptionStart);
+  TrackedFree(M->exceptionCols);
+  TrackedFree(M);
+  return;
+}
+
+/*!
+  Overwrites the diagonal entries of the compressed matrix.
+
+  @param[inout] M        The matrix
+  @param[in]    diagonal The new diagonal values, one per local row
+*/
+void ReplaceCompressedMatrixDiagonal(CompressedMatrix & M, const double * const diagonal) {
+  // Position of the diagonal inside every pattern
+  std::vector<int> patternDiagonal(M.numberOfPatterns, -1);
+  for (int p=0; p<M.numberOfPatterns; p++)
+    for (local_int_t k=M.patternStart[p]; k<M.patternStart[p+1]; k++)
+      if (M.patternOffsets[k] == 0) patternDiagonal[p] = k - M.patternStart[p];
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<M.nrow; i++) {
+    const int p = M.pattern[i];
+    if (p != HPCG_PATTERN_EXCEPTION && patternDiagonal[p] >= 0) M.values[M.rowStart[i] + patternDiagonal[p]] = diagonal[i];
+  }
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t e=0; e<M.numberOfExceptions; e++) {
+    const local_int_t i = M.exceptionRows[e];
+    for (local_int_t k=M.exceptionStart[e]; k<M.exceptionStart[e+1]; k++)
+      if (M.exceptionCols[k] == i) M.values[M.rowStart[i] + k - M.exceptionStart[e]] = diagonal[i];
+  }
+  return;
+}
+
+/*!
+  Returns the number of bytes the compressed format spends on indices (everything except values).
+
+  @param[in] M The matrix
+*/
+double CompressedMatrixIndexBytes(const CompressedMatrix & M) {
+  double bytes = ((double) sizeof(local_int_t))*(M.nrow+1);    // rowStart
+  bytes += ((double) sizeof(unsigned char))*M.nrow;            // pattern
+  bytes += ((double) sizeof(local_int_t))*(M.numberOfPatterns+1 + M.patternStart[M.numberOfPatterns]); // pattern table
+  bytes += ((double) sizeof(local_int_t))*(2*M.numberOfExceptions+1 + M.exceptionStart[M.numberOfExceptions]); // exception list
+  return bytes;
+}
+
+/*!
+  Computes y = A*x with the compressed format and, optionally, the local part of x'*y.
+
+  Pattern rows decode their columns as row + offset from the pattern table, which stays in L1,
+  so the inner loop is a contiguous gather the compiler vectorizes. Exception rows are
+  processed in a second pass.
+
+  @param[in]  M  The matrix
+  @param[in]  x  The input vector, including halo values
+  @param[out] y  The result
+  @param[out] xy If not NULL, receives the local dot product of x and y
+*/
+void ComputeCompressedSPMV(const CompressedMatrix & M, const double * const x, double * const y, double * xy) {
+  const local_int_t nrow = M.nrow;
+  const double * const values = M.values;
+  const local_int_t * const rowStart = M.rowStart;
+  const unsigned char * const pattern = M.pattern;
+  const local_int_t * const patternStart = M.patternStart;
+  const local_int_t * const patternOffsets = M.patternOffsets;
+  double dot = 0.0;
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for reduction(+:dot)
+#endif
+  for (local_int_t i=0; i<nrow; i++) {
+    const int p = pattern[i];
+    if (p == HPCG_PATTERN_EXCEPTION) continue;
+    const local_int_t * const off = patternOffsets + patternStart[p];
+    const int len = patternStart[p+1] - patternStart[p];
+    const double * const v = values + rowStart[i];
+    const double * const xi = x + i;
+    double sum = 0.0;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp simd reduction(+:sum)
+#endif
+    for (int j=0; j<len; j++) sum += v[j]*xi[off[j]];
+    y[i] = sum;
+    dot += sum*x[i];
+  }
+
+  const local_int_t * const exceptionRows = M.exceptionRows;
+  const local_int_t * const exceptionStart = M.exceptionStart;
+  const local_int_t * const exceptionCols = M.exceptionCols;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for reduction(+:dot)
+#endif
+  for (local_int_t e=0; e<M.numberOfExceptions; e++) {
+    const local_int_t i = exceptionRows[e];
+    const local_int_t * const cols = exceptionCols + exceptionStart[e];
+    const int len = exceptionStart[e+1] - exceptionStart[e];
+    const double * const v = values + rowStart[i];
+    double sum = 0.0;
+    for (int j=0; j<len; j++) sum += v[j]*x[cols[j]];
+    y[i] = sum;
+    dot += sum*x[i];
+  }
+  if (xy != NULL) *xy = dot;
+  return;
+}
+
+// Returns the product of row i of M with x
+static inline double CompressedRowProduct(const CompressedMatrix & M, local_int_t i, const double * const x) {
+  const int p = M.pattern[i];
+  const double * const v = M.values + M.rowStart[i];
+  double sum = 0.0;
+  if (p != HPCG_PATTERN_EXCEPTION) {
+    const local_int_t * const off = M.patternOffsets + M.patternStart[p];
+    const int len = M.patternStart[p+1] - M.patternStart[p];
+    const double * const xi = x + i;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp simd reduction(+:sum)
+#endif
+    for (int j=0; j<len; j++) sum += v[j]*xi[off[j]];
+  } else {
+    // Exception rows are sorted, so their columns are found by bisection
+    const local_int_t * const exceptionRows = M.exceptionRows;
+    const local_int_t * const exceptionEnd = exceptionRows + M.numberOfExceptions;
+    const local_int_t e = std::lower_bound(exceptionRows, exceptionEnd, i) - exceptionRows;
+    const local_int_t * const cols = M.exceptionCols + M.exceptionStart[e];
+    const int len = M.exceptionStart[e+1] - M.exceptionStart[e];
+    for (int j=0; j<len; j++) sum += v[j]*x[cols[j]];
+  }
+  return sum;
+}
+
+/*!
+  Computes the residual r - A*x for a subset of rows only.
+
+  Used by the fused residual and restriction step of the multigrid V-cycle, which needs
+  the fine grid residual at the injected points only.
+
+  @param[in]  M    The matrix
+  @param[in]  rows Local indices of the rows to compute
+  @param[in]  n    Number of rows
+  @param[in]  r    The right hand side
+  @param[in]  x    The current approximation, including halo values
+  @param[out] res  res[k] receives the residual of row rows[k]
+
+  @see ComputeCompressedResidualInjection
+*/
+void ComputeCompressedResidualRows(const CompressedMatrix & M, const local_int_t * const rows, local_int_t n,
+                                   const double * const r, const double * const x, double * const res) {
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t k=0; k<n; k++) {
+    const local_int_t i = rows[k];
+    res[k] = r[i] - CompressedRowProduct(M, i, x);
+  }
+  return;
+}
+
+/*!
+  Computes the residual r - A*x at the points of a structured grid that are injected into the next coarser grid.
+
+  Same as ComputeCompressedResidualRows with the rows of the structured injection operator,
+  coarse point (ixc,iyc,izc) taking fine row (2*izc*nyf + 2*iyc)*nxf + 2*ixc, but the row
+  indices are generated on the fly instead of being read from an index array.
+
+  @param[in]  M   The fine grid matrix
+  @param[in]  nxf Number of fine grid points in x
+  @param[in]  nyf Number of fine grid points in y
+  @param[in]  nxc Number of coarse grid points in x
+  @param[in]  nyc Number of coarse grid points in y
+  @param[in]  nzc Number of coarse grid points in z
+  @param[in]  r   The right hand side
+  @param[in]  x   The current approximation, including halo values
+  @param[out] res The coarse grid residual, in coarse grid row order
+*/
+void ComputeCompressedResidualInjection(const CompressedMatrix & M, local_int_t nxf, local_int_t nyf,
+                                        local_int_t nxc, local_int_t nyc, local_int_t nzc,
+                                        const double * const r, const double * const x, double * const res) {
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for collapse(2)
+#endif
+  for (local_int_t izc=0; izc<nzc; izc++) {
+    for (local_int_t iyc=0; iyc<nyc; iyc++) {
+      const local_int_t fineStart = (2*izc*nyf + 2*iyc)*nxf;
+      double * const resLine = res + (izc*nyc + iyc)*nxc;
+      for (local_int_t ixc=0; ixc<nxc; ixc++) {
+        const local_int_t i = fineStart + 2*ixc;
+        resLine[ixc] = r[i] - CompressedRowProduct(M, i, x);
+      }
+    }
+  }
+  return;
+}
+
+// Upper product and forward sweep right hand side of a pattern row (no halo columns)
+static inline void UpperResidualPatternRow(const CompressedMatrix & M, local_int_t i, const double * const r,
+                                           const double * const x, double * const upper, double * const res) {
+  const int p = M.pattern[i];
+  const local_int_t * const off = M.patternOffsets + M.patternStart[p];
+  const int len = M.patternStart[p+1] - M.patternStart[p];
+  const double * const v = M.values + M.rowStart[i];
+  const double * const xi = x + i;
+  double sum = 0.0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp simd reduction(+:sum)
+#endif
+  for (int j=0; j<len; j++) sum += (off[j] > 0) ? v[j]*xi[off[j]] : 0.0;
+  upper[i] = sum;
+  res[i] = r[i] - sum;
+}
+
+// Same for exception row e, whose halo columns only go into res
+static inline void UpperResidualExceptionRow(const CompressedMatrix & M, local_int_t e, const double * const r,
+                                             const double * const x, double * const upper, double * const res) {
+  const local_int_t i = M.exceptionRows[e];
+  const local_int_t * const cols = M.exceptionCols + M.exceptionStart[e];
+  const int len = M.exceptionStart[e+1] - M.exceptionStart[e];
+  const double * const v = M.values + M.rowStart[i];
+  double sum = 0.0, halo = 0.0;
+  for (int j=0; j<len; j++) {
+    if (cols[j] >= M.nrow) halo += v[j]*x[cols[j]];
+    else if (cols[j] > i) sum += v[j]*x[cols[j]];
+  }
+  upper[i] = sum;
+  res[i] = r[i] - sum - halo;
+}
+
+/*!
+  Serial part of ComputeCompressedResidualInjection for the coarse lines (izc*nyc + iyc) in [lineBegin,lineEnd).
+
+  Only rows of one kind are computed: pattern rows, which never reference halo columns, or
+  exception rows. This lets the pattern rows overlap with the halo exchange.
+
+  @param[in] exceptions true to compute the exception rows, false for the pattern rows
+
+  @see ComputeCompressedResidualInjection
+*/
+void ComputeCompressedResidualInjectionLines(const CompressedMatrix & M, local_int_t nxf, local_int_t nyf,
+                                             local_int_t nxc, local_int_t nyc, local_int_t lineBegin, local_int_t lineEnd,
+                                             bool exceptions, const double * const r, const double * const x, double * const res) {
+  for (local_int_t line=lineBegin; line<lineEnd; line++) {
+    const local_int_t izc = line/nyc;
+    const local_int_t iyc = line - izc*nyc;
+    const local_int_t fineStart = (2*izc*nyf + 2*iyc)*nxf;
+    double * const resLine = res + line*nxc;
+    for (local_int_t ixc=0; ixc<nxc; ixc++) {
+      const local_int_t i = fineStart + 2*ixc;
+      if ((M.pattern[i] == HPCG_PATTERN_EXCEPTION) == exceptions) resLine[ixc] = r[i] - CompressedRowProduct(M, i, x);
+    }
+  }
+  return;
+}
+
+/*!
+  Computes the first pass of a distributed symmetric Gauss-Seidel step in one sweep over the matrix.
+
+  upper[i] = sum of a_ij*x_j over local columns j > i
+  res[i]   = r[i] - sum of a_ij*x_j over all columns j > i (halo columns included)
+
+  This replaces the separate upper triangular and halo products of ComputeSYMGS.
+
+  @param[in]  M     The matrix
+  @param[in]  r     The right hand side
+  @param[in]  x     The current approximation, including halo values
+  @param[out] upper The upper triangular product
+  @param[out] res   The right hand side of the forward sweep
+*/
+void ComputeCompressedUpperResidual(const CompressedMatrix & M, const double * const r, const double * const x,
+                                    double * const upper, double * const res) {
+  const local_int_t nrow = M.nrow;
+  const unsigned char * const pattern = M.pattern;
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<nrow; i++)
+    if (pattern[i] != HPCG_PATTERN_EXCEPTION) UpperResidualPatternRow(M, i, r, x, upper, res);
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t e=0; e<M.numberOfExceptions; e++) UpperResidualExceptionRow(M, e, r, x, upper, res);
+  return;
+}
+
+// Fine row of coarse row c under the structured injection
+static inline local_int_t InjectedRow(local_int_t c, local_int_t nxf, local_int_t nyf, local_int_t nxc, local_int_t nyc) {
+  const local_int_t line = c/nxc;
+  const local_int_t ixc = c - line*nxc;
+  const local_int_t izc = line/nyc;
+  const local_int_t iyc = line - izc*nyc;
+  return (2*izc*nyf + 2*iyc)*nxf + 2*ixc;
+}
+
+// Coarse rows on the low faces of the subdomain; their fine points are the only injected ones sent to neighbors
+static inline bool InjectedOnLowFace(local_int_t c, local_int_t nxc, local_int_t nyc) {
+  const local_int_t line = c/nxc;
+  return c - line*nxc == 0 || line%nyc == 0 || line < nyc;
+}
+
+/*!
+  Applies the coarse grid correction and computes the first pass of a distributed symmetric
+  Gauss-Seidel step (see ComputeCompressedUpperResidual) in the same sweep over the matrix.
+
+  An injected point must be corrected before the first row that reads it, and rows only read
+  columns up to reach = nxf*nyf + nxf + 1 ahead of themselves. Every thread first corrects the
+  points among the first reach rows of its block, which the previous block reads, and after a
+  barrier walks its rows in order, correcting the point reach rows ahead of the row it computes.
+  The exception rows follow once every point is corrected.
+
+  The points on the low faces of the subdomain (ixc, iyc or izc zero) are left out: they are
+  the only injected points sent to neighbors, so the caller corrects them before the halo exchange.
+
+  @param[in]    M     The matrix
+  @param[in]    nxf   Fine grid points in x
+  @param[in]    nyf   Fine grid points in y
+  @param[in]    nxc   Coarse grid points in x
+  @param[in]    nyc   Coarse grid points in y
+  @param[in]    nzc   Coarse grid points in z
+  @param[in]    xc    The coarse grid correction
+  @param[in]    r     The right hand side
+  @param[inout] x     The current approximation with corrected halo values; the correction is added on exit
+  @param[out]   upper The upper triangular product of the corrected x
+  @param[out]   res   The right hand side of the forward sweep
+*/
+void ComputeCompressedUpperResidualProlongation(const CompressedMatrix & M, local_int_t nxf, local_int_t nyf,
+                                                local_int_t nxc, local_int_t nyc, local_int_t nzc, const double * const xc,
+                                                const double * const r, double * const x,
+                                                double * const upper, double * const res) {
+  const local_int_t nrow = M.nrow;
+  const local_int_t nc = nxc*nyc*nzc;
+  const local_int_t reach = nxf*nyf + nxf + 1;
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel
+#endif
+  {
+#ifndef HPCG_NO_OPENMP
+    const int nthr = omp_get_num_threads(), ithr = omp_get_thread_num();
+#else
+    const int nthr = 1, ithr = 0;
+#endif
+    const local_int_t begin = ((long long) ithr*nrow)/nthr, end = ((long long) (ithr+1)*nrow)/nthr;
+
+    // First coarse row whose injected point is in this block
+    local_int_t c = 0, last = nc;
+    while (c < last) {
+      const local_int_t mid = c + (last - c)/2;
+      if (InjectedRow(mid, nxf, nyf, nxc, nyc) < begin) c = mid + 1;
+      else last = mid;
+    }
+    local_int_t next = (c < nc) ? InjectedRow(c, nxf, nyf, nxc, nyc) : nrow;
+
+    const local_int_t headEnd = std::min(begin + reach, end);
+    for (; c < nc && next < headEnd; next = (++c < nc) ? InjectedRow(c, nxf, nyf, nxc, nyc) : nrow)
+      if (!InjectedOnLowFace(c, nxc, nyc)) x[next] += xc[c];
+#ifndef HPCG_NO_OPENMP
+    #pragma omp barrier
+#endif
+
+    for (local_int_t i=begin; i<end; i++) {
+      const local_int_t ahead = std::min(i + reach, end - 1);
+      for (; c < nc && next <= ahead; next = (++c < nc) ? InjectedRow(c, nxf, nyf, nxc, nyc) : nrow)
+        if (!InjectedOnLowFace(c, nxc, nyc)) x[next] += xc[c];
+      if (M.pattern[i] != HPCG_PATTERN_EXCEPTION) UpperResidualPatternRow(M, i, r, x, upper, res);
+    }
+  }
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t e=0; e<M.numberOfExceptions; e++) UpperResidualExceptionRow(M, e, r, x, upper, res);
+  return;
+}
+
+/*!
+  Serial part of ComputeCompressedUpperResidual for the pattern rows in [begin,end).
+
+  Pattern rows never reference halo columns, so this part can run while the halo exchange
+  is still in flight.
+
+  @see ComputeCompressedUpperResidual
+*/
+void ComputeCompressedUpperResidualPatternRows(const CompressedMatrix & M, local_int_t begin, local_int_t end,
+                                               const double * const r, const double * const x,
+                                               double * const upper, double * const res) {
+  for (local_int_t i=begin; i<end; i++)
+    if (M.pattern[i] != HPCG_PATTERN_EXCEPTION) UpperResidualPatternRow(M, i, r, x, upper, res);
+  return;
+}
+
+/*!
+  Serial part of ComputeCompressedUpperResidual for the exception rows with index in [begin,end)
+  of the exception list. Needs the halo values of x.
+
+  @see ComputeCompressedUpperResidual
+*/
+void ComputeCompressedUpperResidualExceptionRows(const CompressedMatrix & M, local_int_t begin, local_int_t end,
+                                                 const double * const r, const double * const x,
+                                                 double * const upper, double * const res) {
+  for (local_int_t e=begin; e<end; e++) UpperResidualExceptionRow(M, e, r, x, upper, res);
+  return;
+}
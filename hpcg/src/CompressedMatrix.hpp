@@ -0,0 +1,99 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file CompressedMatrix.hpp
+
+ HPCG sparse format with pattern-compressed column indices
+ */
+
+#ifndef COMPRESSEDMATRIX_HPP
+#define COMPRESSEDMATRIX_HPP
+
+#include "Geometry.hpp"
+
+// Pattern id of rows whose columns are kept in the exception list
+#define HPCG_PATTERN_EXCEPTION 255
+// Largest number of distinct stencil patterns per level
+#define HPCG_PATTERN_MAX 255
+
+/*!
+  Local part of a matrix stored with one pattern id per row instead of one column index per nonzero.
+
+  A pattern is the sequence of column offsets (column - row) of a row. The 27-point operator has
+  at most 27 distinct patterns per subdomain (interior, faces, edges and corners), so each row only
+  needs a one-byte id. Rows that reference halo columns, or that would exceed the pattern table,
+  keep explicit column indices in the exception list.
+*/
+struct CompressedMatrix_STRUCT {
+  local_int_t nrow; //!< number of local rows
+  local_int_t nnz; //!< number of stored nonzeros
+  double * values; //!< matrix values, rowStart[i] to rowStart[i+1] for row i
+  local_int_t * rowStart; //!< offset of the first value of each row
+  unsigned char * pattern; //!< pattern id of each row or HPCG_PATTERN_EXCEPTION
+  int numberOfPatterns; //!< number of entries in the pattern table
+  local_int_t * patternStart; //!< offset of the first column offset of each pattern
+  local_int_t * patternOffsets; //!< column offsets relative to the row, for all patterns
+  local_int_t numberOfExceptions; //!< number of rows with explicit column indices
+  local_int_t * exceptionRows; //!< row index of each exception row
+  local_int_t * exceptionStart; //!< offset of the first column of each exception row in exceptionCols
+  local_int_t * exceptionCols; //!< column indices of all exception rows
+};
+typedef struct CompressedMatrix_STRUCT CompressedMatrix;
+
+struct SparseMatrix_STRUCT;
+
+void InitializeCompressedMatrix(int enabled);
+bool UseCompressedMatrix(void);
+CompressedMatrix * BuildCompressedMatrix(const struct SparseMatrix_STRUCT & A);
+void DeleteCompressedMatrix(CompressedMatrix * M);
+void ReplaceCompressedMatrixDiagonal(CompressedMatrix & M, const double * const diagonal);
+double CompressedMatrixIndexBytes(const CompressedMatrix & M);
+void ComputeCompressedSPMV(const CompressedMatrix & M, const double * const x, double * const y, double * xy);
+void ComputeCompressedResidualRows(const CompressedMatrix & M, const local_int_t * const rows, local_int_t n,
+                                   const double * const r, const double * const x, double * const res);
+void ComputeCompressedResidualInjection(const CompressedMatrix & M, local_int_t nxf, local_int_t nyf,
+                                        local_int_t nxc, local_int_t nyc, local_int_t nzc,
+                                        const double * const r, const double * const x, double * const res);
+void ComputeCompressedResidualInjectionLines(const CompressedMatrix & M, local_int_t nxf, local_int_t nyf,
+                                             local_int_t nxc, local_int_t nyc, local_int_t lineBegin, local_int_t lineEnd,
+                                             bool exceptions, const double * const r, const double * const x, double * const res);
+void ComputeCompressedUpperResidual(const CompressedMatrix & M, const double * const r, const double * const x,
+                                    double * const upper, double * const res);
+void ComputeCompressedUpperResidualProlongation(const CompressedMatrix & M, local_int_t nxf, local_int_t nyf,
+                                                local_int_t nxc, local_int_t nyc, local_int_t nzc, const double * const xc,
+                                                const double * const r, double * const x,
+                                                double * const upper, double * const res);
+void ComputeCompressedUpperResidualPatternRows(const CompressedMatrix & M, local_int_t begin, local_int_t end,
+                                               const double * const r, const double * const x,
+                                               double * const upper, double * const res);
+void ComputeCompressedUpperResidualExceptionRows(const CompressedMatrix & M, local_int_t begin, local_int_t end,
+                                                 const double * const r, const double * const x,
+                                                 double * const upper, double * const res);
+
+#endif // COMPRESSEDMATRIX_HPP
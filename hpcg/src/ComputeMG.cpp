@@ -36,6 +36,10 @@
 #include "ComputeSPMV.hpp"
 #include "ComputeRestriction_ref.hpp"
 #include "ComputeProlongation_ref.hpp"
+#include "ComputeRestriction.hpp"
+#include "ComputeProlongation.hpp"
+#include "ComputeMGTasks.hpp"
+#include "mytimer.hpp"
 
 #ifndef HPCG_NO_MPI
 #include "ExchangeHalo.hpp"
@@ -61,16 +65,23 @@ int ComputeMG(const SparseMatrix  & A, const Vector & r, Vector & x)
     ComputeMG_ref(A,r,x);
 #else
     int ierr = 0;
+    PreconditionerHaloScope haloScope; // exchanges below may use the reduced halo encoding
 
     if (A.mgData!=0) // Go to next coarse level if defined
     {
         const int numberOfPresmootherSteps = A.mgData->numberOfPresmootherSteps;
         const int numberOfPostsmootherSteps = A.mgData->numberOfPostsmootherSteps;
+        struct optData *optData = (struct optData *)A.optimizationData;
+
+        // With the compressed index format the residual is only formed at the injected points
+        const bool fused = ( optData->cmat != NULL );
+        const bool tasks = fused && UseMGTasks();
 
-        if ( numberOfPresmootherSteps > 1 )
+        const double tcycle = mytimer();
+        double t0 = tcycle;
+        if ( numberOfPresmootherSteps > 1 || fused )
         {
             sparse_status_t status = SPARSE_STATUS_SUCCESS;
-            struct optData *optData = (struct optData *)A.optimizationData;
             struct matrix_descr descr;
             sparse_matrix_t csrA = (sparse_matrix_t)optData->csrA;
             descr.type = SPARSE_MATRIX_TYPE_SYMMETRIC;
@@ -80,17 +91,38 @@ int ComputeMG(const SparseMatrix  & A, const Vector & r, Vector & x)
             if ( mkl_sparse_d_symgs(SPARSE_OPERATION_NON_TRANSPOSE, csrA, descr, 0.0, r.values, x.values) != SPARSE_STATUS_SUCCESS ) ierr ++;
 
             for ( int i = 1; i < numberOfPresmootherSteps; ++i ) ierr += ComputeSYMGS(A, r, x);
-            ierr += ComputeSPMV(A, x, (*A.mgData->Axf));
+            if ( fused )
+            {
+                if ( tasks ) ierr += ComputeResidualRestrictionTasks(A, r, x);
+                else ierr += ComputeResidualRestriction(A, r, x);
+            } else
+            {
+                ierr += ComputeSPMV(A, x, (*A.mgData->Axf));
+                ierr += ComputeRestriction(A, r);
+            }
         } else
         {
             ierr += ComputeSYMGS_MV(A, r, x, (*A.mgData->Axf));
+            ierr += ComputeRestriction(A, r);
         }
+        A.mgData->restrictionTime += mytimer() - t0;
 
-        ierr += ComputeRestriction_ref(A, r);
         ierr += ComputeMG(*A.Ac,*A.mgData->rc, *A.mgData->xc);
-        ierr += ComputeProlongation_ref(A, x);
 
-        for ( int i = 0; i < numberOfPostsmootherSteps; ++i ) ierr += ComputeSYMGS(A, r, x);
+        t0 = mytimer();
+        if ( fused && numberOfPostsmootherSteps > 0 )
+        {
+            if ( tasks ) ierr += ComputeProlongationSYMGSTasks(A, r, x);
+            else ierr += ComputeProlongationSYMGS(A, r, x);
+            for ( int i = 1; i < numberOfPostsmootherSteps; ++i ) ierr += ComputeSYMGS(A, r, x);
+        } else
+        {
+            ierr += ComputeProlongation(A, x);
+            for ( int i = 0; i < numberOfPostsmootherSteps; ++i ) ierr += ComputeSYMGS(A, r, x);
+        }
+        A.mgData->prolongationTime += mytimer() - t0;
+        A.mgData->cycleTime += mytimer() - tcycle;
+        A.mgData->numberOfCycles ++;
 
         if ( ierr != 0 ) return 1;
     } else
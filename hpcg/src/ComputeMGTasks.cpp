@@ -0,0 +1,230 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ComputeMGTasks.cpp
+
+ HPCG routine
+ */
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#ifndef HPCG_NO_MPI
+#include "ExchangeHalo.hpp"
+#endif
+
+#include "ComputeMGTasks.hpp"
+#include "ComputeRestriction.hpp"
+#include "ComputeProlongation.hpp"
+#include "ComputeSYMGS.hpp"
+#include "ThreadTeam.hpp"
+
+static bool mgTasks = false;
+
+// Number of tasks per kernel: a few per thread so that idle threads can pick up work
+static local_int_t NumberOfTasks(local_int_t n) {
+  local_int_t numberOfTasks = 4;
+#ifndef HPCG_NO_OPENMP
+  numberOfTasks = 4*omp_get_max_threads();
+#endif
+  if (numberOfTasks > n) numberOfTasks = n;
+  if (numberOfTasks < 1) numberOfTasks = 1;
+  return numberOfTasks;
+}
+
+/*!
+  Selects the task-based execution of the distributed V-cycle steps.
+
+  @param[in] enabled Non-zero to use ComputeResidualRestrictionTasks and ComputeProlongationSYMGSTasks in ComputeMG
+*/
+void InitializeMGTasks(int enabled) {
+  mgTasks = (enabled != 0);
+  return;
+}
+
+bool UseMGTasks(void) {
+  return mgTasks;
+}
+
+/*!
+  Task-based version of ComputeResidualRestriction.
+
+  The injected rows are split into blocks of coarse lines. The pattern rows of every block
+  never reference halo columns, so their tasks are released as soon as the halo exchange of
+  xf has been posted and run while the messages are in flight. The tasks for the exception
+  rows, which may read halo values, are only created once the exchange has completed. MPI
+  calls stay on the master thread; the other threads pick up the tasks meanwhile.
+
+  Falls back to ComputeResidualRestriction on a single process, where there is no
+  communication to overlap.
+
+  @param[in]    A  Fine grid matrix, with mgData->rc.
+  @param[in]    rf Fine grid RHS.
+  @param[inout] xf Fine grid solution after pre-smoothing; its halo values are refreshed.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see ComputeResidualRestriction
+*/
+int ComputeResidualRestrictionTasks(const SparseMatrix & A, const Vector & rf, Vector & xf) {
+
+  struct optData *optData = (struct optData *)A.optimizationData;
+  if ( optData == NULL || optData->cmat == NULL ) return 1;
+  if ( A.geom->size == 1 || A.mgData->f2cOperator != NULL ) return ComputeResidualRestriction(A, rf, xf);
+
+  const CompressedMatrix & M = *optData->cmat;
+  const local_int_t nxf = A.geom->nx;
+  const local_int_t nyf = A.geom->ny;
+  const local_int_t nxc = A.Ac->geom->nx;
+  const local_int_t nyc = A.Ac->geom->ny;
+  const local_int_t numberOfLines = A.Ac->geom->nz*nyc;
+  const local_int_t numberOfTasks = NumberOfTasks(numberOfLines);
+  const double * const rfv = rf.values;
+  const double * const xfv = xf.values;
+  double * const rcv = A.mgData->rc->values;
+
+#ifndef HPCG_NO_OPENMP
+#pragma omp parallel
+#pragma omp master
+#endif
+  {
+#ifndef HPCG_NO_MPI
+    BeginExchangeHalo(A, xf);
+#endif
+    for (local_int_t t=0; t<numberOfTasks; ++t) {
+#ifndef HPCG_NO_OPENMP
+#pragma omp task firstprivate(t)
+#endif
+      {
+        local_int_t begin, end;
+        ThreadTeamRange(numberOfLines, t, numberOfTasks, begin, end);
+        ComputeCompressedResidualInjectionLines(M, nxf, nyf, nxc, nyc, begin, end, false, rfv, xfv, rcv);
+      }
+    }
+#ifndef HPCG_NO_MPI
+    EndExchangeHalo(A, xf);
+#endif
+    for (local_int_t t=0; t<numberOfTasks; ++t) {
+#ifndef HPCG_NO_OPENMP
+#pragma omp task firstprivate(t)
+#endif
+      {
+        local_int_t begin, end;
+        ThreadTeamRange(numberOfLines, t, numberOfTasks, begin, end);
+        ComputeCompressedResidualInjectionLines(M, nxf, nyf, nxc, nyc, begin, end, true, rfv, xfv, rcv);
+      }
+    }
+  } // the barrier closing the parallel region completes all tasks
+  return 0;
+}
+
+/*!
+  Task-based version of ComputeProlongationSYMGS.
+
+  Unlike ComputeProlongationSYMGS, the correction is not folded into the upper products: the
+  whole of xf is corrected first, so the products of the pattern rows can overlap the halo
+  exchange. Prolongation tasks work on blocks of coarse lines. Once they are done the master posts
+  the halo exchange of xf, and tasks for the upper products of the pattern rows run while
+  the messages are in flight. The exception rows follow once the exchange has completed,
+  then the triangular sweeps finish the smoothing step.
+
+  Falls back to ComputeProlongationSYMGS on a single process.
+
+  @param[in]    Af Fine grid matrix, with the coarse grid correction in mgData->xc.
+  @param[in]    rf Fine grid RHS.
+  @param[inout] xf Fine grid solution, corrected and smoothed on exit.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see ComputeProlongationSYMGS
+*/
+int ComputeProlongationSYMGSTasks(const SparseMatrix & Af, const Vector & rf, Vector & xf) {
+
+  struct optData *optData = (struct optData *)Af.optimizationData;
+  if ( optData == NULL || optData->cmat == NULL ) return 1;
+  if ( Af.geom->size == 1 || Af.mgData->f2cOperator != NULL ) return ComputeProlongationSYMGS(Af, rf, xf);
+
+  const CompressedMatrix & M = *optData->cmat;
+  const local_int_t numberOfLines = Af.Ac->geom->nz*Af.Ac->geom->ny;
+  const local_int_t nrow = Af.localNumberOfRows;
+  const local_int_t lineTasks = NumberOfTasks(numberOfLines);
+  const local_int_t rowTasks = NumberOfTasks(nrow);
+  const local_int_t exceptionTasks = NumberOfTasks(M.numberOfExceptions);
+  const double * const rv = rf.values;
+  double * const xfv = xf.values;
+
+#ifndef HPCG_NO_OPENMP
+#pragma omp parallel
+#pragma omp master
+#endif
+  {
+    for (local_int_t t=0; t<lineTasks; ++t) {
+#ifndef HPCG_NO_OPENMP
+#pragma omp task firstprivate(t)
+#endif
+      {
+        local_int_t begin, end;
+        ThreadTeamRange(numberOfLines, t, lineTasks, begin, end);
+        ComputeProlongationLines(Af, xfv, begin, end);
+      }
+    }
+    // The send buffer is packed from the corrected xf
+#ifndef HPCG_NO_OPENMP
+#pragma omp taskwait
+#endif
+#ifndef HPCG_NO_MPI
+    BeginExchangeHalo(Af, xf);
+#endif
+    for (local_int_t t=0; t<rowTasks; ++t) {
+#ifndef HPCG_NO_OPENMP
+#pragma omp task firstprivate(t)
+#endif
+      {
+        local_int_t begin, end;
+        ThreadTeamRange(nrow, t, rowTasks, begin, end);
+        ComputeCompressedUpperResidualPatternRows(M, begin, end, rv, xfv, optData->dtmp4, optData->dtmp);
+      }
+    }
+#ifndef HPCG_NO_MPI
+    EndExchangeHalo(Af, xf);
+#endif
+    for (local_int_t t=0; t<exceptionTasks; ++t) {
+#ifndef HPCG_NO_OPENMP
+#pragma omp task firstprivate(t)
+#endif
+      {
+        local_int_t begin, end;
+        ThreadTeamRange(M.numberOfExceptions, t, exceptionTasks, begin, end);
+        ComputeCompressedUpperResidualExceptionRows(M, begin, end, rv, xfv, optData->dtmp4, optData->dtmp);
+      }
+    }
+  } // the barrier closing the parallel region completes all tasks
+
+  return ComputeSYMGS_Sweeps(Af, xf);
+}
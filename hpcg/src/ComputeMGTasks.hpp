@@ -0,0 +1,36 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+#ifndef COMPUTEMGTASKS_HPP
+#define COMPUTEMGTASKS_HPP
+#include "Vector.hpp"
+#include "SparseMatrix.hpp"
+void InitializeMGTasks(int enabled);
+bool UseMGTasks(void);
+int ComputeResidualRestrictionTasks(const SparseMatrix & A, const Vector & rf, Vector & xf);
+int ComputeProlongationSYMGSTasks(const SparseMatrix & Af, const Vector & rf, Vector & xf);
+#endif // COMPUTEMGTASKS_HPP
@@ -0,0 +1,172 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeProlongation.cpp
+
+ HPCG routine
+ */
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#include "ComputeProlongation.hpp"
+#include "ComputeProlongation_ref.hpp"
+#include "ComputeSYMGS.hpp"
+#include "ThreadTeam.hpp"
+#include "CompressedMatrix.hpp"
+#ifndef HPCG_NO_MPI
+#include "ExchangeHalo.hpp"
+#endif
+
+struct ProlongationArgs {
+  const SparseMatrix & Af;
+  double * xfv;
+};
+
+/*!
+  Applies the coarse grid correction of the coarse lines (izc*nyc + iyc) in [lineBegin,lineEnd).
+
+  @param[in]    Af        Fine grid matrix, with the coarse grid correction in mgData->xc.
+  @param[inout] xfv       Fine grid solution values
+  @param[in]    lineBegin First coarse line
+  @param[in]    lineEnd   One past the last coarse line
+*/
+void ComputeProlongationLines(const SparseMatrix & Af, double * const xfv, local_int_t lineBegin, local_int_t lineEnd) {
+  const double * const xcv = Af.mgData->xc->values;
+
+  const local_int_t nxf = Af.geom->nx;
+  const local_int_t nyf = Af.geom->ny;
+  const local_int_t nxc = Af.Ac->geom->nx;
+  const local_int_t nyc = Af.Ac->geom->ny;
+
+  for (local_int_t line=lineBegin; line<lineEnd; ++line) {
+    const local_int_t izc = line/nyc;
+    const local_int_t iyc = line - izc*nyc;
+    double * const xfLine = xfv + (2*izc*nyf + 2*iyc)*nxf;
+    const double * const xcLine = xcv + line*nxc;
+#ifndef HPCG_NO_OPENMP
+#pragma omp simd
+#endif
+    for (local_int_t ixc=0; ixc<nxc; ++ixc) xfLine[2*ixc] += xcLine[ixc];
+  }
+  return;
+}
+
+// Prolongation of a contiguous block of coarse lines, ordered by z-plane
+static void ProlongationKernel(int tid, int numberOfThreads, void * args) {
+  const ProlongationArgs * a = (const ProlongationArgs *) args;
+  const SparseMatrix & Af = a->Af;
+  local_int_t begin, end;
+  ThreadTeamRange(Af.Ac->geom->nz*Af.Ac->geom->ny, tid, numberOfThreads, begin, end);
+  ComputeProlongationLines(Af, a->xfv, begin, end);
+  return;
+}
+
+/*!
+  Routine to apply the coarse grid correction to the fine grid solution.
+
+  Uses the same structured injection mapping as ComputeRestriction: each coarse line is added
+  to every second entry of the matching fine line, without going through mgData->f2cOperator.
+  Falls back to ComputeProlongation_ref while f2cOperator is still allocated.
+
+  @param[in]    Af Fine grid matrix, with the coarse grid correction in mgData->xc.
+  @param[inout] xf Fine grid solution, corrected on exit.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see ComputeProlongation_ref
+*/
+int ComputeProlongation(const SparseMatrix & Af, Vector & xf) {
+
+  if ( Af.mgData->f2cOperator != NULL ) return ComputeProlongation_ref(Af, xf);
+
+  ProlongationArgs args = { Af, xf.values };
+  ThreadTeamRun(ProlongationKernel, &args);
+  return 0;
+}
+
+// Corrects the injected points on the low faces of the subdomain (ixc, iyc or izc zero),
+// the only injected points in the halo that neighbors receive
+static void ComputeProlongationLowFaces(const SparseMatrix & Af, double * const xfv) {
+  const double * const xcv = Af.mgData->xc->values;
+  const local_int_t nxf = Af.geom->nx;
+  const local_int_t nyf = Af.geom->ny;
+  const local_int_t nxc = Af.Ac->geom->nx;
+  const local_int_t nyc = Af.Ac->geom->ny;
+  const local_int_t numberOfLines = Af.Ac->geom->nz*nyc;
+
+#ifndef HPCG_NO_OPENMP
+#pragma omp parallel for
+#endif
+  for (local_int_t line=0; line<numberOfLines; ++line) {
+    const local_int_t izc = line/nyc;
+    const local_int_t iyc = line - izc*nyc;
+    if (izc == 0 || iyc == 0) ComputeProlongationLines(Af, xfv, line, line+1);
+    else xfv[(2*izc*nyf + 2*iyc)*nxf] += xcv[line*nxc];
+  }
+  return;
+}
+
+/*!
+  Routine to apply the coarse grid correction and the first post-smoothing step.
+
+  With the compressed index format on more than one process, the correction is applied inside
+  the pass that computes the upper triangular and halo products of the smoothing step (see
+  ComputeCompressedUpperResidualProlongation), so xf is streamed once for both. Only the
+  injected points on the low faces of the subdomain, which neighbors receive in the halo
+  exchange, are corrected before it. Otherwise the correction and ComputeSYMGS run one after
+  the other.
+
+  @param[in]    Af Fine grid matrix, with the coarse grid correction in mgData->xc.
+  @param[in]    rf Fine grid RHS.
+  @param[inout] xf Fine grid solution, corrected and smoothed on exit.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see ComputeProlongation_ref
+*/
+int ComputeProlongationSYMGS(const SparseMatrix & Af, const Vector & rf, Vector & xf) {
+
+  struct optData *optData = (struct optData *)Af.optimizationData;
+  if ( Af.geom->size == 1 || Af.mgData->f2cOperator != NULL || optData == NULL || optData->cmat == NULL ) {
+    int ierr = ComputeProlongation(Af, xf);
+    if ( ierr != 0 ) return ierr;
+    return ComputeSYMGS(Af, rf, xf);
+  }
+
+  ComputeProlongationLowFaces(Af, xf.values);
+#ifndef HPCG_NO_MPI
+  ExchangeHalo(Af, xf);
+#endif
+  ComputeCompressedUpperResidualProlongation(*optData->cmat, Af.geom->nx, Af.geom->ny,
+                                             Af.Ac->geom->nx, Af.Ac->geom->ny, Af.Ac->geom->nz, Af.mgData->xc->values,
+                                             rf.values, xf.values, optData->dtmp4, optData->dtmp);
+  return ComputeSYMGS_Sweeps(Af, xf);
+}
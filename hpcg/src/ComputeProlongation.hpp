@@ -0,0 +1,35 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+#ifndef COMPUTEPROLONGATION_HPP
+#define COMPUTEPROLONGATION_HPP
+#include "Vector.hpp"
+#include "SparseMatrix.hpp"
+int ComputeProlongation(const SparseMatrix & Af, Vector & xf);
+void ComputeProlongationLines(const SparseMatrix & Af, double * const xfv, local_int_t lineBegin, local_int_t lineEnd);
+int ComputeProlongationSYMGS(const SparseMatrix & Af, const Vector & rf, Vector & xf);
+#endif // COMPUTEPROLONGATION_HPP
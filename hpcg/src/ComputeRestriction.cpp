@@ -0,0 +1,146 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeRestriction.cpp
+
+ HPCG routine
+ */
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#ifndef HPCG_NO_MPI
+#include "ExchangeHalo.hpp"
+#endif
+
+#include "ComputeRestriction.hpp"
+#include "ComputeRestriction_ref.hpp"
+#include "ThreadTeam.hpp"
+
+struct RestrictionArgs {
+  const SparseMatrix & A;
+  const double * rfv;
+};
+
+// Restriction of a contiguous block of coarse lines, ordered by z-plane
+static void RestrictionKernel(int tid, int numberOfThreads, void * args) {
+  const RestrictionArgs * a = (const RestrictionArgs *) args;
+  const SparseMatrix & A = a->A;
+  const double * const rfv = a->rfv;
+  const double * const Axfv = A.mgData->Axf->values;
+  double * const rcv = A.mgData->rc->values;
+
+  const local_int_t nxf = A.geom->nx;
+  const local_int_t nyf = A.geom->ny;
+  const local_int_t nxc = A.Ac->geom->nx;
+  const local_int_t nyc = A.Ac->geom->ny;
+  const local_int_t nzc = A.Ac->geom->nz;
+
+  local_int_t begin, end;
+  ThreadTeamRange(nzc*nyc, tid, numberOfThreads, begin, end);
+  for (local_int_t line=begin; line<end; ++line) {
+    const local_int_t izc = line/nyc;
+    const local_int_t iyc = line - izc*nyc;
+    const double * const rfLine = rfv + (2*izc*nyf + 2*iyc)*nxf;
+    const double * const AxfLine = Axfv + (2*izc*nyf + 2*iyc)*nxf;
+    double * const rcLine = rcv + line*nxc;
+#ifndef HPCG_NO_OPENMP
+#pragma omp simd
+#endif
+    for (local_int_t ixc=0; ixc<nxc; ++ixc) rcLine[ixc] = rfLine[2*ixc] - AxfLine[2*ixc];
+  }
+  return;
+}
+
+/*!
+  Routine to compute the coarse residual vector.
+
+  On the structured grids built by GenerateCoarseProblem coarse point (ixc,iyc,izc) is injected
+  from fine point (2*ixc,2*iyc,2*izc), so the fine index of each coarse row is computed from the
+  grid dimensions instead of being loaded from mgData->f2cOperator. Each thread takes a contiguous
+  block of coarse lines, in z-plane order, and walks every line of x with a stride-2 access into
+  rf and Axf.
+
+  OptimizeProblem releases f2cOperator once the reference code no longer needs it; while it is
+  still present this routine falls back to the index array path of ComputeRestriction_ref.
+
+  @param[in]    A  Fine grid matrix, with the fine grid residual product in mgData->Axf.
+  @param[in]    rf Fine grid RHS.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see ComputeRestriction_ref
+*/
+int ComputeRestriction(const SparseMatrix & A, const Vector & rf) {
+
+  if ( A.mgData->f2cOperator != NULL ) return ComputeRestriction_ref(A, rf);
+
+  RestrictionArgs args = { A, rf.values };
+  ThreadTeamRun(RestrictionKernel, &args);
+  return 0;
+}
+
+/*!
+  Routine to compute the coarse residual vector directly from the smoothed fine grid solution.
+
+  The reference V-cycle forms the full fine grid product Axf and then reads every 8th entry
+  of it. Here the residual rf - A*xf is only evaluated at the fine points that are injected
+  into the coarse grid and written straight into mgData->rc, so Axf is neither computed nor
+  stored for the other rows.
+
+  Requires the compressed index format (optData->cmat) for row access to the local matrix.
+
+  @param[in]    A  Fine grid matrix, with mgData->rc.
+  @param[in]    rf Fine grid RHS.
+  @param[inout] xf Fine grid solution after pre-smoothing; its halo values are refreshed.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see ComputeRestriction_ref
+*/
+int ComputeResidualRestriction(const SparseMatrix & A, const Vector & rf, Vector & xf) {
+
+  struct optData *optData = (struct optData *)A.optimizationData;
+  if ( optData == NULL || optData->cmat == NULL ) return 1;
+
+#ifndef HPCG_NO_MPI
+  if ( A.geom->size > 1 ) ExchangeHalo(A, xf);
+#endif
+
+  if ( A.mgData->f2cOperator != NULL ) {
+    ComputeCompressedResidualRows(*optData->cmat, A.mgData->f2cOperator, A.mgData->rc->localLength,
+                                  rf.values, xf.values, A.mgData->rc->values);
+  } else {
+    ComputeCompressedResidualInjection(*optData->cmat, A.geom->nx, A.geom->ny,
+                                       A.Ac->geom->nx, A.Ac->geom->ny, A.Ac->geom->nz,
+                                       rf.values, xf.values, A.mgData->rc->values);
+  }
+  return 0;
+}
@@ -76,6 +76,12 @@ int ComputeSPMV( const SparseMatrix & A, Vector & x, Vector & y)
     ExchangeHalo(A,x);
     #endif
 
+    if ( optData->cmat != NULL )
+    {
+        ComputeCompressedSPMV(*optData->cmat, x.values, y.values, NULL);
+        return 0;
+    }
+
     status = mkl_sparse_d_mv ( SPARSE_OPERATION_NON_TRANSPOSE, 1.0, csrA, descr, x.values, 0.0, y.values );
 
     if ( A.geom->size > 1 )
@@ -111,6 +117,12 @@ int ComputeSPMV_DOT( const SparseMatrix & A, Vector & x, Vector & y, double & pA
     ExchangeHalo(A,x);
     #endif
 
+    if ( optData->cmat != NULL )
+    {
+        ComputeCompressedSPMV(*optData->cmat, x.values, y.values, &pAp);
+        return 0;
+    }
+
     status = mkl_sparse_d_dotmv ( SPARSE_OPERATION_NON_TRANSPOSE, 1.0, csrA, descr, x.values, 0.0, y.values, &pAp );
 
     if ( A.geom->size > 1 )
@@ -33,6 +33,7 @@
 
 #include "ComputeSYMGS.hpp"
 #include "ComputeSYMGS_ref.hpp"
+#include "ThreadTeam.hpp"
 #ifndef HPCG_NO_OPENMP
 #include <omp.h>
 #endif
@@ -90,6 +91,13 @@ int ComputeSYMGS( const SparseMatrix & A, const Vector & r, Vector & x)
         ExchangeHalo(A,x);
         #endif
 
+        if ( optData->cmat != NULL )
+        {
+            // One pass over the compressed matrix gives both the upper product and the halo contribution
+            ComputeCompressedUpperResidual(*optData->cmat, r.values, x.values, optData->dtmp4, optData->dtmp);
+            return ComputeSYMGS_Sweeps(A, x);
+        }
+
         status = mkl_sparse_d_mv(SPARSE_OPERATION_NON_TRANSPOSE, 1.0, csrA, descr, x.values, 0.0, optData->dtmp4);
 
         descr.type = SPARSE_MATRIX_TYPE_GENERAL;
@@ -109,19 +117,7 @@ int ComputeSYMGS( const SparseMatrix & A, const Vector & r, Vector & x)
         #pragma ivdep
         for (local_int_t i=0; i < optData->nrow_b; i++) optData->dtmp[optData->bmap[i]] -= optData->dtmp2[i];
 
-        descr.type = SPARSE_MATRIX_TYPE_SYMMETRIC;
-        descr.mode = SPARSE_FILL_MODE_LOWER;
-
-        mkl_sparse_d_trsv ( SPARSE_OPERATION_NON_TRANSPOSE, 1.0, csrA, descr, optData->dtmp, optData->dtmp3);
-
-        #ifndef HPCG_NO_OPENMP
-        #pragma omp parallel for
-        #endif
-        for ( local_int_t i = 0; i < A.localNumberOfRows; i ++ )
-            optData->dtmp3[i] = optData->dtmp3[i]*optData->diag[i] + optData->dtmp4[i];
-
-        descr.mode = SPARSE_FILL_MODE_UPPER;
-        mkl_sparse_d_trsv ( SPARSE_OPERATION_NON_TRANSPOSE, 1.0, csrA, descr, optData->dtmp3, x.values);
+        return ComputeSYMGS_Sweeps(A, x);
     } else
     {
         descr.type = SPARSE_MATRIX_TYPE_SYMMETRIC;
@@ -131,6 +127,47 @@ int ComputeSYMGS( const SparseMatrix & A, const Vector & r, Vector & x)
     return 0;
 }
 
+// dtmp3 = dtmp3*diag + dtmp4 between the two triangular solves
+static void ScaleDiagonalKernel(int tid, int numberOfThreads, void * args) {
+    const SparseMatrix & A = *(const SparseMatrix *) args;
+    const struct optData *optData = (const struct optData *)A.optimizationData;
+    local_int_t begin, end;
+    ThreadTeamRange(A.localNumberOfRows, tid, numberOfThreads, begin, end);
+    for ( local_int_t i = begin; i < end; i ++ )
+        optData->dtmp3[i] = optData->dtmp3[i]*optData->diag[i] + optData->dtmp4[i];
+}
+
+/*!
+  Finishes a distributed symmetric Gauss-Seidel step once its first pass is done.
+
+  On entry optData->dtmp holds r - U*x - B*x_ext (U the strictly upper triangle, B the halo
+  columns) and optData->dtmp4 holds U*x. The forward and backward triangular solves then
+  produce the new x.
+
+  @param[in]    A the known system matrix
+  @param[inout] x On exit contains the result of the symmetric GS step
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+int ComputeSYMGS_Sweeps( const SparseMatrix & A, Vector & x )
+{
+    struct optData *optData = (struct optData *)A.optimizationData;
+    struct matrix_descr descr;
+    sparse_matrix_t csrA = (sparse_matrix_t)optData->csrA;
+
+    descr.type = SPARSE_MATRIX_TYPE_SYMMETRIC;
+    descr.mode = SPARSE_FILL_MODE_LOWER;
+    descr.diag = SPARSE_DIAG_NON_UNIT;
+
+    mkl_sparse_d_trsv ( SPARSE_OPERATION_NON_TRANSPOSE, 1.0, csrA, descr, optData->dtmp, optData->dtmp3);
+
+    ThreadTeamRun(ScaleDiagonalKernel, (void *) &A);
+
+    descr.mode = SPARSE_FILL_MODE_UPPER;
+    mkl_sparse_d_trsv ( SPARSE_OPERATION_NON_TRANSPOSE, 1.0, csrA, descr, optData->dtmp3, x.values);
+    return 0;
+}
+
 int ComputeSYMGS_MV( const SparseMatrix & A, const Vector & r, Vector & x, Vector & y )
 {
     sparse_status_t status = SPARSE_STATUS_SUCCESS;
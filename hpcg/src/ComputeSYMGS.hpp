@@ -32,6 +32,7 @@
 
 
 int ComputeSYMGS( const SparseMatrix  & A, const Vector & r, Vector & x);
+int ComputeSYMGS_Sweeps( const SparseMatrix  & A, Vector & x);
 int ComputeSYMGS_MV( const SparseMatrix  & A, const Vector & r, Vector & x, Vector & y);
 int ComputeSPMV_ref( const SparseMatrix & A, Vector  & x, Vector & y);
 
@@ -0,0 +1,109 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file DeepHalo.cpp
+
+ HPCG routine
+ */
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#include "DeepHalo.hpp"
+#include "TrackedAllocator.hpp"
+
+/*!
+  Allocates a vector on the extended subdomain of a deep halo.
+
+  @param[in]  halo          The deep halo
+  @param[out] v             The vector, zero-filled
+  @param[in]  minimumLength Smallest length to allocate, e.g. the column count of the matrix
+                            when the vector is also used by the single layer kernels
+*/
+void InitializeDeepHaloVector(const DeepHalo & halo, Vector & v, local_int_t minimumLength) {
+  local_int_t length = halo.extendedLength > minimumLength ? halo.extendedLength : minimumLength;
+  InitializeVector(v, length);
+  ZeroVector(v);
+  return;
+}
+
+/*!
+  Computes y = A*x on the rows of the extended subdomain within the given number of rings.
+
+  x must be valid on rings+1 rings, which holds for rings = width-1 right after
+  ExchangeDeepHalo and shrinks by one ring for every product computed since.
+
+  @param[in]  halo  The deep halo
+  @param[in]  x     Input vector on the extended subdomain
+  @param[out] y     Result, rows 0 to DeepHaloRows(halo, rings)-1 are written
+  @param[in]  rings Number of ghost rings to compute, 0 to width-1
+
+  @return Returns zero on success and a non-zero value if rings is out of range.
+*/
+int ComputeDeepHaloSPMV(const DeepHalo & halo, const Vector & x, Vector & y, int rings) {
+  if (rings < 0 || rings >= halo.width) return 1;
+  const local_int_t nrow = DeepHaloRows(halo, rings);
+  const local_int_t * const rowStart = halo.rowStart;
+  const local_int_t * const columns = halo.columns;
+  const double * const values = halo.values;
+  const double * const xv = x.values;
+  double * const yv = y.values;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<nrow; ++i) {
+    double sum = 0.0;
+    for (local_int_t k=rowStart[i]; k<rowStart[i+1]; ++k) sum += values[k]*xv[columns[k]];
+    yv[i] = sum;
+  }
+  return 0;
+}
+
+/*!
+  Deallocates a deep halo built by SetupDeepHalo.
+
+  @param[in] halo The deep halo, may be NULL
+*/
+void DeleteDeepHalo(DeepHalo * halo) {
+  if (halo == NULL) return;
+  TrackedFree(halo->ringStart);
+  TrackedFree(halo->rowStart);
+  TrackedFree(halo->columns);
+  TrackedFree(halo->values);
+  TrackedFree(halo->neighbors);
+  TrackedFree(halo->sendLength);
+  TrackedFree(halo->receiveLength);
+  TrackedFree(halo->elementsToSend);
+  TrackedFree(halo->elementsToReceive);
+  TrackedFree(halo->sendBuffer);
+  TrackedFree(halo->receiveBuffer);
+  delete halo;
+  return;
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file DeepHalo.hpp
+
+ HPCG ghost region of configurable width for kernels on the extended subdomain
+ */
+
+#ifndef DEEPHALO_HPP
+#define DEEPHALO_HPP
+
+#include "Geometry.hpp"
+#include "Vector.hpp"
+
+#define HPCG_DEEP_HALO_MAX_WIDTH 8 //!< largest supported ghost width
+
+/*!
+  Rows of the operator on the subdomain extended by width ghost layers, and the lists needed
+  to fill all layers with one message per neighbor.
+
+  The extended points are numbered owned rows first, in the usual local order, followed by the
+  ghost points ring by ring: ring d holds the points at distance d from the owned box. A vector
+  on the extended subdomain therefore starts with an ordinary local vector. Row i references
+  columns of ring d+1 at most, so rows are only stored for rings 0 to width-1.
+*/
+struct DeepHalo_STRUCT {
+  int width;                   //!< number of ghost layers
+  local_int_t localNumberOfRows;  //!< number of owned rows
+  local_int_t extendedLength;  //!< number of points of the extended subdomain
+  local_int_t * ringStart;     //!< width+2 entries, first extended index of every ring
+  local_int_t * rowStart;      //!< ringStart[width]+1 offsets into columns and values
+  local_int_t * columns;       //!< extended column indices
+  double * values;             //!< matrix values
+  int numberOfNeighbors;       //!< number of ranks exchanged with
+  int * neighbors;             //!< their ranks
+  local_int_t * sendLength;    //!< points sent to each neighbor
+  local_int_t * receiveLength; //!< points received from each neighbor
+  local_int_t totalToBeSent;
+  local_int_t totalToBeReceived;
+  local_int_t * elementsToSend;   //!< owned indices packed for the neighbors
+  local_int_t * elementsToReceive; //!< ghost indices filled from the receive buffer
+  double * sendBuffer;
+  double * receiveBuffer;
+};
+typedef struct DeepHalo_STRUCT DeepHalo;
+
+/*!
+  Returns the number of leading extended rows that lie within the given number of rings of
+  the owned box (rings = 0 gives the owned rows).
+*/
+inline local_int_t DeepHaloRows(const DeepHalo & halo, int rings) {
+  return halo.ringStart[rings+1];
+}
+
+void InitializeDeepHaloVector(const DeepHalo & halo, Vector & v, local_int_t minimumLength);
+int ComputeDeepHaloSPMV(const DeepHalo & halo, const Vector & x, Vector & y, int rings);
+void DeleteDeepHalo(DeepHalo * halo);
+
+#endif // DEEPHALO_HPP
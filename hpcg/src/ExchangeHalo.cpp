@@ -36,7 +36,89 @@
 #include <mpi.h>
 #include "Geometry.hpp"
 #include "ExchangeHalo.hpp"
+#include "ThreadTeam.hpp"
+#include "CommThread.hpp"
+#include "HaloPrecision.hpp"
+#include "HaloDatatypes.hpp"
 #include <cstdlib>
+#include <vector>
+
+// Exchanges started on this rank and the number of bytes they sent
+static long long haloExchanges = 0;
+static double haloBytesSent = 0.0;
+
+// True if this exchange sends the reduced precision encoding of the level
+static inline bool ReducedHalo(const SparseMatrix & A) {
+  return A.haloPrecision != NULL && A.haloPrecision->mode != HPCG_HALO_DOUBLE && InPreconditionerHalo();
+}
+
+static inline void CountHaloExchange(const SparseMatrix & A, bool reduced) {
+  double bytes = sizeof(double)*(double) A.totalToBeSent;
+  if (reduced) {
+    bytes = 0.0;
+    for (int i = 0; i < A.numberOfSendNeighbors; i++) bytes += HaloEncodedBytes(A.haloPrecision->mode, A.sendLength[i]);
+  }
+  haloExchanges++;
+  haloBytesSent += bytes;
+  if (A.haloPrecision != NULL) {
+    A.haloPrecision->exchanges++;
+    A.haloPrecision->bytesOnWire += bytes;
+  }
+}
+
+// True if the boundary values are sent straight from x with the datatypes of the level;
+// the neighborhood collective always sends a packed buffer
+static inline bool ZeroCopyHalo(const SparseMatrix & A) {
+  return A.haloDatatypes != NULL && A.haloDatatypes->mode == HPCG_HALO_PACK_DATATYPE && A.neighborHalo == NULL;
+}
+
+#ifndef HPCG_LOCAL_LONG_LONG
+struct HaloPackArgs {
+  const SparseMatrix & A;
+  const double * xv;
+};
+
+// Gathers the boundary values of x into the send buffer
+static void HaloPackKernel(int tid, int numberOfThreads, void * args) {
+  const HaloPackArgs * a = (const HaloPackArgs *) args;
+  double * const sendBuffer = a->A.sendBuffer;
+  const local_int_t * const elementsToSend = a->A.elementsToSend;
+  const double * const xv = a->xv;
+  local_int_t begin, end;
+  ThreadTeamRange(a->A.totalToBeSent, tid, numberOfThreads, begin, end);
+  #pragma ivdep
+  for (local_int_t i=begin; i<end; i++) sendBuffer[i] = xv[elementsToSend[i]];
+}
+
+// Copies the z slices of the send boxes into the send buffer
+static void StridedPackKernel(int tid, int numberOfThreads, void * args) {
+  const HaloPackArgs * a = (const HaloPackArgs *) args;
+  const HaloDatatypes & hd = *a->A.haloDatatypes;
+  local_int_t begin, end;
+  ThreadTeamRange(hd.sliceStart[hd.numberOfNeighbors], tid, numberOfThreads, begin, end);
+  StridedHaloPack(hd, a->xv, a->A.sendBuffer, begin, end);
+}
+#endif
+
+/*!
+  Packs the values of x sent to the neighbors into A.sendBuffer, with the strided box kernels
+  on levels given boxes by SetupHaloDatatypes and through elementsToSend otherwise.
+
+  @param[in] A  The known system matrix
+  @param[in] xv The values of the vector whose halo is exchanged
+ */
+void PackHalo(const SparseMatrix & A, const double * xv) {
+#ifndef HPCG_LOCAL_LONG_LONG
+  HaloPackArgs args = { A, xv };
+  if ( A.haloDatatypes != NULL )
+    ThreadTeamRun(StridedPackKernel, &args);
+  else
+    ThreadTeamRun(HaloPackKernel, &args);
+#else
+  for (local_int_t i=0; i<A.totalToBeSent; i++) A.sendBuffer[i] = xv[A.elementsToSend[i]];
+#endif
+  return;
+}
 
 /*!
   Communicates data that is at the border of the part of the domain assigned to this processor.
@@ -50,6 +132,7 @@ void ExchangeHalo(const SparseMatrix & A, Vector & x) {
   if ( A.geom->size > 1 )
   {
 #ifdef HPCG_LOCAL_LONG_LONG
+  CountHaloExchange(A, false);
   // using MPI_ISend and MPI_IRecv since MPI_Alltoallv cannot handle long long arguments
 
   local_int_t localNumberOfRows = A.localNumberOfRows;
@@ -96,25 +179,284 @@ void ExchangeHalo(const SparseMatrix & A, Vector & x) {
 
   delete [] request;
 #else
+      if ( UseCommThread() || ReducedHalo(A) || A.neighborHalo != NULL || A.rmaHalo != NULL || ZeroCopyHalo(A) ) {
+        // Only the agent makes MPI progress calls while the solver runs, encoded halos and
+        // datatypes are sent as one message per neighbor, and the other backends are split-phase
+        BeginExchangeHalo(A, x);
+        EndExchangeHalo(A, x);
+        return;
+      }
+      CountHaloExchange(A, false);
+
       local_int_t localNumberOfRows = A.localNumberOfRows;
       double * sendBuffer = A.sendBuffer;
-      local_int_t totalToBeSent = A.totalToBeSent;
-      local_int_t * elementsToSend = A.elementsToSend;
 
       double * const xv = x.values;
 
       double * x_external = (double *) xv + localNumberOfRows;
 
-#ifndef HPCG_NO_OPENMP
-      #pragma omp parallel for
-#endif
-      #pragma ivdep
-      for (local_int_t i=0; i<totalToBeSent; i++) sendBuffer[i] = xv[elementsToSend[i]];
+      PackHalo(A, xv);
 
       MPI_Alltoallv( sendBuffer, A.scounts, A.sdispls, MPI_DOUBLE, x_external, A.rcounts, A.rdispls, MPI_DOUBLE, MPI_COMM_WORLD);
 #endif
   }
   return;
 }
+
+#ifndef HPCG_LOCAL_LONG_LONG
+struct HaloPostArgs {
+  const SparseMatrix * A;
+  double * xv;
+  bool reduced;
+  int window; // window of the one-sided exchange, -1 for a two-sided one
+};
+
+// Posts the receives and the sends of a packed halo exchange
+static int PostHaloMessages(void * args, MPI_Request * requests) {
+  const HaloPostArgs * a = (const HaloPostArgs *) args;
+  const SparseMatrix & A = *a->A;
+  const int num_neighbors = A.numberOfSendNeighbors;
+  const int MPI_MY_TAG = 99;
+
+  double * x_external = a->xv + A.localNumberOfRows;
+  for (int i = 0; i < num_neighbors; i++) {
+    MPI_Irecv(x_external, A.receiveLength[i], MPI_DOUBLE, A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, requests+i);
+    x_external += A.receiveLength[i];
+  }
+  double * sendBuffer = A.sendBuffer;
+  for (int i = 0; i < num_neighbors; i++) {
+    MPI_Isend(sendBuffer, A.sendLength[i], MPI_DOUBLE, A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, requests+num_neighbors+i);
+    sendBuffer += A.sendLength[i];
+  }
+  return 2*num_neighbors;
+}
+
+// Posts the receives, and the sends straight from x with the datatypes of the level
+static int PostDatatypeHaloMessages(void * args, MPI_Request * requests) {
+  const HaloPostArgs * a = (const HaloPostArgs *) args;
+  const SparseMatrix & A = *a->A;
+  const HaloDatatypes & hd = *A.haloDatatypes;
+  const int num_neighbors = A.numberOfSendNeighbors;
+  const int MPI_MY_TAG = 99;
+
+  double * x_external = a->xv + A.localNumberOfRows;
+  for (int i = 0; i < num_neighbors; i++) {
+    MPI_Irecv(x_external, A.receiveLength[i], MPI_DOUBLE, A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, requests+i);
+    x_external += A.receiveLength[i];
+  }
+  for (int i = 0; i < num_neighbors; i++)
+    MPI_Isend(a->xv, 1, hd.types[i], A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, requests+num_neighbors+i);
+  return 2*num_neighbors;
+}
+
+// Posts the receives and the sends of an encoded halo exchange
+static int PostEncodedHaloMessages(void * args, MPI_Request * requests) {
+  const HaloPostArgs * a = (const HaloPostArgs *) args;
+  const SparseMatrix & A = *a->A;
+  const HaloPrecision & hp = *A.haloPrecision;
+  const int num_neighbors = A.numberOfSendNeighbors;
+  const int MPI_MY_TAG = 99;
+
+  for (int i = 0; i < num_neighbors; i++)
+    MPI_Irecv(hp.receiveBytes + hp.receiveOffset[i], HaloEncodedBytes(hp.mode, A.receiveLength[i]), MPI_BYTE, A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, requests+i);
+  for (int i = 0; i < num_neighbors; i++)
+    MPI_Isend(hp.sendBytes + hp.sendOffset[i], HaloEncodedBytes(hp.mode, A.sendLength[i]), MPI_BYTE, A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, requests+num_neighbors+i);
+  return 2*num_neighbors;
+}
+
+// Posts the neighborhood collective of a packed halo exchange
+static int PostNeighborHalo(void * args, MPI_Request * requests) {
+  const HaloPostArgs * a = (const HaloPostArgs *) args;
+  const SparseMatrix & A = *a->A;
+  NeighborHalo & nh = *A.neighborHalo;
+
+#if MPI_VERSION >= 4
+  if (nh.persistent != MPI_REQUEST_NULL) {
+    MPI_Start(&nh.persistent);
+    requests[0] = nh.persistent;
+    return 1;
+  }
+#endif
+  MPI_Ineighbor_alltoallv(A.sendBuffer, nh.sendCounts, nh.sendDispls, MPI_DOUBLE, a->xv + A.localNumberOfRows,
+                          nh.receiveCounts, nh.receiveDispls, MPI_DOUBLE, nh.comm, requests);
+  return 1;
+}
+
+// Opens the exposure and access epochs of a window and puts the packed values into the
+// ghost regions of the neighbors
+static void StartRmaHalo(const SparseMatrix & A, int window, const double * xv) {
+  RmaHalo & rh = *A.rmaHalo;
+  MPI_Win win = rh.windows[window];
+  MPI_Win_post(rh.group, 0, win);
+  MPI_Win_start(rh.group, 0, win);
+  double * sendBuffer = A.sendBuffer;
+  for (int i = 0; i < A.numberOfSendNeighbors; i++) {
+    if ( ZeroCopyHalo(A) )
+      MPI_Put(xv, 1, A.haloDatatypes->types[i], A.neighbors[i], rh.targetOffset[i], A.sendLength[i], MPI_DOUBLE, win);
+    else
+      MPI_Put(sendBuffer, A.sendLength[i], MPI_DOUBLE, A.neighbors[i], rh.targetOffset[i], A.sendLength[i], MPI_DOUBLE, win);
+    sendBuffer += A.sendLength[i];
+  }
+  rh.exchanges++;
+}
+
+// The split-phase exchange in flight, at most one at a time
+static HaloPostArgs haloArgs = { NULL, NULL, false, -1 };
+static CommRequest haloRequest;
+#endif
+
+/*!
+  Starts a halo exchange without waiting for it: packs the send buffer, unless the level
+  sends with MPI datatypes, and posts the receives and sends, the neighborhood collective or
+  the one-sided puts selected by SetupHaloBackend, through the communication agent when it
+  is running. Inside the MG preconditioner, levels given a reduced encoding by
+  SetupHaloPrecision send the encoded values point-to-point instead, and EndExchangeHalo
+  decodes them. The halo part of x must not be read, and the boundary values of x must not
+  be changed, until EndExchangeHalo returns.
+
+  @param[in]    A The known system matrix
+  @param[inout] x The vector whose halo is updated
+
+  @see EndExchangeHalo
+ */
+void BeginExchangeHalo(const SparseMatrix & A, Vector & x) {
+
+  if ( A.geom->size == 1 ) return;
+#ifdef HPCG_LOCAL_LONG_LONG
+  ExchangeHalo(A, x);
+#else
+  const bool reduced = ReducedHalo(A);
+  CountHaloExchange(A, reduced);
+  haloArgs.A = &A;
+  haloArgs.xv = x.values;
+  haloArgs.reduced = reduced;
+  haloArgs.window = -1;
+  if ( reduced ) {
+    const HaloPrecision & hp = *A.haloPrecision;
+    const local_int_t * elementsToSend = A.elementsToSend;
+    for (int i = 0; i < A.numberOfSendNeighbors; i++) {
+      EncodeHalo(hp.mode, x.values, elementsToSend, A.sendLength[i], hp.sendBytes + hp.sendOffset[i]);
+      elementsToSend += A.sendLength[i];
+    }
+    CommPost(PostEncodedHaloMessages, &haloArgs, 2*A.numberOfSendNeighbors, haloRequest);
+    return;
+  }
+  const bool zeroCopy = ZeroCopyHalo(A);
+  if ( !zeroCopy ) PackHalo(A, x.values);
+  // Vectors without a window, and all vectors while the agent owns MPI, go two-sided
+  if ( A.rmaHalo != NULL && !UseCommThread() ) haloArgs.window = FindHaloWindow(*A.rmaHalo, x.values + A.localNumberOfRows);
+  if ( haloArgs.window >= 0 ) {
+    StartRmaHalo(A, haloArgs.window, x.values);
+    return;
+  }
+  if ( A.neighborHalo != NULL )
+    CommPost(PostNeighborHalo, &haloArgs, 1, haloRequest);
+  else
+    CommPost(zeroCopy ? PostDatatypeHaloMessages : PostHaloMessages, &haloArgs, 2*A.numberOfSendNeighbors, haloRequest);
+#endif
+  return;
+}
+
+/*!
+  Completes the halo exchange started by BeginExchangeHalo.
+
+  @param[in]    A The known system matrix
+  @param[inout] x The vector whose halo is updated
+
+  @see BeginExchangeHalo
+ */
+void EndExchangeHalo(const SparseMatrix & A, Vector & x) {
+
+  if ( A.geom->size == 1 ) return;
+#ifndef HPCG_LOCAL_LONG_LONG
+  if ( haloArgs.window >= 0 ) {
+    MPI_Win win = A.rmaHalo->windows[haloArgs.window];
+    MPI_Win_complete(win);
+    MPI_Win_wait(win);
+    haloArgs.window = -1;
+    return;
+  }
+  CommWait(haloRequest);
+  if ( haloArgs.reduced ) {
+    const HaloPrecision & hp = *A.haloPrecision;
+    double * x_external = x.values + A.localNumberOfRows;
+    for (int i = 0; i < A.numberOfSendNeighbors; i++) {
+      DecodeHalo(hp.mode, hp.receiveBytes + hp.receiveOffset[i], A.receiveLength[i], x_external);
+      x_external += A.receiveLength[i];
+    }
+  } else if ( A.neighborHalo != NULL && A.neighborHalo->receiveBuffer != NULL ) {
+    // The persistent collective is bound to the receive buffer of the level
+    const double * received = A.neighborHalo->receiveBuffer;
+    double * x_external = x.values + A.localNumberOfRows;
+    const local_int_t numberOfReceived = A.neighborHalo->receiveDispls[A.numberOfSendNeighbors];
+    for (local_int_t i = 0; i < numberOfReceived; i++) x_external[i] = received[i];
+  }
+#endif
+  return;
+}
+
+/*!
+  Fills all ghost layers of a vector on the extended subdomain of the deep halo of A, with
+  one message per neighbor whatever the width.
+
+  @param[in]    A The known system matrix, with a deep halo built by SetupDeepHalo
+  @param[inout] x Vector on the extended subdomain, see InitializeDeepHaloVector
+
+  @see SetupDeepHalo
+ */
+void ExchangeDeepHalo(const SparseMatrix & A, Vector & x) {
+
+  const struct optData * optData = (const struct optData *) A.optimizationData;
+  if ( optData == NULL || optData->deepHalo == NULL ) return;
+  const DeepHalo & halo = *optData->deepHalo;
+  const int num_neighbors = halo.numberOfNeighbors;
+  if ( num_neighbors == 0 ) return;
+  haloExchanges++;
+  haloBytesSent += sizeof(double)*(double) halo.totalToBeSent;
+
+  const int MPI_MY_TAG = 98;
+  double * const xv = x.values;
+  std::vector<MPI_Request> request(2*num_neighbors);
+
+  double * receiveBuffer = halo.receiveBuffer;
+  for (int i = 0; i < num_neighbors; i++) {
+    MPI_Irecv(receiveBuffer, halo.receiveLength[i], MPI_DOUBLE, halo.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, &request[i]);
+    receiveBuffer += halo.receiveLength[i];
+  }
+
+  double * const sendBuffer = halo.sendBuffer;
+  const local_int_t * const elementsToSend = halo.elementsToSend;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i = 0; i < halo.totalToBeSent; i++) sendBuffer[i] = xv[elementsToSend[i]];
+
+  double * buffer = sendBuffer;
+  for (int i = 0; i < num_neighbors; i++) {
+    MPI_Isend(buffer, halo.sendLength[i], MPI_DOUBLE, halo.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, &request[num_neighbors+i]);
+    buffer += halo.sendLength[i];
+  }
+  MPI_Waitall(2*num_neighbors, &request[0], MPI_STATUSES_IGNORE);
+
+  const double * const received = halo.receiveBuffer;
+  const local_int_t * const elementsToReceive = halo.elementsToReceive;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i = 0; i < halo.totalToBeReceived; i++) xv[elementsToReceive[i]] = received[i];
+  return;
+}
+
+/*!
+  Reports the halo traffic generated on this rank so far.
+
+  @param[out] exchanges Number of halo exchanges started
+  @param[out] bytesSent Number of bytes sent by these exchanges
+ */
+void GetHaloExchangeStats(long long & exchanges, double & bytesSent) {
+  exchanges = haloExchanges;
+  bytesSent = haloBytesSent;
+  return;
+}
 #endif
 // ifndef HPCG_NO_MPI
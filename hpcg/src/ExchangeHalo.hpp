@@ -30,4 +30,9 @@
 #include "SparseMatrix.hpp"
 #include "Vector.hpp"
 void ExchangeHalo(const SparseMatrix & A, Vector & x);
+void PackHalo(const SparseMatrix & A, const double * xv);
+void BeginExchangeHalo(const SparseMatrix & A, Vector & x);
+void EndExchangeHalo(const SparseMatrix & A, Vector & x);
+void ExchangeDeepHalo(const SparseMatrix & A, Vector & x);
+void GetHaloExchangeStats(long long & exchanges, double & bytesSent);
 #endif // EXCHANGEHALO_HPP
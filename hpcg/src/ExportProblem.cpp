@@ -0,0 +1,371 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ExportProblem.cpp
+
+ HPCG routine
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#include "ExchangeHalo.hpp"
+#endif
+
+#include "ExportProblem.hpp"
+#include "RowIndexing.hpp"
+#include "TrackedAllocator.hpp"
+
+#define HPCG_EXPORT_HEADER_BYTES 64
+#define HPCG_EXPORT_VALUE_WIDTH 25 // "%24.16e\n", so every vector entry of a Matrix Market file has a fixed offset
+
+/*!
+  Header of the binary files: an 8-byte tag followed by 64-bit fields, padded to 64 bytes.
+  A.bin holds the global row indices, then the global column indices (both int64, 0-based),
+  then the values (double) of its nnz entries; a vector file holds its length values in the
+  global row order.
+*/
+struct ExportHeader {
+  char magic[8];           //!< "HPCGCOO1" for the matrix, "HPCGVEC1" for a vector
+  long long rows;          //!< global rows
+  long long columns;       //!< global columns, 1 for a vector
+  long long nnz;           //!< stored entries
+  long long indexBytes;    //!< 8
+  long long valueBytes;    //!< 8
+  long long reserved[2];
+};
+
+#ifndef HPCG_NO_MPI
+typedef MPI_File ExportFile;
+#else
+typedef FILE * ExportFile;
+#endif
+
+static int OpenExportFile(const char * directory, const char * name, ExportFile & file) {
+  char path[1100];
+  snprintf(path, sizeof(path), "%s/%s", directory, name);
+  int ierr = 0;
+#ifndef HPCG_NO_MPI
+  // A stale longer file would keep its tail; the delete fails harmlessly when there is none
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank == 0) MPI_File_delete(path, MPI_INFO_NULL);
+  MPI_Barrier(MPI_COMM_WORLD);
+  ierr = MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_CREATE|MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS;
+#else
+  file = fopen(path, "wb");
+  ierr = (file == NULL);
+#endif
+  return ierr;
+}
+
+static int CloseExportFile(ExportFile & file) {
+#ifndef HPCG_NO_MPI
+  return MPI_File_close(&file) != MPI_SUCCESS;
+#else
+  return fclose(file) != 0;
+#endif
+}
+
+/*
+  Independent write of bytes at an offset, for the headers written by rank 0 and the text
+  blocks of the Matrix Market files, whose lengths differ between ranks.
+*/
+static int WriteBytesAt(ExportFile file, long long offset, const char * data, long long bytes) {
+  int ierr = 0;
+#ifndef HPCG_NO_MPI
+  const long long chunk = 1LL << 30;
+  for (long long done = 0; done < bytes && ierr == 0; done += chunk) {
+    const int count = (int) ((bytes - done < chunk) ? bytes - done : chunk);
+    ierr = MPI_File_write_at(file, offset + done, (void *) (data + done), count, MPI_BYTE, MPI_STATUS_IGNORE) != MPI_SUCCESS;
+  }
+#else
+  ierr = fseek(file, (long) offset, SEEK_SET) != 0 || fwrite(data, 1, bytes, file) != (size_t) bytes;
+#endif
+  return ierr;
+}
+
+/*
+  Collective write of count 8-byte words of every rank at its own offset.
+*/
+static int WriteWordsAt(ExportFile file, long long offset, const void * data, local_int_t count) {
+#ifndef HPCG_NO_MPI
+  return MPI_File_write_at_all(file, offset, (void *) data, count, MPI_DOUBLE, MPI_STATUS_IGNORE) != MPI_SUCCESS;
+#else
+  return fseek(file, (long) offset, SEEK_SET) != 0 || fwrite(data, 8, count, file) != (size_t) count;
+#endif
+}
+
+/*
+  Collective write of the box of this rank into a file of fixed-size entries in the global row
+  order: a subarray file view places every rank's rows, so each rank issues one write.
+*/
+static int WriteBoxAt(ExportFile file, long long offset, const Geometry & geom, const void * data, int entryBytes) {
+  const local_int_t nrow = geom.nx*geom.ny*geom.nz;
+#ifndef HPCG_NO_MPI
+  MPI_Datatype entry, box;
+  int sizes[3] = { (int) geom.gnz, (int) geom.gny, (int) geom.gnx };
+  int subsizes[3] = { (int) geom.nz, (int) geom.ny, (int) geom.nx };
+  int starts[3] = { (int) geom.giz0, (int) geom.giy0, (int) geom.gix0 };
+  MPI_Type_contiguous(entryBytes, MPI_BYTE, &entry);
+  MPI_Type_commit(&entry);
+  MPI_Type_create_subarray(3, sizes, subsizes, starts, MPI_ORDER_C, entry, &box);
+  MPI_Type_commit(&box);
+  int ierr = MPI_File_set_view(file, offset, entry, box, (char *) "native", MPI_INFO_NULL) != MPI_SUCCESS;
+  if (ierr == 0) ierr = MPI_File_write_all(file, (void *) data, nrow, entry, MPI_STATUS_IGNORE) != MPI_SUCCESS;
+  MPI_File_set_view(file, 0, MPI_BYTE, MPI_BYTE, (char *) "native", MPI_INFO_NULL);
+  MPI_Type_free(&box);
+  MPI_Type_free(&entry);
+  return ierr;
+#else
+  return fseek(file, (long) offset, SEEK_SET) != 0 || fwrite(data, entryBytes, nrow, file) != (size_t) nrow;
+#endif
+}
+
+static void FillHeader(ExportHeader & header, const char * magic, long long rows, long long columns, long long nnz) {
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, magic, 8);
+  header.rows = rows;
+  header.columns = columns;
+  header.nnz = nnz;
+  header.indexBytes = 8;
+  header.valueBytes = 8;
+  return;
+}
+
+/*!
+  Writes one vector in the global row order, to name.bin and, for the Matrix Market format,
+  to name.mtx as a dense column.
+*/
+static int ExportVector(const char * directory, const char * name, const SparseMatrix & A, const Vector & v, int format, double * natural) {
+  const Geometry & geom = *A.geom;
+  const local_int_t nrow = A.localNumberOfRows;
+  // Entries go back to the generated local order, which matches the box of the rank in the file view
+  for (local_int_t i = 0; i < nrow; i++) natural[GlobalToLocalRow(geom, GlobalRowOfLocalRow(A, i))] = v.values[i];
+
+  char file[64];
+  ExportFile fh;
+  snprintf(file, sizeof(file), "%s.bin", name);
+  int ierr = OpenExportFile(directory, file, fh);
+  if (ierr) return ierr;
+  ExportHeader header;
+  FillHeader(header, "HPCGVEC1", A.totalNumberOfRows, 1, A.totalNumberOfRows);
+  if (geom.rank == 0) ierr = WriteBytesAt(fh, 0, (const char *) &header, sizeof(header));
+  if (WriteBoxAt(fh, HPCG_EXPORT_HEADER_BYTES, geom, natural, sizeof(double))) ierr = 1;
+  if (CloseExportFile(fh)) ierr = 1;
+  if (format != HPCG_EXPORT_MATRIX_MARKET) return ierr;
+
+  char banner[128];
+  int bannerBytes = snprintf(banner, sizeof(banner), "%%%%MatrixMarket matrix array real general\n%lld 1\n", (long long) A.totalNumberOfRows);
+  char * text = (char *) TrackedMalloc((size_t) nrow*HPCG_EXPORT_VALUE_WIDTH + 1, HPCG_MEM_SCRATCH);
+  int localError = (text == NULL) ? 1 : ierr;
+#ifndef HPCG_NO_MPI
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#else
+  ierr = localError;
+#endif
+  if (ierr) {
+    TrackedFree(text);
+    return ierr;
+  }
+  for (local_int_t i = 0; i < nrow; i++) snprintf(text + (size_t) i*HPCG_EXPORT_VALUE_WIDTH, HPCG_EXPORT_VALUE_WIDTH + 1, "%24.16e\n", natural[i]);
+  snprintf(file, sizeof(file), "%s.mtx", name);
+  ierr = OpenExportFile(directory, file, fh);
+  if (ierr == 0) {
+    if (geom.rank == 0) ierr = WriteBytesAt(fh, 0, banner, bannerBytes);
+    if (WriteBoxAt(fh, bannerBytes, geom, text, HPCG_EXPORT_VALUE_WIDTH)) ierr = 1;
+    if (CloseExportFile(fh)) ierr = 1;
+  }
+  TrackedFree(text);
+  return ierr;
+}
+
+/*!
+  Writes the fine level matrix and the vectors b, x and xexact of a run of any number of ranks
+  with MPI-IO into a directory: A.bin holds the matrix in a binary coordinate format, every rank
+  writing its entries at an offset given by a prefix sum of the entry counts, and b.bin, x.bin
+  and xexact.bin hold the vectors in the global row order. Rows and columns use the global
+  numbering of the generated problem, whatever ordering OptimizeProblem chose. With
+  HPCG_EXPORT_MATRIX_MARKET, A.mtx, b.mtx, x.mtx and xexact.mtx are written as well.
+
+  The matrix is taken from the CSR arrays OptimizeProblem keeps after RetainOptimizedCsr(true);
+  without them (before OptimizeProblem, or in builds where it does not transform the matrix),
+  from the generated row arrays.
+
+  @param[in] directory Directory of the exported files, created if missing
+  @param[in] A         The fine level matrix
+  @param[in] b         The right hand side in the order of the rows of A
+  @param[in] x         The solution vector in the order of the rows of A
+  @param[in] xexact    The exact solution in the order of the rows of A
+  @param[in] format    HPCG_EXPORT_BINARY or HPCG_EXPORT_MATRIX_MARKET
+
+  @return Returns zero on every rank if all files were written and a non-zero value otherwise
+
+  @see WriteProblem
+*/
+int ExportProblem(const char * directory, const SparseMatrix & A, const Vector & b, const Vector & x,
+    const Vector & xexact, int format) {
+  const Geometry & geom = *A.geom;
+  const local_int_t nrow = A.localNumberOfRows;
+  const local_int_t ncol = A.localNumberOfColumns;
+  const struct optData * optData = (const struct optData *) A.optimizationData;
+  const OptimizedCsr * csr = (optData != NULL) ? optData->csr : NULL;
+  int localError = (csr == NULL && (A.matrixValues == NULL || A.mtxIndG == NULL));
+  int ierr = localError;
+#ifndef HPCG_NO_MPI
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  if (ierr) return ierr;
+#ifdef __linux__
+  if (geom.rank == 0) mkdir(directory, 0755);
+#endif
+#ifndef HPCG_NO_MPI
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+  // Coordinate entries of this rank in the global numbering
+  const local_int_t nnz = (csr != NULL) ? csr->nnz + csr->nnz_b : A.localNumberOfNonzeros;
+  long long * rows = (long long *) TrackedMalloc(sizeof(long long)*(nnz+1), HPCG_MEM_SCRATCH);
+  long long * columns = (long long *) TrackedMalloc(sizeof(long long)*(nnz+1), HPCG_MEM_SCRATCH);
+  double * values = (double *) TrackedMalloc(sizeof(double)*(nnz+1), HPCG_MEM_SCRATCH);
+  localError = (rows == NULL || columns == NULL || values == NULL);
+  if (csr != NULL && localError == 0) {
+    // Global number of every local column, the halo part filled by the owners of the halo columns
+    Vector global;
+    InitializeVector(global, ncol);
+    for (local_int_t i = 0; i < nrow; i++) global.values[i] = (double) GlobalRowOfLocalRow(A, i);
+#ifndef HPCG_NO_MPI
+    ExchangeHalo(A, global);
+#endif
+    local_int_t k = 0;
+    for (local_int_t i = 0; i < nrow; i++)
+      for (local_int_t p = csr->ia[i]; p < csr->ia[i+1]; p++, k++) {
+        rows[k] = (long long) global.values[i];
+        columns[k] = (long long) global.values[csr->ja[p]];
+        values[k] = csr->a[p];
+      }
+    for (local_int_t r = 0; r < csr->nrow_b; r++)
+      for (local_int_t p = csr->ia_b[r]; p < csr->ia_b[r+1]; p++, k++) {
+        rows[k] = (long long) global.values[optData->bmap[r]];
+        columns[k] = (long long) global.values[csr->ja_b[p]];
+        values[k] = csr->a_b[p];
+      }
+    DeleteVector(global);
+  } else if (localError == 0) {
+    local_int_t k = 0;
+    for (local_int_t i = 0; i < nrow; i++)
+      for (int j = 0; j < A.nonzerosInRow[i]; j++, k++) {
+        rows[k] = (long long) GlobalRowOfLocalRow(A, i);
+        columns[k] = (long long) A.mtxIndG[i][j];
+        values[k] = A.matrixValues[i][j];
+      }
+  }
+
+  long long localNnz = nnz, firstEntry = 0, totalNnz = nnz;
+#ifndef HPCG_NO_MPI
+  MPI_Exscan(&localNnz, &firstEntry, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (geom.rank == 0) firstEntry = 0;
+  MPI_Allreduce(&localNnz, &totalNnz, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#else
+  ierr = localError;
+#endif
+
+  // A.bin: header, then the row, column and value sections, each rank at firstEntry
+  ExportFile fh;
+  if (ierr == 0) ierr = OpenExportFile(directory, "A.bin", fh);
+  if (ierr == 0) {
+    ExportHeader header;
+    FillHeader(header, "HPCGCOO1", A.totalNumberOfRows, A.totalNumberOfRows, totalNnz);
+    if (geom.rank == 0) localError = WriteBytesAt(fh, 0, (const char *) &header, sizeof(header));
+    const long long base = HPCG_EXPORT_HEADER_BYTES;
+    if (WriteWordsAt(fh, base + 8*firstEntry, rows, nnz)) localError = 1;
+    if (WriteWordsAt(fh, base + 8*(totalNnz + firstEntry), columns, nnz)) localError = 1;
+    if (WriteWordsAt(fh, base + 8*(2*totalNnz + firstEntry), values, nnz)) localError = 1;
+    if (CloseExportFile(fh)) localError = 1;
+  }
+
+  // A.mtx: 1-based coordinate lines, each rank's text block at a prefix sum of the block lengths
+  if (ierr == 0 && format == HPCG_EXPORT_MATRIX_MARKET) {
+    char banner[160];
+    const int bannerBytes = snprintf(banner, sizeof(banner), "%%%%MatrixMarket matrix coordinate real general\n%lld %lld %lld\n",
+        (long long) A.totalNumberOfRows, (long long) A.totalNumberOfRows, totalNnz);
+    std::string text;
+    text.reserve((size_t) nnz*32);
+    char line[80];
+    for (local_int_t k = 0; k < nnz; k++) {
+      const int length = snprintf(line, sizeof(line), "%lld %lld %.17g\n", rows[k]+1, columns[k]+1, values[k]);
+      text.append(line, length);
+    }
+    long long textBytes = text.size(), firstByte = 0;
+#ifndef HPCG_NO_MPI
+    MPI_Exscan(&textBytes, &firstByte, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (geom.rank == 0) firstByte = 0;
+#endif
+    int openError = OpenExportFile(directory, "A.mtx", fh);
+    if (openError == 0) {
+      if (geom.rank == 0 && WriteBytesAt(fh, 0, banner, bannerBytes)) localError = 1;
+      if (WriteBytesAt(fh, bannerBytes + firstByte, text.data(), textBytes)) localError = 1;
+      if (CloseExportFile(fh)) localError = 1;
+    } else localError = 1;
+  }
+  TrackedFree(rows);
+  TrackedFree(columns);
+  TrackedFree(values);
+
+  // Vectors, through one scratch array in the generated order
+  if (ierr == 0) {
+    double * natural = (double *) TrackedMalloc(sizeof(double)*(nrow+1), HPCG_MEM_SCRATCH);
+    int vectorError = (natural == NULL);
+#ifndef HPCG_NO_MPI
+    int anyError = vectorError;
+    MPI_Allreduce(&anyError, &vectorError, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+    if (vectorError == 0) {
+      if (ExportVector(directory, "b", A, b, format, natural)) localError = 1;
+      if (ExportVector(directory, "x", A, x, format, natural)) localError = 1;
+      if (ExportVector(directory, "xexact", A, xexact, format, natural)) localError = 1;
+    } else localError = 1;
+    TrackedFree(natural);
+  }
+
+#ifndef HPCG_NO_MPI
+  MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#else
+  ierr = localError;
+#endif
+  return ierr;
+}
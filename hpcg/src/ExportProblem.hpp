@@ -0,0 +1,46 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ExportProblem.hpp
+
+ HPCG parallel binary export of the fine level matrix and vectors
+ */
+
+#ifndef EXPORTPROBLEM_HPP
+#define EXPORTPROBLEM_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+#define HPCG_EXPORT_BINARY         0 //!< binary coordinate matrix and binary vectors
+#define HPCG_EXPORT_MATRIX_MARKET  1 //!< the binary files plus Matrix Market text copies
+
+int ExportProblem(const char * directory, const SparseMatrix & A, const Vector & b, const Vector & x,
+    const Vector & xexact, int format);
+
+#endif // EXPORTPROBLEM_HPP
@@ -62,7 +62,7 @@ void GenerateCoarseProblem(const SparseMatrix & Af) {
   local_int_t nxc, nyc, nzc; //Coarse nx, ny, nz
   assert(nxf%2==0); assert(nyf%2==0); assert(nzf%2==0); // Need fine grid dimensions to be divisible by 2
   nxc = nxf/2; nyc = nyf/2; nzc = nzf/2;
-  local_int_t * f2cOperator = new local_int_t[Af.localNumberOfRows];
+  local_int_t * f2cOperator = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*Af.localNumberOfRows, HPCG_MEM_MG);
   local_int_t localNumberOfRows = nxc*nyc*nzc; // This is the size of our subblock
   // If this assert fails, it most likely means that the local_int_t is set to int and should be set to long long
   assert(localNumberOfRows>0); // Throw an exception of the number of rows is less than zero (can happen if "int" overflows)
@@ -113,11 +113,11 @@ void GenerateCoarseProblem(const SparseMatrix & Af) {
   Vector *rc = new Vector;
   Vector *xc = new Vector;
   Vector * Axf = new Vector;
-  InitializeVector(*rc, Ac->localNumberOfRows);
+  InitializeVector(*rc, Ac->localNumberOfRows, HPCG_MEM_MG);
   ZeroVector(*rc);
-  InitializeVector(*xc, Ac->localNumberOfColumns);
+  InitializeVector(*xc, Ac->localNumberOfColumns, HPCG_MEM_MG);
   ZeroVector(*xc);
-  InitializeVector(*Axf, Af.localNumberOfColumns);
+  InitializeVector(*Axf, Af.localNumberOfColumns, HPCG_MEM_MG);
   ZeroVector(*Axf);
   Af.Ac = Ac;
   MGData * mgData = new MGData;
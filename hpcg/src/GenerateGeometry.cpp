@@ -187,5 +187,21 @@ void GenerateGeometry(int size, int rank, int numThreads,
   geom->giy0 = giy0;
   geom->giz0 = giz0;
 
+  // Lookup tables of ComputeRankOfMatrixRow, the z table follows the partitions of varying nz
+  InitializeGeometryDivisor(geom->planeDivisor, gnx*gny);
+  InitializeGeometryDivisor(geom->lineDivisor, gnx);
+  geom->rankOffsetOfGlobalX = 0;
+  geom->rankOffsetOfGlobalY = 0;
+  geom->rankOffsetOfGlobalZ = 0;
+  int * rankOffsetOfGlobalX = new int[gnx];
+  int * rankOffsetOfGlobalY = new int[gny];
+  int * rankOffsetOfGlobalZ = new int[gnz];
+  for (global_int_t ix=0; ix<gnx; ++ix) rankOffsetOfGlobalX[ix] = ix/nx;
+  for (global_int_t iy=0; iy<gny; ++iy) rankOffsetOfGlobalY[iy] = (iy/ny)*npx;
+  for (global_int_t iz=0; iz<gnz; ++iz) rankOffsetOfGlobalZ[iz] = ComputeRankOfMatrixRowByPartition(*geom, iz*gnx*gny);
+  geom->rankOffsetOfGlobalX = rankOffsetOfGlobalX;
+  geom->rankOffsetOfGlobalY = rankOffsetOfGlobalY;
+  geom->rankOffsetOfGlobalZ = rankOffsetOfGlobalZ;
+
   return;
 }
@@ -97,11 +97,11 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
 //  double t1 = dsecnd();
 
   // Allocate arrays that are of length localNumberOfRows
-  char * nonzerosInRow = (char*) MKL_malloc(sizeof(char)*localNumberOfRows, ALIGN);
-  global_int_t ** mtxIndG = (global_int_t**) MKL_malloc(sizeof(global_int_t*)*localNumberOfRows, ALIGN);
-  local_int_t  ** mtxIndL = ( local_int_t**) MKL_malloc(sizeof( local_int_t*)*localNumberOfRows, ALIGN);
-  double ** matrixValues  = (      double**) MKL_malloc(sizeof( double*     )*localNumberOfRows, ALIGN);
-  double ** matrixDiagonal =(      double**) MKL_malloc(sizeof( double*     )*localNumberOfRows, ALIGN);
+  char * nonzerosInRow = (char*) TrackedMalloc(sizeof(char)*localNumberOfRows, HPCG_MEM_MATRIX);
+  global_int_t ** mtxIndG = (global_int_t**) TrackedMalloc(sizeof(global_int_t*)*localNumberOfRows, HPCG_MEM_MATRIX);
+  local_int_t  ** mtxIndL = ( local_int_t**) TrackedMalloc(sizeof( local_int_t*)*localNumberOfRows, HPCG_MEM_MATRIX);
+  double ** matrixValues  = (      double**) TrackedMalloc(sizeof( double*     )*localNumberOfRows, HPCG_MEM_MATRIX);
+  double ** matrixDiagonal =(      double**) TrackedMalloc(sizeof( double*     )*localNumberOfRows, HPCG_MEM_MATRIX);
   if (b!=0) InitializeVector(*b, localNumberOfRows);
   if (x!=0) InitializeVector(*x, localNumberOfRows);
   if (xexact!=0) InitializeVector(*xexact, localNumberOfRows);
@@ -112,7 +112,7 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
   if (x!=0) xv = x->values; // Only compute exact solution if requested
   if (xexact!=0) xexactv = xexact->values; // Only compute exact solution if requested
   int nproc = A.nproc;
-  A.localToGlobalMap.resize(localNumberOfRows);
+  // Local and global row numbers map onto each other in closed form (RowIndexing.hpp), no mapping arrays are kept
   // Now allocate the arrays pointed to
   local_int_t nnz = numberOfNonzerosPerRow*localNumberOfRows;
   global_int_t nnz_gl = ((global_int_t)numberOfNonzerosPerRow)*((global_int_t)localNumberOfRows);
@@ -144,11 +144,11 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
     exit(-1);
   }
 
-  A.mtxL = (local_int_t*) MKL_malloc(sizeof(local_int_t )*nnz, ALIGN );
-  A.mtxG = (global_int_t*)MKL_malloc(sizeof(global_int_t)*nnz, ALIGN );
-  A.mtxA = (double*)      MKL_malloc(sizeof(double      )*nnz, ALIGN );
+  A.mtxL = (local_int_t*) TrackedMalloc(sizeof(local_int_t )*nnz, HPCG_MEM_MATRIX);
+  A.mtxG = (global_int_t*)TrackedMalloc(sizeof(global_int_t)*nnz, HPCG_MEM_MATRIX);
+  A.mtxA = (double*)      TrackedMalloc(sizeof(double      )*nnz, HPCG_MEM_MATRIX);
 
-  A.boundaryRows = (local_int_t*) MKL_malloc( sizeof(local_int_t)*(nx*ny*nz - (nx-2)*(ny-2)*(nz-2)), ALIGN);
+  A.boundaryRows = (local_int_t*) TrackedMalloc( sizeof(local_int_t)*(nx*ny*nz - (nx-2)*(ny-2)*(nz-2)), HPCG_MEM_MATRIX);
 
   if ( A.mtxL == NULL || A.mtxG == NULL || A.mtxA == NULL || nonzerosInRow == NULL || A.boundaryRows == NULL
        || mtxIndG == NULL || mtxIndL == NULL || matrixValues == NULL || matrixDiagonal == NULL )
@@ -202,7 +202,7 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
 }
   A.numOfBoundaryRows = numOfBoundaryRows;
   local_int_t localNumberOfNonzeros = 0;
-  local_int_t *map_neib_r = (local_int_t*) MKL_malloc( sizeof(local_int_t)*A.geom->size, 512 );
+  local_int_t *map_neib_r = (local_int_t*) TrackedMalloc( sizeof(local_int_t)*A.geom->size, HPCG_MEM_HALO );
 
   if ( map_neib_r == NULL ) return;
 
@@ -234,7 +234,6 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
             global_int_t gix = gix0+ix; //ipx*nx+ix;
             local_int_t currentLocalRow = iz*nx*ny+iy*nx+ix;
             global_int_t currentGlobalRow = giz*gnx*gny+giy*gnx+gix;
-            A.localToGlobalMap[currentLocalRow ] = currentGlobalRow;
             mtxIndG[currentLocalRow]      = A.mtxG + currentLocalRow*numberOfNonzerosPerRow;
             mtxIndL[currentLocalRow]      = A.mtxL + currentLocalRow*numberOfNonzerosPerRow;
             matrixValues[currentLocalRow] = A.mtxA + currentLocalRow*numberOfNonzerosPerRow;
@@ -325,7 +324,6 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
         mtxIndG[currentLocalRow]      = A.mtxG + currentLocalRow*numberOfNonzerosPerRow;
         mtxIndL[currentLocalRow]      = A.mtxL + currentLocalRow*numberOfNonzerosPerRow;
         matrixValues[currentLocalRow] = A.mtxA + currentLocalRow*numberOfNonzerosPerRow;
-        A.localToGlobalMap[currentLocalRow] = currentGlobalRow;
         char numberOfNonzerosInRow = 0;
         double * currentValuePointer = matrixValues[currentLocalRow]; // Pointer to current value in current row
         global_int_t * currentIndexPointerG = mtxIndG[currentLocalRow]; // Pointer to current index in current row
@@ -342,19 +340,22 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
                       *currentValuePointer++ = -1.0;
                     }
                     *currentIndexPointerG++ = curcol;
-                    int rankIdOfColumnEntry = ComputeRankOfMatrixRow(*(A.geom), curcol);
-                    if( A.geom->rank == rankIdOfColumnEntry )
-                    {
-                        *currentIndexPointerL++ = col;
-                    } else {
-                        map_neib_r[rankIdOfColumnEntry] ++;
-                        *currentIndexPointerL++ = -1-rankIdOfColumnEntry;//(- col - 1);
-                    }
+                    *currentIndexPointerL++ = col;
 //                      printf("%d %lf %d %d\n",currentLocalRow,currentValuePointer[-1],curcol,numberOfNonzerosInRow);
                     numberOfNonzerosInRow++;
                 } // end sx loop
             } // end sy loop
         } // end sz loop
+        // Owners of all columns of the row in one batch; off-process columns are marked with the owner
+        int rankIdOfColumnEntry[27];
+        ComputeRanksOfMatrixRows(*(A.geom), mtxIndG[currentLocalRow], rankIdOfColumnEntry, numberOfNonzerosInRow);
+        for (int j = 0; j < numberOfNonzerosInRow; j++) {
+            if( A.geom->rank != rankIdOfColumnEntry[j] )
+            {
+                map_neib_r[rankIdOfColumnEntry[j]] ++;
+                mtxIndL[currentLocalRow][j] = -1-rankIdOfColumnEntry[j];//(- col - 1);
+            }
+        }
         nonzerosInRow[currentLocalRow] = numberOfNonzerosInRow;
         localNumberOfNonzeros += numberOfNonzerosInRow; // Protect this with an atomic
         if( b!=0 ) bv[currentLocalRow] = 26.0 - ((double) (numberOfNonzerosInRow-1));
@@ -362,19 +363,6 @@ void GenerateProblem(SparseMatrix & A, Vector * b, Vector * x, Vector * xexact)
         if( xexact!=0 ) xexactv[currentLocalRow] = 1.0;
     }
 }
-    for (int i = 0; i < A.numOfBoundaryRows; i++) {
-        local_int_t currentLocalRow = A.boundaryRows[i];
-        
-        local_int_t iz = currentLocalRow/(ny*nx);
-        local_int_t iy = currentLocalRow/nx%ny;
-        local_int_t ix = currentLocalRow%nx;
-        
-        global_int_t giz = giz0+iz; //ipz*nz+iz;
-        global_int_t giy = giy0+iy; //ipy*ny+iy;
-        global_int_t gix = gix0+ix; //ipx*nx+ix;
-        global_int_t currentGlobalRow = giz*gnx*gny+giy*gnx+gix;
-        A.globalToLocalMap[currentGlobalRow] = currentLocalRow;
-    }
 
   local_int_t number_of_neighbors = 0;
   if( A.geom->size > 1 ) {
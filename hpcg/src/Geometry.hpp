@@ -58,6 +58,33 @@ typedef long long global_int_t;
 // in order to stop complaints from non-C++11 compliant compilers.
 //#define HPCG_NO_LONG_LONG
 
+/*!
+  Divisor whose reciprocal is cached: the quotient is estimated in double precision and corrected
+  until the remainder is in range, which is exact for every non-negative dividend. Below 2^52 the
+  estimate is off by at most one, so at most one step is taken.
+*/
+struct GeometryDivisor_STRUCT {
+  global_int_t divisor;
+  double reciprocal;
+};
+typedef struct GeometryDivisor_STRUCT GeometryDivisor;
+
+inline void InitializeGeometryDivisor(GeometryDivisor & d, global_int_t divisor) {
+  d.divisor = divisor;
+  d.reciprocal = 1.0/(double) divisor;
+  return;
+}
+
+inline global_int_t DivideByGeometryDivisor(const GeometryDivisor & d, global_int_t n) {
+  if (d.divisor == 1) return n; // the estimate of n near 2^63 would not fit
+  global_int_t q = (global_int_t) ((double) n * d.reciprocal);
+  // The remainder is formed modulo 2^64: q*divisor may wrap, the small remainder stays exact
+  global_int_t r = (global_int_t) ((unsigned long long) n - (unsigned long long) q*(unsigned long long) d.divisor);
+  while (r < 0) { --q; r += d.divisor; }
+  while (r >= d.divisor) { ++q; r -= d.divisor; }
+  return q;
+}
+
 /*!
   This is a data structure to contain all processor geometry information
 */
@@ -84,20 +111,26 @@ struct Geometry_STRUCT {
   global_int_t gix0;  //!< Base global x index for this rank in the npx by npy by npz processor grid
   global_int_t giy0;  //!< Base global y index for this rank in the npx by npy by npz processor grid
   global_int_t giz0;  //!< Base global z index for this rank in the npx by npy by npz processor grid
+  GeometryDivisor planeDivisor; //!< gnx*gny, splits a global row into its z plane and the rest
+  GeometryDivisor lineDivisor;  //!< gnx, splits the rest into its y line and x position
+  int * rankOffsetOfGlobalX; //!< ipx of every global x index, gnx entries
+  int * rankOffsetOfGlobalY; //!< ipy*npx of every global y index, gny entries
+  int * rankOffsetOfGlobalZ; //!< ipz*npx*npy of every global z index, gnz entries, follows the z partitions
 
 };
 typedef struct Geometry_STRUCT Geometry;
 
 /*!
   Returns the rank of the MPI process that is assigned the global row index
-  given as the input argument.
+  given as the input argument, by walking the z partitions. Used to build the
+  lookup tables of the geometry; ComputeRankOfMatrixRow gives the same result.
 
   @param[in] geom  The description of the problem's geometry.
   @param[in] index The global row index
 
   @return Returns the MPI rank of the process assigned the row
 */
-inline int ComputeRankOfMatrixRow(const Geometry & geom, global_int_t index) {
+inline int ComputeRankOfMatrixRowByPartition(const Geometry & geom, global_int_t index) {
   global_int_t gnx = geom.gnx;
   global_int_t gny = geom.gny;
 
@@ -132,6 +165,46 @@ inline int ComputeRankOfMatrixRow(const Geometry & geom, global_int_t index) {
   return rank;
 }
 
+/*!
+  Returns the rank of the MPI process that is assigned the global row index
+  given as the input argument.
+
+  Two divisions by cached divisors split the row into its global x, y and z
+  indices; the process coordinates come from the tables GenerateGeometry builds,
+  so the cost does not depend on the number of z partitions.
+
+  @param[in] geom  The description of the problem's geometry.
+  @param[in] index The global row index
+
+  @return Returns the MPI rank of the process assigned the row
+*/
+inline int ComputeRankOfMatrixRow(const Geometry & geom, global_int_t index) {
+  if (geom.rankOffsetOfGlobalZ == 0) return ComputeRankOfMatrixRowByPartition(geom, index);
+  global_int_t iz = DivideByGeometryDivisor(geom.planeDivisor, index);
+  global_int_t rest = index - iz*geom.planeDivisor.divisor;
+  global_int_t iy = DivideByGeometryDivisor(geom.lineDivisor, rest);
+  global_int_t ix = rest - iy*geom.lineDivisor.divisor;
+  return geom.rankOffsetOfGlobalX[ix] + geom.rankOffsetOfGlobalY[iy] + geom.rankOffsetOfGlobalZ[iz];
+}
+
+/*!
+  Computes the ranks owning a batch of global rows, see ComputeRankOfMatrixRow.
+  The batches are short, at most the 27 columns of a row, and the loop is a plain scalar one.
+
+  @param[in]  geom    The description of the problem's geometry.
+  @param[in]  indices The global row indices
+  @param[out] ranks   The MPI rank of the process assigned every row
+  @param[in]  count   Number of rows
+*/
+inline void ComputeRanksOfMatrixRows(const Geometry & geom, const global_int_t * indices, int * ranks, local_int_t count) {
+  if (geom.rankOffsetOfGlobalZ == 0) {
+    for (local_int_t i = 0; i < count; ++i) ranks[i] = ComputeRankOfMatrixRowByPartition(geom, indices[i]);
+    return;
+  }
+  for (local_int_t i = 0; i < count; ++i) ranks[i] = ComputeRankOfMatrixRow(geom, indices[i]);
+  return;
+}
+
 
 /*!
  Destructor for geometry data.
@@ -142,6 +215,9 @@ inline void DeleteGeometry(Geometry & geom) {
 
   delete [] geom.partz_nz;
   delete [] geom.partz_ids;
+  delete [] geom.rankOffsetOfGlobalX;
+  delete [] geom.rankOffsetOfGlobalY;
+  delete [] geom.rankOffsetOfGlobalZ;
 
   return;
 }
@@ -0,0 +1,143 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file HaloBenchmark.cpp
+
+ HPCG routine
+ */
+
+#include <vector>
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#endif
+
+#include "HaloBenchmark.hpp"
+#include "ExchangeHalo.hpp"
+#include "SetupHalo.hpp"
+#include "CommThread.hpp"
+#include "Vector.hpp"
+#include "mytimer.hpp"
+
+static std::vector<HaloBenchmarkLevel> benchmarkLevels;
+
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+// Seconds per exchange of x on the level, after one warm-up exchange
+static double TimeHaloExchange(const SparseMatrix & A, Vector & x, bool splitPhase, int repetitions) {
+  if (splitPhase) {
+    BeginExchangeHalo(A, x);
+    EndExchangeHalo(A, x);
+  } else {
+    ExchangeHalo(A, x);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0 = mytimer();
+  for (int k = 0; k < repetitions; k++) {
+    if (splitPhase) {
+      BeginExchangeHalo(A, x);
+      EndExchangeHalo(A, x);
+    } else {
+      ExchangeHalo(A, x);
+    }
+  }
+  return (mytimer() - t0)/repetitions;
+}
+#endif
+
+/*!
+  Times the halo exchange of every MG level with each transport, whatever backend was
+  selected for the run: MPI_Alltoallv on MPI_COMM_WORLD, one message pair per neighbor, the
+  neighborhood collective and the one-sided puts. The state of the backends that are not in
+  use is created for the measurement only, and the halo traffic counters of the levels are
+  left untouched. The one-sided transport is skipped while the communication agent owns MPI.
+  The results are kept for ReportResults. Collective.
+
+  @param[inout] A           The fine grid matrix, the levels are reached through A.Ac
+  @param[in]    repetitions Exchanges timed per level and transport, nothing is measured if not positive
+*/
+void BenchmarkHaloTransports(SparseMatrix & A, int repetitions) {
+  benchmarkLevels.clear();
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+  if (repetitions <= 0 || A.geom->size == 1) return;
+
+  for (SparseMatrix * Al = &A; Al != 0; Al = Al->Ac) {
+    HaloBenchmarkLevel level;
+    level.neighbors = Al->numberOfSendNeighbors;
+    level.bytes = sizeof(double)*(double) Al->totalToBeSent;
+    for (int t = 0; t < HPCG_HALO_TRANSPORTS; t++) level.time[t] = 0.0;
+
+    Vector x;
+    InitializeVector(x, Al->localNumberOfColumns, HPCG_MEM_SCRATCH);
+    ZeroVector(x);
+
+    // Take the level out of the run: no backend state, no traffic accounting
+    NeighborHalo * neighborHalo = Al->neighborHalo;
+    RmaHalo * rmaHalo = Al->rmaHalo;
+    HaloPrecision * haloPrecision = Al->haloPrecision;
+    Al->neighborHalo = NULL;
+    Al->rmaHalo = NULL;
+    Al->haloPrecision = NULL;
+
+    level.time[HPCG_HALO_ALLTOALLV] = TimeHaloExchange(*Al, x, false, repetitions);
+    level.time[HPCG_HALO_ISEND] = TimeHaloExchange(*Al, x, true, repetitions);
+
+    Al->neighborHalo = NewNeighborHalo(*Al);
+    level.time[HPCG_HALO_NEIGHBOR] = TimeHaloExchange(*Al, x, true, repetitions);
+    DeleteNeighborHalo(Al->neighborHalo);
+    Al->neighborHalo = NULL;
+
+    if (!UseCommThread()) {
+      Al->rmaHalo = NewRmaHalo(*Al);
+      RegisterHaloWindow(*Al, x);
+      level.time[HPCG_HALO_PUT] = TimeHaloExchange(*Al, x, true, repetitions);
+      DeleteRmaHalo(Al->rmaHalo);
+      Al->rmaHalo = NULL;
+    }
+
+    Al->neighborHalo = neighborHalo;
+    Al->rmaHalo = rmaHalo;
+    Al->haloPrecision = haloPrecision;
+    DeleteVector(x);
+    benchmarkLevels.push_back(level);
+  }
+#endif
+  return;
+}
+
+/*!
+  Returns the results of BenchmarkHaloTransports.
+
+  @param[out] levels Per level timings on this rank, finest level first
+
+  @return The number of levels measured, zero if the benchmark did not run
+*/
+int GetHaloBenchmark(const HaloBenchmarkLevel ** levels) {
+  *levels = benchmarkLevels.empty() ? 0 : &benchmarkLevels[0];
+  return (int) benchmarkLevels.size();
+}
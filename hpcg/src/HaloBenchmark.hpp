@@ -0,0 +1,55 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file HaloBenchmark.hpp
+
+ HPCG microbenchmark of the halo exchange transports on every MG level
+ */
+
+#ifndef HALOBENCHMARK_HPP
+#define HALOBENCHMARK_HPP
+
+#include "SparseMatrix.hpp"
+
+#define HPCG_HALO_ALLTOALLV 0 //!< MPI_Alltoallv on MPI_COMM_WORLD
+#define HPCG_HALO_ISEND     1 //!< one MPI_Irecv and MPI_Isend pair per neighbor
+#define HPCG_HALO_NEIGHBOR  2 //!< MPI_Ineighbor_alltoallv on the distributed graph communicator
+#define HPCG_HALO_PUT       3 //!< MPI_Put into the ghost windows with post-start-complete-wait
+#define HPCG_HALO_TRANSPORTS 4
+
+struct HaloBenchmarkLevel_STRUCT {
+  int neighbors;        //!< neighbors of this rank on the level
+  double bytes;         //!< bytes sent by this rank per exchange
+  double time[HPCG_HALO_TRANSPORTS]; //!< seconds per exchange with each transport, 0 if it did not run
+};
+typedef struct HaloBenchmarkLevel_STRUCT HaloBenchmarkLevel;
+
+void BenchmarkHaloTransports(SparseMatrix & A, int repetitions);
+int GetHaloBenchmark(const HaloBenchmarkLevel ** levels);
+
+#endif // HALOBENCHMARK_HPP
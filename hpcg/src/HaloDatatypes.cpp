@@ -0,0 +1,103 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file HaloDatatypes.cpp
+
+ HPCG routine
+ */
+
+#ifndef HPCG_NO_MPI
+#include "HaloDatatypes.hpp"
+#include "TrackedAllocator.hpp"
+
+/*!
+  Packs z slices of the send boxes into the send buffer. A slice of a box is sy lines of sx
+  consecutive points; boxes one point wide in x (the x faces and the edges along y and z)
+  are copied with a stride of nx instead.
+
+  @param[in]  hd         The boxes of the level
+  @param[in]  xv         The vector values
+  @param[out] sendBuffer The packed values, in the order of elementsToSend
+  @param[in]  firstSlice First slice packed, counted over all boxes
+  @param[in]  lastSlice  One past the last slice packed
+*/
+void StridedHaloPack(const HaloDatatypes & hd, const double * xv, double * sendBuffer, local_int_t firstSlice, local_int_t lastSlice) {
+  const local_int_t nx = hd.nx;
+  const local_int_t ny = hd.ny;
+  int i = 0;
+  local_int_t offset = 0; // first value of box i in the send buffer
+  while (hd.sliceStart[i+1] <= firstSlice) {
+    offset += hd.box[6*i+3]*hd.box[6*i+4]*hd.box[6*i+5];
+    i++;
+  }
+  for (local_int_t slice = firstSlice; slice < lastSlice; slice++) {
+    while (slice >= hd.sliceStart[i+1]) {
+      offset += hd.box[6*i+3]*hd.box[6*i+4]*hd.box[6*i+5];
+      i++;
+    }
+    const local_int_t * b = hd.box + 6*i;
+    const local_int_t sx = b[3], sy = b[4];
+    const local_int_t z = slice - hd.sliceStart[i];
+    const double * in = xv + ((b[2] + z)*ny + b[1])*nx + b[0];
+    double * out = sendBuffer + offset + z*sy*sx;
+    if (sx == 1) {
+#ifndef HPCG_NO_OPENMP
+      #pragma omp simd
+#endif
+      for (local_int_t y = 0; y < sy; y++) out[y] = in[y*nx];
+    } else {
+      for (local_int_t y = 0; y < sy; y++, in += nx, out += sx) {
+#ifndef HPCG_NO_OPENMP
+        #pragma omp simd
+#endif
+        for (local_int_t x = 0; x < sx; x++) out[x] = in[x];
+      }
+    }
+  }
+  return;
+}
+
+/*!
+  Frees the datatypes and the boxes of a level.
+
+  @param[inout] hd The boxes of the level, may be NULL
+*/
+void DeleteHaloDatatypes(HaloDatatypes * hd) {
+  if (hd == NULL) return;
+  if (hd->types != NULL) {
+    for (int i = 0; i < hd->numberOfNeighbors; i++)
+      if (hd->types[i] != MPI_DATATYPE_NULL) MPI_Type_free(&hd->types[i]);
+  }
+  TrackedFree(hd->box);
+  TrackedFree(hd->sliceStart);
+  TrackedFree(hd->types);
+  delete hd;
+}
+#endif
+// ifndef HPCG_NO_MPI
@@ -0,0 +1,66 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file HaloDatatypes.hpp
+
+ HPCG halo packing without index lists, from the face, edge and corner boxes of the local grid
+ */
+
+#ifndef HALODATATYPES_HPP
+#define HALODATATYPES_HPP
+
+#define HPCG_HALO_PACK_GATHER   0 //!< gather through elementsToSend into the send buffer
+#define HPCG_HALO_PACK_DATATYPE 1 //!< send straight from x with MPI subarray datatypes
+#define HPCG_HALO_PACK_STRIDED  2 //!< strided box pack kernels into the send buffer
+#define HPCG_HALO_PACK_AUTO     3 //!< datatypes, unless MPI_Pack of them is slower than the strided kernels
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#include "Geometry.hpp"
+
+/*!
+  The points sent to each neighbor of a level as boxes of the local nx*ny*nz grid, in the
+  lexicographic order of elementsToSend.
+*/
+struct HaloDatatypes_STRUCT {
+  int mode;                 //!< HPCG_HALO_PACK_DATATYPE or HPCG_HALO_PACK_STRIDED
+  int numberOfNeighbors;    //!< neighbors of the level, one box each
+  local_int_t nx;           //!< local grid points in x
+  local_int_t ny;           //!< local grid points in y
+  local_int_t * box;        //!< 6 per neighbor: first x, y, z and extent in x, y, z of the box sent
+  local_int_t * sliceStart; //!< numberOfSendNeighbors+1 prefix sums of the z slices of the boxes
+  MPI_Datatype * types;     //!< per neighbor, subarray datatype of the box over x.values
+  double packTime[3];       //!< seconds per pack of the whole halo with the gather, the strided kernels and MPI_Pack
+};
+typedef struct HaloDatatypes_STRUCT HaloDatatypes;
+
+void StridedHaloPack(const HaloDatatypes & hd, const double * xv, double * sendBuffer, local_int_t firstSlice, local_int_t lastSlice);
+void DeleteHaloDatatypes(HaloDatatypes * hd);
+#endif
+
+#endif // HALODATATYPES_HPP
@@ -0,0 +1,199 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file HaloPrecision.cpp
+
+ HPCG routine
+ */
+
+#include <cstring>
+#include <cmath>
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#include "HaloPrecision.hpp"
+#include "TrackedAllocator.hpp"
+
+// Nesting depth of ComputeMG calls, halos are only reduced inside the preconditioner
+static int preconditionerDepth = 0;
+
+// Bytes of a HPCG_HALO_BLOCK16 block header: float offset and float scale
+#define HPCG_HALO_BLOCK_HEADER (2*sizeof(float))
+
+/*!
+  Returns the number of bytes of n halo values in the given encoding.
+*/
+local_int_t HaloEncodedBytes(int mode, local_int_t n) {
+  if (mode == HPCG_HALO_FLOAT) return n*sizeof(float);
+  if (mode == HPCG_HALO_BLOCK16) {
+    const local_int_t blocks = (n + HPCG_HALO_BLOCK - 1)/HPCG_HALO_BLOCK;
+    return blocks*HPCG_HALO_BLOCK_HEADER + n*sizeof(unsigned short);
+  }
+  return n*sizeof(double);
+}
+
+/*!
+  Encodes the halo values x[indices[0..n-1]] of one message.
+
+  HPCG_HALO_BLOCK16 stores, for every block of HPCG_HALO_BLOCK values, the minimum and the
+  step (max-min)/65535 as floats followed by the values rounded to the nearest step, which
+  bounds the error by half a step, i.e. 8e-6 of the range of the block.
+
+  @param[in]  mode    HPCG_HALO_DOUBLE, HPCG_HALO_FLOAT or HPCG_HALO_BLOCK16
+  @param[in]  x       Vector the values are taken from
+  @param[in]  indices Local indices of the values
+  @param[in]  n       Number of values
+  @param[out] out     HaloEncodedBytes(mode, n) bytes
+*/
+void EncodeHalo(int mode, const double * x, const local_int_t * indices, local_int_t n, unsigned char * out) {
+  if (mode == HPCG_HALO_FLOAT) {
+    float * const f = (float *) out;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t i=0; i<n; ++i) f[i] = (float) x[indices[i]];
+    return;
+  }
+  if (mode == HPCG_HALO_BLOCK16) {
+    const local_int_t blocks = (n + HPCG_HALO_BLOCK - 1)/HPCG_HALO_BLOCK;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t k=0; k<blocks; ++k) {
+      const local_int_t begin = k*HPCG_HALO_BLOCK;
+      const local_int_t end = (begin + HPCG_HALO_BLOCK < n) ? begin + HPCG_HALO_BLOCK : n;
+      unsigned char * const block = out + k*(HPCG_HALO_BLOCK_HEADER + HPCG_HALO_BLOCK*sizeof(unsigned short));
+      double lo = x[indices[begin]], hi = lo;
+      for (local_int_t i=begin+1; i<end; ++i) {
+        const double v = x[indices[i]];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+      }
+      const float offset = (float) lo;
+      float step = (float) ((hi - (double) offset)/65535.0);
+      // Make sure the largest value stays representable after rounding of the step
+      if (step > 0.0f && (double) offset + 65535.0*step < hi) step = nextafterf(step, 2.0f*step);
+      memcpy(block, &offset, sizeof(float));
+      memcpy(block + sizeof(float), &step, sizeof(float));
+      unsigned short * const q = (unsigned short *) (block + HPCG_HALO_BLOCK_HEADER);
+      const double inverse = (step > 0.0f) ? 1.0/step : 0.0;
+      for (local_int_t i=begin; i<end; ++i) {
+        double level = (x[indices[i]] - offset)*inverse + 0.5;
+        if (level < 0.0) level = 0.0;
+        if (level > 65535.0) level = 65535.0;
+        q[i-begin] = (unsigned short) level;
+      }
+    }
+    return;
+  }
+  double * const d = (double *) out;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<n; ++i) d[i] = x[indices[i]];
+  return;
+}
+
+/*!
+  Decodes n halo values encoded by EncodeHalo.
+
+  @param[in]  mode Encoding of the message
+  @param[in]  in   HaloEncodedBytes(mode, n) bytes
+  @param[in]  n    Number of values
+  @param[out] out  The decoded values
+*/
+void DecodeHalo(int mode, const unsigned char * in, local_int_t n, double * out) {
+  if (mode == HPCG_HALO_FLOAT) {
+    const float * const f = (const float *) in;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t i=0; i<n; ++i) out[i] = f[i];
+    return;
+  }
+  if (mode == HPCG_HALO_BLOCK16) {
+    const local_int_t blocks = (n + HPCG_HALO_BLOCK - 1)/HPCG_HALO_BLOCK;
+#ifndef HPCG_NO_OPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t k=0; k<blocks; ++k) {
+      const local_int_t begin = k*HPCG_HALO_BLOCK;
+      const local_int_t end = (begin + HPCG_HALO_BLOCK < n) ? begin + HPCG_HALO_BLOCK : n;
+      const unsigned char * const block = in + k*(HPCG_HALO_BLOCK_HEADER + HPCG_HALO_BLOCK*sizeof(unsigned short));
+      float offset, step;
+      memcpy(&offset, block, sizeof(float));
+      memcpy(&step, block + sizeof(float), sizeof(float));
+      const unsigned short * const q = (const unsigned short *) (block + HPCG_HALO_BLOCK_HEADER);
+      for (local_int_t i=begin; i<end; ++i) out[i] = (double) offset + (double) step*q[i-begin];
+    }
+    return;
+  }
+  memcpy(out, in, n*sizeof(double));
+  return;
+}
+
+/*!
+  Deallocates the halo encoding of a level.
+
+  @param[in] hp The encoding, may be NULL
+*/
+void DeleteHaloPrecision(HaloPrecision * hp) {
+  if (hp == NULL) return;
+  TrackedFree(hp->sendOffset);
+  TrackedFree(hp->receiveOffset);
+  TrackedFree(hp->sendBytes);
+  TrackedFree(hp->receiveBytes);
+  delete hp;
+  return;
+}
+
+/*!
+  Called on entry of ComputeMG, see PreconditionerHaloScope.
+*/
+void EnterPreconditionerHalo(void) {
+  preconditionerDepth++;
+  return;
+}
+
+/*!
+  Called on exit of ComputeMG, see PreconditionerHaloScope.
+*/
+void LeavePreconditionerHalo(void) {
+  preconditionerDepth--;
+  return;
+}
+
+/*!
+  Returns true while the MG preconditioner is running, when levels may exchange reduced halos.
+*/
+bool InPreconditionerHalo(void) {
+  return preconditionerDepth > 0;
+}
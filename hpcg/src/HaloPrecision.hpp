@@ -0,0 +1,76 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file HaloPrecision.hpp
+
+ HPCG reduced precision encodings of the halo exchanged inside the MG preconditioner
+ */
+
+#ifndef HALOPRECISION_HPP
+#define HALOPRECISION_HPP
+
+#include "Geometry.hpp"
+
+#define HPCG_HALO_DOUBLE  0 //!< exact exchange of double values
+#define HPCG_HALO_FLOAT   1 //!< values rounded to float
+#define HPCG_HALO_BLOCK16 2 //!< blocks of HPCG_HALO_BLOCK values quantized to 16 bits against the block range
+
+#define HPCG_HALO_BLOCK 32 //!< number of values sharing the offset and scale of a HPCG_HALO_BLOCK16 block
+
+/*!
+  Encoding of the halo of one MG level, with the byte layout of the messages to each neighbor.
+*/
+struct HaloPrecision_STRUCT {
+  int mode;                    //!< encoding used inside the MG preconditioner
+  local_int_t * sendOffset;    //!< numberOfSendNeighbors+1 byte offsets of the encoded messages sent
+  local_int_t * receiveOffset; //!< numberOfSendNeighbors+1 byte offsets of the encoded messages received
+  unsigned char * sendBytes;   //!< encoded send buffer
+  unsigned char * receiveBytes; //!< encoded receive buffer
+  long long exchanges;         //!< exchanges of this level, in any precision
+  double bytesOnWire;          //!< bytes sent by these exchanges
+};
+typedef struct HaloPrecision_STRUCT HaloPrecision;
+
+local_int_t HaloEncodedBytes(int mode, local_int_t n);
+void EncodeHalo(int mode, const double * x, const local_int_t * indices, local_int_t n, unsigned char * out);
+void DecodeHalo(int mode, const unsigned char * in, local_int_t n, double * out);
+void DeleteHaloPrecision(HaloPrecision * hp);
+
+void EnterPreconditionerHalo(void);
+void LeavePreconditionerHalo(void);
+bool InPreconditionerHalo(void);
+
+/*!
+  Marks the halo exchanges made during its lifetime as belonging to the MG preconditioner.
+*/
+struct PreconditionerHaloScope {
+  PreconditionerHaloScope() { EnterPreconditionerHalo(); }
+  ~PreconditionerHaloScope() { LeavePreconditionerHalo(); }
+};
+
+#endif // HALOPRECISION_HPP
@@ -0,0 +1,240 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file HugePageAllocator.cpp
+
+ HPCG routine
+ */
+
+#include <map>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "mkl.h"
+#include "HugePageAllocator.hpp"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define HUGEPAGE_2MB ((size_t) 2 << 20)
+#define HUGEPAGE_1GB ((size_t) 1 << 30)
+
+// Requests smaller than one 2 MB page are not worth a dedicated mapping
+#define HUGEPAGE_THRESHOLD HUGEPAGE_2MB
+
+struct HugePageRegion {
+  size_t length; // mapped length, a multiple of the page size
+  bool hugetlb;  // true for MAP_HUGETLB mappings, false for THP mappings
+};
+
+static int hugePageMode = HPCG_HUGEPAGES_OFF;
+static long long hugePageFallbacks = 0;
+static std::map< uintptr_t, HugePageRegion > hugePageRegions;
+
+static size_t RoundUp(size_t size, size_t page) {
+  return (size + page - 1)/page*page;
+}
+
+#ifdef __linux__
+static void * MapHugeTLB(size_t size, size_t page, int pageFlag) {
+  size_t length = RoundUp(size, page);
+  void * p = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|pageFlag, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+  HugePageRegion region = { length, true };
+  hugePageRegions[(uintptr_t) p] = region;
+  return p;
+}
+
+static void * MapTransparent(size_t size) {
+  size_t length = RoundUp(size, HUGEPAGE_2MB);
+  // Over-allocate by one page so that the start can be moved to a 2 MB boundary
+  char * raw = (char *) mmap(NULL, length + HUGEPAGE_2MB, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (raw == (char *) MAP_FAILED) return NULL;
+  char * p = (char *) RoundUp((size_t) raw, HUGEPAGE_2MB);
+  if (p > raw) munmap(raw, p - raw);
+  size_t tail = (raw + length + HUGEPAGE_2MB) - (p + length);
+  if (tail > 0) munmap(p + length, tail);
+#ifdef MADV_HUGEPAGE
+  madvise(p, length, MADV_HUGEPAGE);
+#endif
+  HugePageRegion region = { length, false };
+  hugePageRegions[(uintptr_t) p] = region;
+  return p;
+}
+#endif
+
+/*!
+  Selects how HugePageMalloc serves large requests for the rest of the run.
+
+  @param[in] mode One of HPCG_HUGEPAGES_OFF, HPCG_HUGEPAGES_THP, HPCG_HUGEPAGES_2MB or HPCG_HUGEPAGES_1GB.
+                  Unknown values disable huge pages.
+*/
+void InitializeHugePages(int mode) {
+#ifdef __linux__
+  if (mode < HPCG_HUGEPAGES_OFF || mode > HPCG_HUGEPAGES_1GB) mode = HPCG_HUGEPAGES_OFF;
+  hugePageMode = mode;
+#else
+  hugePageMode = HPCG_HUGEPAGES_OFF;
+#endif
+  return;
+}
+
+/*!
+  Allocates storage for a large array (matrix slabs, CSR arrays, vectors, scratch).
+
+  Requests below 2 MB, and all requests when huge pages are off, go to MKL_malloc with
+  the usual 512-byte alignment. Larger requests are mapped with the page size selected in
+  InitializeHugePages; when the kernel has no hugetlbfs pages reserved the request falls
+  back to the next smaller page size and finally to MKL_malloc.
+
+  @param[in] size Number of bytes requested
+
+  @return Pointer to the new storage or NULL if no memory is available
+
+  @see HugePageFree
+*/
+void * HugePageMalloc(size_t size) {
+  if (hugePageMode == HPCG_HUGEPAGES_OFF || size < HUGEPAGE_THRESHOLD) return MKL_malloc(size, 512);
+
+  void * p = NULL;
+#ifdef __linux__
+#ifndef HPCG_NO_OPENMP
+  #pragma omp critical (HugePageAllocator)
+#endif
+  {
+    if (hugePageMode == HPCG_HUGEPAGES_1GB) {
+      // Only use 1 GB pages when at least half of the last page is used
+      if (size >= HUGEPAGE_1GB/2) {
+        p = MapHugeTLB(size, HUGEPAGE_1GB, MAP_HUGE_1GB);
+        if (p == NULL) ++hugePageFallbacks;
+      }
+    }
+    if (p == NULL && hugePageMode >= HPCG_HUGEPAGES_2MB) {
+      p = MapHugeTLB(size, HUGEPAGE_2MB, MAP_HUGE_2MB);
+      if (p == NULL) ++hugePageFallbacks;
+    }
+    if (p == NULL) p = MapTransparent(size);
+  }
+#endif
+  if (p == NULL) p = MKL_malloc(size, 512);
+  return p;
+}
+
+/*!
+  Releases storage obtained from HugePageMalloc.
+
+  @param[in] ptr Pointer returned by HugePageMalloc, may be NULL
+*/
+void HugePageFree(void * ptr) {
+  if (ptr == NULL) return;
+#ifdef __linux__
+  bool mapped = false;
+  size_t length = 0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp critical (HugePageAllocator)
+#endif
+  {
+    std::map< uintptr_t, HugePageRegion >::iterator it = hugePageRegions.find((uintptr_t) ptr);
+    if (it != hugePageRegions.end()) {
+      mapped = true;
+      length = it->second.length;
+      hugePageRegions.erase(it);
+    }
+  }
+  if (mapped) {
+    munmap(ptr, length);
+    return;
+  }
+#endif
+  MKL_free(ptr);
+  return;
+}
+
+/*!
+  Reports how much of the memory handed out by HugePageMalloc is actually backed by huge pages.
+
+  hugetlbfs mappings are backed by construction. For THP mappings the kernel decides at fault
+  time, so the AnonHugePages counters of /proc/self/smaps are summed over the mapped regions.
+
+  @param[out] stats Snapshot of the allocator state on this process
+*/
+void GetHugePageStats(HugePageStats & stats) {
+  stats.mode = hugePageMode;
+  stats.allocations = hugePageRegions.size();
+  stats.fallbacks = hugePageFallbacks;
+  stats.mappedBytes = 0.0;
+  stats.backedBytes = 0.0;
+
+  double thpBytes = 0.0;
+  std::map< uintptr_t, HugePageRegion >::const_iterator it;
+  for (it = hugePageRegions.begin(); it != hugePageRegions.end(); ++it) {
+    stats.mappedBytes += it->second.length;
+    if (it->second.hugetlb) stats.backedBytes += it->second.length;
+    else thpBytes += it->second.length;
+  }
+  if (thpBytes == 0.0) return;
+
+#ifdef __linux__
+  FILE * smaps = fopen("/proc/self/smaps", "r");
+  if (smaps == NULL) return;
+  char line[512];
+  bool inRegion = false;
+  double anonHuge = 0.0;
+  while (fgets(line, sizeof(line), smaps)) {
+    unsigned long start = 0, end = 0;
+    long long kb = 0;
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      // A VMA belongs to us if it overlaps one of the THP regions (adjacent madvised regions may be merged)
+      inRegion = false;
+      it = hugePageRegions.upper_bound((uintptr_t) end - 1);
+      if (it != hugePageRegions.begin()) {
+        --it;
+        if (!it->second.hugetlb && it->first + it->second.length > start) inRegion = true;
+      }
+    } else if (inRegion && sscanf(line, "AnonHugePages: %lld kB", &kb) == 1) {
+      anonHuge += 1024.0*kb;
+    }
+  }
+  fclose(smaps);
+  stats.backedBytes += (anonHuge < thpBytes) ? anonHuge : thpBytes;
+#endif
+  return;
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file HugePageAllocator.hpp
+
+ HPCG allocator for large arrays backed by huge pages
+ */
+
+#ifndef HUGEPAGEALLOCATOR_HPP
+#define HUGEPAGEALLOCATOR_HPP
+
+#include <cstddef>
+
+// Values accepted by --huge-pages=
+#define HPCG_HUGEPAGES_OFF 0 //!< plain MKL_malloc, no huge page backing
+#define HPCG_HUGEPAGES_THP 1 //!< anonymous mmap with madvise(MADV_HUGEPAGE)
+#define HPCG_HUGEPAGES_2MB 2 //!< hugetlbfs 2 MB pages (MAP_HUGETLB), falls back to THP
+#define HPCG_HUGEPAGES_1GB 3 //!< hugetlbfs 1 GB pages (MAP_HUGETLB|MAP_HUGE_1GB), falls back to 2 MB, then THP
+
+struct HugePageStats_STRUCT {
+  int mode;              //!< mode selected with InitializeHugePages
+  long long allocations; //!< number of live allocations served by mmap
+  long long fallbacks;   //!< number of requests that could not get the requested page size
+  double mappedBytes;    //!< bytes currently mapped by the allocator
+  double backedBytes;    //!< bytes currently backed by huge pages (hugetlbfs + AnonHugePages)
+};
+typedef struct HugePageStats_STRUCT HugePageStats;
+
+void InitializeHugePages(int mode);
+void * HugePageMalloc(size_t size);
+void HugePageFree(void * ptr);
+void GetHugePageStats(HugePageStats & stats);
+
+#endif // HUGEPAGEALLOCATOR_HPP
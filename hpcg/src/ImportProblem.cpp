@@ -0,0 +1,688 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ImportProblem.cpp
+
+ HPCG routine
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#endif
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#include "hpcg.hpp"
+#include "ImportProblem.hpp"
+#include "TrackedAllocator.hpp"
+#include "ParallelScan.hpp"
+
+#define HPCG_IMPORT_HEADER_BYTES 64     // header of the binary files, see ExportProblem.cpp
+#define HPCG_IMPORT_BANNER_BYTES 65536  // Matrix Market banner, comments and size line, read by rank 0
+#define HPCG_IMPORT_LINE_BYTES   1024   // longest coordinate line of a Matrix Market file
+#define HPCG_IMPORT_ROW_LENGTH   127    // longest row, nonzerosInRow is a char
+
+// Reasons an import fails, the largest one over the ranks is reported by rank 0
+#define HPCG_IMPORT_OK           0
+#define HPCG_IMPORT_READ         1
+#define HPCG_IMPORT_FORMAT       2
+#define HPCG_IMPORT_INDEX        3
+#define HPCG_IMPORT_ROW_TOO_LONG 4
+#define HPCG_IMPORT_DIAGONAL     5
+#define HPCG_IMPORT_MEMORY       6
+#define HPCG_IMPORT_UNSUPPORTED  7
+#define HPCG_IMPORT_TOO_SMALL    8
+
+/*!
+  Header of the binary files, the layout written by ExportProblem: an 8-byte tag followed by
+  64-bit fields, padded to 64 bytes. After the header, an HPCGCOO1 file holds the row indices,
+  then the column indices (both int64, 0-based), then the values (double) of its nnz entries.
+  An HPCGCSR1 file holds rows+1 row pointers (int64, starting at 0), then the nnz column
+  indices and the nnz values of the rows in order.
+*/
+struct ImportHeader {
+  char magic[8];
+  long long rows;
+  long long columns;
+  long long nnz;
+  long long indexBytes;
+  long long valueBytes;
+  long long reserved[2];
+};
+
+// Column and value of an entry of a local row
+struct ImportEntry {
+  long long column;
+  double value;
+};
+
+static bool ImportEntryBefore(const ImportEntry & a, const ImportEntry & b) {
+  return a.column < b.column;
+}
+
+#ifndef HPCG_NO_MPI
+typedef MPI_File ImportFile;
+#else
+typedef FILE * ImportFile;
+#endif
+
+static int OpenImportFile(const char * fileName, ImportFile & file) {
+#ifndef HPCG_NO_MPI
+  return MPI_File_open(MPI_COMM_WORLD, (char *) fileName, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS;
+#else
+  file = fopen(fileName, "rb");
+  return file == NULL;
+#endif
+}
+
+static void CloseImportFile(ImportFile & file) {
+#ifndef HPCG_NO_MPI
+  MPI_File_close(&file);
+#else
+  fclose(file);
+#endif
+  return;
+}
+
+static long long ImportFileSize(ImportFile file) {
+#ifndef HPCG_NO_MPI
+  MPI_Offset bytes = 0;
+  if (MPI_File_get_size(file, &bytes) != MPI_SUCCESS) return -1;
+  return (long long) bytes;
+#else
+  if (fseek(file, 0, SEEK_END) != 0) return -1;
+  return (long long) ftell(file);
+#endif
+}
+
+/*
+  Independent read of bytes at an offset, for the banner read by rank 0 and the text ranges of
+  a Matrix Market file, whose lengths differ between ranks.
+*/
+static int ReadBytesAt(ImportFile file, long long offset, char * data, long long bytes) {
+  int ierr = 0;
+#ifndef HPCG_NO_MPI
+  const long long chunk = 1LL << 30;
+  for (long long done = 0; done < bytes && ierr == 0; done += chunk) {
+    const int count = (int) ((bytes - done < chunk) ? bytes - done : chunk);
+    MPI_Status status;
+    int received = 0;
+    ierr = MPI_File_read_at(file, offset + done, data + done, count, MPI_BYTE, &status) != MPI_SUCCESS;
+    if (ierr == 0) MPI_Get_count(&status, MPI_BYTE, &received);
+    if (received != count) ierr = 1;
+  }
+#else
+  ierr = fseek(file, (long) offset, SEEK_SET) != 0 || fread(data, 1, bytes, file) != (size_t) bytes;
+#endif
+  return ierr;
+}
+
+/*
+  Collective read of count 8-byte words of every rank at its own offset.
+*/
+static int ReadWordsAt(ImportFile file, long long offset, void * data, long long count) {
+  if (count > INT_MAX) return 1;
+#ifndef HPCG_NO_MPI
+  MPI_Status status;
+  int received = 0;
+  if (MPI_File_read_at_all(file, offset, data, (int) count, MPI_DOUBLE, &status) != MPI_SUCCESS) return 1;
+  MPI_Get_count(&status, MPI_DOUBLE, &received);
+  return received != (int) count;
+#else
+  return fseek(file, (long) offset, SEEK_SET) != 0 || fread(data, 8, count, file) != (size_t) count;
+#endif
+}
+
+static int MaxOverRanks(int value) {
+#ifndef HPCG_NO_MPI
+  int result = value;
+  MPI_Allreduce(&value, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  return result;
+#else
+  return value;
+#endif
+}
+
+// Rows are split in contiguous blocks of nearly equal size, rank r owns [FirstRowOfRank(r), FirstRowOfRank(r+1))
+static global_int_t FirstRowOfRank(global_int_t rows, int size, int rank) {
+  return rows*rank/size;
+}
+
+static int OwnerOfRow(global_int_t row, global_int_t rows, int size) {
+  int owner = (int) (row*size/rows);
+  while (owner+1 < size && FirstRowOfRank(rows, size, owner+1) <= row) ++owner;
+  while (owner > 0 && FirstRowOfRank(rows, size, owner) > row) --owner;
+  return owner;
+}
+
+#ifndef HPCG_LOCAL_LONG_LONG
+/*
+  Reads the Matrix Market banner and size line on rank 0. info receives the error code, the
+  number of rows, the number of coordinate lines, 1 for a symmetric matrix and the offset of
+  the first coordinate line.
+*/
+static void ReadMatrixMarketBanner(ImportFile file, long long fileSize, long long info[5]) {
+  info[0] = HPCG_IMPORT_FORMAT;
+  const long long bytes = (fileSize < HPCG_IMPORT_BANNER_BYTES) ? fileSize : HPCG_IMPORT_BANNER_BYTES;
+  std::vector<char> text(bytes+1, '\0');
+  if (ReadBytesAt(file, 0, &text[0], bytes)) {
+    info[0] = HPCG_IMPORT_READ;
+    return;
+  }
+  char object[64], layout[64], field[64], symmetry[64];
+  if (sscanf(&text[0], "%%%%MatrixMarket %63s %63s %63s %63s", object, layout, field, symmetry) != 4) return;
+  for (char * s = object; *s; ++s) *s = tolower(*s);
+  for (char * s = layout; *s; ++s) *s = tolower(*s);
+  for (char * s = field; *s; ++s) *s = tolower(*s);
+  for (char * s = symmetry; *s; ++s) *s = tolower(*s);
+  if (strcmp(object, "matrix") != 0 || strcmp(layout, "coordinate") != 0) return;
+  if (strcmp(field, "real") != 0 && strcmp(field, "integer") != 0 && strcmp(field, "double") != 0) {
+    info[0] = HPCG_IMPORT_UNSUPPORTED;
+    return;
+  }
+  if (strcmp(symmetry, "general") != 0 && strcmp(symmetry, "symmetric") != 0) {
+    info[0] = HPCG_IMPORT_UNSUPPORTED;
+    return;
+  }
+  // Comment and blank lines follow the banner, the first other line holds rows, columns and entries
+  long long offset = 0;
+  while (offset < bytes) {
+    const char * line = &text[offset];
+    const char * end = (const char *) memchr(line, '\n', bytes - offset);
+    if (end == NULL) return;
+    offset = end + 1 - &text[0];
+    const char * s = line;
+    while (s < end && isspace(*s)) ++s;
+    if (s == end || *s == '%') continue;
+    long long rows = 0, columns = 0, entries = 0;
+    if (sscanf(s, "%lld %lld %lld", &rows, &columns, &entries) != 3 || rows <= 0 || entries < 0) return;
+    if (rows != columns) {
+      info[0] = HPCG_IMPORT_UNSUPPORTED;
+      return;
+    }
+    info[0] = HPCG_IMPORT_OK;
+    info[1] = rows;
+    info[2] = entries;
+    info[3] = (strcmp(symmetry, "symmetric") == 0);
+    info[4] = offset;
+    return;
+  }
+  return;
+}
+
+/*
+  Parses the coordinate lines that start in an equal share of the bytes after the size line.
+  A line belongs to the rank whose range holds its first byte, so every rank reads one line
+  length past its range to finish its last line. The lower triangle of a symmetric file is
+  mirrored. Entries are returned 0-based, in file order.
+*/
+static int ReadMatrixMarketEntries(ImportFile file, long long fileSize, const long long info[5], int size, int rank,
+    std::vector<long long> & I, std::vector<long long> & J, std::vector<double> & V) {
+  const long long rows = info[1], bodyOffset = info[4];
+  const bool symmetric = (info[3] != 0);
+  const long long bodyBytes = fileSize - bodyOffset;
+  const long long begin = bodyOffset + bodyBytes*rank/size;
+  const long long end = bodyOffset + bodyBytes*(rank+1)/size;
+  const long long readBegin = (begin > bodyOffset) ? begin - 1 : begin;
+  const long long readEnd = (end + HPCG_IMPORT_LINE_BYTES < fileSize) ? end + HPCG_IMPORT_LINE_BYTES : fileSize;
+  const long long length = readEnd - readBegin;
+  int ierr = HPCG_IMPORT_OK;
+  long long lines = 0;
+  if (begin < end) {
+    std::vector<char> text(length+1, '\0');
+    if (ReadBytesAt(file, readBegin, &text[0], length)) ierr = HPCG_IMPORT_READ;
+    long long p = begin - readBegin;
+    // A line starting before the range belongs to the previous rank
+    if (begin > bodyOffset) while (p < length && text[p-1] != '\n') ++p;
+    while (ierr == HPCG_IMPORT_OK && readBegin + p < end) {
+      const char * line = &text[p];
+      const char * eol = (const char *) memchr(line, '\n', length - p);
+      if (eol == NULL) {
+        if (readEnd != fileSize) {
+          ierr = HPCG_IMPORT_FORMAT;
+          break;
+        }
+        eol = &text[length];
+      }
+      p = eol + 1 - &text[0];
+      const char * s = line;
+      while (s < eol && isspace(*s)) ++s;
+      if (s == eol || *s == '%') continue;
+      char * next = NULL;
+      const long long row = strtoll(s, &next, 10);
+      if (next == s) { ierr = HPCG_IMPORT_FORMAT; break; }
+      s = next;
+      const long long column = strtoll(s, &next, 10);
+      if (next == s) { ierr = HPCG_IMPORT_FORMAT; break; }
+      s = next;
+      const double value = strtod(s, &next);
+      if (next == s || next > eol) { ierr = HPCG_IMPORT_FORMAT; break; }
+      if (row < 1 || row > rows || column < 1 || column > rows) { ierr = HPCG_IMPORT_INDEX; break; }
+      I.push_back(row-1);
+      J.push_back(column-1);
+      V.push_back(value);
+      if (symmetric && row != column) {
+        I.push_back(column-1);
+        J.push_back(row-1);
+        V.push_back(value);
+      }
+      ++lines;
+    }
+  }
+  // Every coordinate line announced by the size line must have been found by exactly one rank
+  long long totalLines = lines;
+#ifndef HPCG_NO_MPI
+  MPI_Allreduce(&lines, &totalLines, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+#endif
+  if (ierr == HPCG_IMPORT_OK && totalLines != info[2]) ierr = HPCG_IMPORT_FORMAT;
+  return ierr;
+}
+
+/*
+  Sends every entry to the owner of its row with one MPI_Alltoallv per array.
+*/
+static int RedistributeEntries(global_int_t rows, int size, std::vector<long long> & I, std::vector<long long> & J,
+    std::vector<double> & V) {
+#ifndef HPCG_NO_MPI
+  if (size == 1) return HPCG_IMPORT_OK;
+  const long long count = (long long) I.size();
+  std::vector<int> sendCounts(size, 0), recvCounts(size, 0), sendOffsets(size+1, 0), recvOffsets(size+1, 0);
+  std::vector<int> owner(count);
+  for (long long k = 0; k < count; ++k) {
+    owner[k] = OwnerOfRow(I[k], rows, size);
+    ++sendCounts[owner[k]];
+  }
+  MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &recvCounts[0], 1, MPI_INT, MPI_COMM_WORLD);
+  long long sent = 0, received = 0;
+  for (int r = 0; r < size; ++r) {
+    sent += sendCounts[r];
+    received += recvCounts[r];
+  }
+  if (MaxOverRanks(sent > INT_MAX || received > INT_MAX)) return HPCG_IMPORT_MEMORY;
+  for (int r = 0; r < size; ++r) {
+    sendOffsets[r+1] = sendOffsets[r] + sendCounts[r];
+    recvOffsets[r+1] = recvOffsets[r] + recvCounts[r];
+  }
+  std::vector<int> position(sendOffsets.begin(), sendOffsets.end() - 1);
+  std::vector<long long> sendI(count), sendJ(count), recvI(received), recvJ(received);
+  std::vector<double> sendV(count), recvV(received);
+  for (long long k = 0; k < count; ++k) {
+    const int p = position[owner[k]]++;
+    sendI[p] = I[k];
+    sendJ[p] = J[k];
+    sendV[p] = V[k];
+  }
+  std::vector<long long>().swap(I);
+  std::vector<long long>().swap(J);
+  std::vector<double>().swap(V);
+  MPI_Alltoallv(sendI.data(), &sendCounts[0], &sendOffsets[0], MPI_LONG_LONG_INT, recvI.data(), &recvCounts[0], &recvOffsets[0], MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+  MPI_Alltoallv(sendJ.data(), &sendCounts[0], &sendOffsets[0], MPI_LONG_LONG_INT, recvJ.data(), &recvCounts[0], &recvOffsets[0], MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+  MPI_Alltoallv(sendV.data(), &sendCounts[0], &sendOffsets[0], MPI_DOUBLE, recvV.data(), &recvCounts[0], &recvOffsets[0], MPI_DOUBLE, MPI_COMM_WORLD);
+  I.swap(recvI);
+  J.swap(recvJ);
+  V.swap(recvV);
+#endif
+  return HPCG_IMPORT_OK;
+}
+
+/*
+  Geometry of an imported matrix: a single line of gnx = rows points split over npx = size ranks,
+  each rank holding its block of rows from gix0 on. LocalToGlobalRow and GlobalToLocalRow are
+  then exact, which is all SetupHalo and the optimized kernels need; the owner tables of the
+  generated geometry are left empty, the owners are found in the row blocks instead.
+*/
+static void InitializeRowGeometry(Geometry & geom, global_int_t rows, global_int_t firstRow, local_int_t nrow) {
+  geom.nx = nrow;
+  geom.ny = 1;
+  geom.nz = 1;
+  geom.npx = geom.size;
+  geom.npy = 1;
+  geom.npz = 1;
+  geom.pz = 0;
+  geom.npartz = 1;
+  geom.partz_ids = new int[1];
+  geom.partz_nz = new local_int_t[1];
+  geom.partz_ids[0] = 1;
+  geom.partz_nz[0] = 1;
+  geom.ipx = geom.rank;
+  geom.ipy = 0;
+  geom.ipz = 0;
+  geom.gnx = rows;
+  geom.gny = 1;
+  geom.gnz = 1;
+  geom.gix0 = firstRow;
+  geom.giy0 = 0;
+  geom.giz0 = 0;
+  InitializeGeometryDivisor(geom.planeDivisor, rows);
+  InitializeGeometryDivisor(geom.lineDivisor, rows);
+  geom.rankOffsetOfGlobalX = 0;
+  geom.rankOffsetOfGlobalY = 0;
+  geom.rankOffsetOfGlobalZ = 0;
+  return;
+}
+#endif
+
+/*!
+  Reads a square sparse matrix in parallel with MPI-IO and builds the fine level from it in place
+  of GenerateProblem: the rows are split in contiguous blocks over the ranks, and A is filled
+  like the generated matrix, with the owner of every off-process column in mtxIndL and the
+  neighbor counts in A.work, ready for SetupHalo. The geometry of A becomes a single line of
+  rows (see InitializeRowGeometry); its size, rank and numThreads must be set on entry.
+
+  Three formats are accepted, told apart by their first bytes:
+  - HPCG_IMPORT_BINARY_COO, the A.bin file written by ExportProblem: every rank reads an equal
+    share of the entries, which are then sent to the owners of their rows;
+  - HPCG_IMPORT_BINARY_CSR: every rank reads the row pointers of its block, then its entries;
+  - HPCG_IMPORT_MATRIX_MARKET, a coordinate file: every rank parses the lines starting in an
+    equal share of the bytes, and the entries are sent to their owners.
+
+  Duplicate entries are summed. Every row needs a nonzero diagonal, the smoother divides by it,
+  and at most 127 entries, the width of nonzerosInRow. The exact solution is a vector of ones,
+  b = A*xexact and x is zero. The matrix is assumed symmetric positive definite, which is not
+  checked.
+
+  @param[in]    fileName Path of the matrix file
+  @param[inout] A        The matrix, initialized by InitializeSparseMatrix with its geometry
+  @param[out]   b        The right hand side
+  @param[out]   x        The initial guess
+  @param[out]   xexact   The exact solution
+  @param[out]   format   The HPCG_IMPORT_* format of the file
+
+  @return Returns zero on every rank if the matrix was read and a non-zero value otherwise
+
+  @see GenerateProblem
+  @see ExportProblem
+*/
+int ImportProblem(const char * fileName, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact, int & format) {
+  Geometry & geom = *A.geom;
+  const int size = geom.size, rank = geom.rank;
+  const char * reasons[9] = { "", "the file could not be read", "the file is not in a supported format",
+      "a row or column index is out of range", "a row has more than 127 entries",
+      "a diagonal entry is missing or zero", "a local part of the matrix is too large",
+      "only real square matrices stored as general or symmetric are supported",
+      "the matrix has fewer rows than there are processes" };
+  format = HPCG_IMPORT_BINARY_COO;
+#ifdef HPCG_LOCAL_LONG_LONG
+  // The reference setup of these builds finds the owners of the halo columns from the grid
+  if (rank == 0) HPCG_fout << "Imported matrices need the optimized setup, they are not supported by this build." << std::endl;
+  return 1;
+#else
+  ImportFile file;
+  int ierr = MaxOverRanks(OpenImportFile(fileName, file) ? HPCG_IMPORT_READ : HPCG_IMPORT_OK);
+  if (ierr) {
+    if (rank == 0) HPCG_fout << "Could not import " << fileName << ": " << reasons[ierr] << "." << std::endl;
+    return ierr;
+  }
+  const long long fileSize = ImportFileSize(file);
+
+  // Rank 0 reads the header and the banner, every rank gets the format, rows, entries, symmetry and data offset
+  long long info[6] = { HPCG_IMPORT_READ, 0, 0, 0, 0, HPCG_IMPORT_BINARY_COO };
+  if (rank == 0 && fileSize >= 0) {
+    ImportHeader header;
+    memset(&header, 0, sizeof(header));
+    const long long bytes = (fileSize < HPCG_IMPORT_HEADER_BYTES) ? fileSize : HPCG_IMPORT_HEADER_BYTES;
+    if (ReadBytesAt(file, 0, (char *) &header, bytes) == 0) {
+      const bool coo = (memcmp(header.magic, "HPCGCOO1", 8) == 0), csr = (memcmp(header.magic, "HPCGCSR1", 8) == 0);
+      if (coo || csr) {
+        info[0] = HPCG_IMPORT_OK;
+        if (bytes < HPCG_IMPORT_HEADER_BYTES || header.indexBytes != 8 || header.valueBytes != 8 || header.rows <= 0 || header.nnz < 0)
+          info[0] = HPCG_IMPORT_FORMAT;
+        else if (header.rows != header.columns)
+          info[0] = HPCG_IMPORT_UNSUPPORTED;
+        info[1] = header.rows;
+        info[2] = header.nnz;
+        info[4] = HPCG_IMPORT_HEADER_BYTES;
+        info[5] = csr ? HPCG_IMPORT_BINARY_CSR : HPCG_IMPORT_BINARY_COO;
+      } else if (strncmp(header.magic, "%%Matrix", 8) == 0) {
+        ReadMatrixMarketBanner(file, fileSize, info);
+        info[5] = HPCG_IMPORT_MATRIX_MARKET;
+      } else info[0] = HPCG_IMPORT_FORMAT;
+    }
+  }
+#ifndef HPCG_NO_MPI
+  MPI_Bcast(info, 6, MPI_LONG_LONG_INT, 0, MPI_COMM_WORLD);
+#endif
+  ierr = (int) info[0];
+  format = (int) info[5];
+  const global_int_t rows = info[1];
+  const long long nnz = info[2], dataOffset = info[4];
+  const global_int_t firstRow = FirstRowOfRank(rows, size, rank), lastRow = FirstRowOfRank(rows, size, rank+1);
+  if (ierr == HPCG_IMPORT_OK && rows < size) ierr = HPCG_IMPORT_TOO_SMALL;
+  if (ierr == HPCG_IMPORT_OK && lastRow - firstRow > INT_MAX) ierr = HPCG_IMPORT_MEMORY;
+  ierr = MaxOverRanks(ierr);
+
+  // Entries of this rank, rows in the global numbering
+  std::vector<long long> I, J;
+  std::vector<double> V;
+  if (ierr == HPCG_IMPORT_OK && format == HPCG_IMPORT_BINARY_COO) {
+    const long long first = nnz*rank/size, count = nnz*(rank+1)/size - first;
+    I.resize(count+1);
+    J.resize(count+1);
+    V.resize(count+1);
+    if (ReadWordsAt(file, dataOffset + 8*first, &I[0], count)) ierr = HPCG_IMPORT_READ;
+    if (ReadWordsAt(file, dataOffset + 8*(nnz + first), &J[0], count)) ierr = HPCG_IMPORT_READ;
+    if (ReadWordsAt(file, dataOffset + 8*(2*nnz + first), &V[0], count)) ierr = HPCG_IMPORT_READ;
+    I.resize(count);
+    J.resize(count);
+    V.resize(count);
+    for (long long k = 0; k < count && ierr == HPCG_IMPORT_OK; ++k)
+      if (I[k] < 0 || I[k] >= rows || J[k] < 0 || J[k] >= rows) ierr = HPCG_IMPORT_INDEX;
+    ierr = MaxOverRanks(ierr);
+    if (ierr == HPCG_IMPORT_OK) ierr = RedistributeEntries(rows, size, I, J, V);
+  } else if (ierr == HPCG_IMPORT_OK && format == HPCG_IMPORT_BINARY_CSR) {
+    // The row pointers of the block give the range of its entries
+    std::vector<long long> pointers(lastRow - firstRow + 1);
+    if (ReadWordsAt(file, dataOffset + 8*firstRow, &pointers[0], lastRow - firstRow + 1)) ierr = HPCG_IMPORT_READ;
+    const long long first = pointers[0], count = pointers[lastRow - firstRow] - first;
+    for (global_int_t i = firstRow; i < lastRow && ierr == HPCG_IMPORT_OK; ++i)
+      if (pointers[i-firstRow+1] < pointers[i-firstRow]) ierr = HPCG_IMPORT_FORMAT;
+    if (ierr == HPCG_IMPORT_OK && (first < 0 || first + count > nnz)) ierr = HPCG_IMPORT_FORMAT;
+    ierr = MaxOverRanks(ierr);
+    const long long readCount = (ierr == HPCG_IMPORT_OK) ? count : 0, readFirst = (ierr == HPCG_IMPORT_OK) ? first : 0;
+    I.resize(readCount+1);
+    J.resize(readCount+1);
+    V.resize(readCount+1);
+    if (ReadWordsAt(file, dataOffset + 8*(rows + 1 + readFirst), &J[0], readCount)) ierr = HPCG_IMPORT_READ;
+    if (ReadWordsAt(file, dataOffset + 8*(rows + 1 + nnz + readFirst), &V[0], readCount)) ierr = HPCG_IMPORT_READ;
+    I.resize(readCount);
+    J.resize(readCount);
+    V.resize(readCount);
+    for (global_int_t i = firstRow; i < lastRow && ierr == HPCG_IMPORT_OK; ++i)
+      for (long long k = pointers[i-firstRow] - first; k < pointers[i-firstRow+1] - first; ++k) I[k] = i;
+    for (long long k = 0; k < readCount && ierr == HPCG_IMPORT_OK; ++k)
+      if (J[k] < 0 || J[k] >= rows) ierr = HPCG_IMPORT_INDEX;
+  } else if (ierr == HPCG_IMPORT_OK) {
+    ierr = ReadMatrixMarketEntries(file, fileSize, info, size, rank, I, J, V);
+    ierr = MaxOverRanks(ierr);
+    if (ierr == HPCG_IMPORT_OK) ierr = RedistributeEntries(rows, size, I, J, V);
+  }
+  CloseImportFile(file);
+  ierr = MaxOverRanks(ierr);
+  if (ierr) {
+    if (rank == 0) HPCG_fout << "Could not import " << fileName << ": " << reasons[ierr] << "." << std::endl;
+    return ierr;
+  }
+
+  // Entries grouped by local row, then sorted by column with the duplicates summed
+  const local_int_t nrow = (local_int_t) (lastRow - firstRow);
+  const long long count = (long long) I.size();
+  std::vector<long long> rowStart(nrow+1, 0);
+  for (long long k = 0; k < count; ++k) ++rowStart[I[k] - firstRow + 1];
+  for (local_int_t i = 0; i < nrow; ++i) rowStart[i+1] += rowStart[i];
+  std::vector<ImportEntry> entries(count+1);
+  {
+    std::vector<long long> position(rowStart.begin(), rowStart.end() - 1);
+    for (long long k = 0; k < count; ++k) {
+      ImportEntry & e = entries[position[I[k] - firstRow]++];
+      e.column = J[k];
+      e.value = V[k];
+    }
+  }
+  std::vector<long long>().swap(I);
+  std::vector<long long>().swap(J);
+  std::vector<double>().swap(V);
+  std::vector<local_int_t> rowLength(nrow, 0);
+  int localError = HPCG_IMPORT_OK;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for reduction(max:localError)
+#endif
+  for (local_int_t i = 0; i < nrow; ++i) {
+    ImportEntry * row = &entries[0] + rowStart[i];
+    const long long length = rowStart[i+1] - rowStart[i];
+    std::sort(row, row + length, ImportEntryBefore);
+    long long merged = 0;
+    bool diagonal = false;
+    for (long long k = 0; k < length; ++k) {
+      if (merged > 0 && row[merged-1].column == row[k].column) row[merged-1].value += row[k].value;
+      else row[merged++] = row[k];
+    }
+    for (long long k = 0; k < merged; ++k)
+      if (row[k].column == firstRow + i && row[k].value != 0.0) diagonal = true;
+    if (merged > HPCG_IMPORT_ROW_LENGTH && localError < HPCG_IMPORT_ROW_TOO_LONG) localError = HPCG_IMPORT_ROW_TOO_LONG;
+    if (!diagonal && localError < HPCG_IMPORT_DIAGONAL) localError = HPCG_IMPORT_DIAGONAL;
+    rowLength[i] = (local_int_t) merged;
+  }
+  long long localNonzeros = 0;
+  for (local_int_t i = 0; i < nrow; ++i) localNonzeros += rowLength[i];
+  if (localNonzeros > INT_MAX && localError == HPCG_IMPORT_OK) localError = HPCG_IMPORT_MEMORY;
+
+  // The arrays of GenerateProblem, rows packed one after the other in the mtxL, mtxG and mtxA slabs
+  const local_int_t localNumberOfNonzeros = (local_int_t) localNonzeros;
+  char * nonzerosInRow = (char*) TrackedMalloc(sizeof(char)*(nrow+1), HPCG_MEM_MATRIX);
+  global_int_t ** mtxIndG = (global_int_t**) TrackedMalloc(sizeof(global_int_t*)*(nrow+1), HPCG_MEM_MATRIX);
+  local_int_t  ** mtxIndL = ( local_int_t**) TrackedMalloc(sizeof( local_int_t*)*(nrow+1), HPCG_MEM_MATRIX);
+  double ** matrixValues  = (      double**) TrackedMalloc(sizeof( double*     )*(nrow+1), HPCG_MEM_MATRIX);
+  double ** matrixDiagonal =(      double**) TrackedMalloc(sizeof( double*     )*(nrow+1), HPCG_MEM_MATRIX);
+  A.mtxL = (local_int_t*) TrackedMalloc(sizeof(local_int_t )*(localNumberOfNonzeros+1), HPCG_MEM_MATRIX);
+  A.mtxG = (global_int_t*)TrackedMalloc(sizeof(global_int_t)*(localNumberOfNonzeros+1), HPCG_MEM_MATRIX);
+  A.mtxA = (double*)      TrackedMalloc(sizeof(double      )*(localNumberOfNonzeros+1), HPCG_MEM_MATRIX);
+  A.boundaryRows = (local_int_t*) TrackedMalloc(sizeof(local_int_t)*(nrow+1), HPCG_MEM_MATRIX);
+  local_int_t * map_neib_r = (local_int_t*) TrackedMalloc(sizeof(local_int_t)*size, HPCG_MEM_HALO);
+  if ( nonzerosInRow == NULL || mtxIndG == NULL || mtxIndL == NULL || matrixValues == NULL || matrixDiagonal == NULL
+       || A.mtxL == NULL || A.mtxG == NULL || A.mtxA == NULL || A.boundaryRows == NULL || map_neib_r == NULL )
+      localError = HPCG_IMPORT_MEMORY;
+  ierr = MaxOverRanks(localError);
+  if (ierr) {
+    if (rank == 0) HPCG_fout << "Could not import " << fileName << ": " << reasons[ierr] << "." << std::endl;
+    // Release whatever was allocated, on any rank, so the caller can delete A as usual
+    TrackedFree(nonzerosInRow);
+    TrackedFree(mtxIndG);
+    TrackedFree(mtxIndL);
+    TrackedFree(matrixValues);
+    TrackedFree(matrixDiagonal);
+    TrackedFree(map_neib_r);
+    TrackedFree(A.mtxL);         A.mtxL = NULL;
+    TrackedFree(A.mtxG);         A.mtxG = NULL;
+    TrackedFree(A.mtxA);         A.mtxA = NULL;
+    TrackedFree(A.boundaryRows); A.boundaryRows = NULL;
+    return ierr;
+  }
+
+  InitializeRowGeometry(geom, rows, firstRow, nrow);
+  InitializeVector(b, nrow);
+  InitializeVector(x, nrow);
+  InitializeVector(xexact, nrow);
+  std::vector<local_int_t> rowOffset(nrow+1, 0);
+  std::copy(rowLength.begin(), rowLength.end(), rowOffset.begin() + 1);
+  ParallelPrefixSum(&rowOffset[1], nrow);
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i = 0; i < nrow; ++i) {
+    const ImportEntry * row = &entries[0] + rowStart[i];
+    mtxIndG[i]      = A.mtxG + rowOffset[i];
+    mtxIndL[i]      = A.mtxL + rowOffset[i];
+    matrixValues[i] = A.mtxA + rowOffset[i];
+    double sum = 0.0;
+    for (local_int_t j = 0; j < rowLength[i]; ++j) {
+      const global_int_t column = row[j].column;
+      mtxIndG[i][j] = column;
+      matrixValues[i][j] = row[j].value;
+      // Off-process columns are marked with their owner, as GenerateProblem does
+      if (column >= firstRow && column < lastRow) mtxIndL[i][j] = (local_int_t) (column - firstRow);
+      else mtxIndL[i][j] = -1-OwnerOfRow(column, rows, size);
+      if (column == firstRow + i) matrixDiagonal[i] = matrixValues[i] + j;
+      sum += row[j].value;
+    }
+    nonzerosInRow[i] = (char) rowLength[i];
+    b.values[i] = sum;
+    x.values[i] = 0.0;
+    xexact.values[i] = 1.0;
+  }
+
+  // Rows with off-process columns, in ascending order, and the number of halo columns per neighbor
+  for (int r = 0; r < size; ++r) map_neib_r[r] = 0;
+  local_int_t numOfBoundaryRows = 0;
+  for (local_int_t i = 0; i < nrow; ++i) {
+    bool boundary = false;
+    for (local_int_t j = 0; j < rowLength[i]; ++j)
+      if (mtxIndL[i][j] < 0) {
+        ++map_neib_r[-1-mtxIndL[i][j]];
+        boundary = true;
+      }
+    if (boundary) A.boundaryRows[numOfBoundaryRows++] = i;
+  }
+  local_int_t number_of_neighbors = 0;
+  for (int r = 0; r < size; ++r) number_of_neighbors += (map_neib_r[r] > 0);
+
+  long long totalNonzeros = localNonzeros;
+#ifndef HPCG_NO_MPI
+  MPI_Allreduce(&localNonzeros, &totalNonzeros, 1, MPI_LONG_LONG_INT, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  A.title = 0;
+  A.work = map_neib_r;
+  A.numOfBoundaryRows = numOfBoundaryRows;
+#ifndef HPCG_NO_MPI
+  A.numberOfSendNeighbors = number_of_neighbors;
+#endif
+  A.totalNumberOfRows = rows;
+  A.totalNumberOfNonzeros = totalNonzeros;
+  A.localNumberOfRows = nrow;
+  A.localNumberOfColumns = nrow;
+  A.localNumberOfNonzeros = localNumberOfNonzeros;
+  A.nonzerosInRow = nonzerosInRow;
+  A.mtxIndG = mtxIndG;
+  A.mtxIndL = mtxIndL;
+  A.matrixValues = matrixValues;
+  A.matrixDiagonal = matrixDiagonal;
+  return 0;
+#endif
+}
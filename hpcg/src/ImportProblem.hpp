@@ -0,0 +1,46 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ImportProblem.hpp
+
+ HPCG parallel input of an external matrix in place of the generated problem
+ */
+
+#ifndef IMPORTPROBLEM_HPP
+#define IMPORTPROBLEM_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+#define HPCG_IMPORT_BINARY_COO    0 //!< the HPCGCOO1 coordinate file written by ExportProblem
+#define HPCG_IMPORT_BINARY_CSR    1 //!< an HPCGCSR1 file: row pointers, column indices, values
+#define HPCG_IMPORT_MATRIX_MARKET 2 //!< a Matrix Market coordinate file, real or integer, general or symmetric
+
+int ImportProblem(const char * fileName, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact, int & format);
+
+#endif // IMPORTPROBLEM_HPP
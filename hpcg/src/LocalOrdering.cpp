@@ -0,0 +1,154 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file LocalOrdering.cpp
+
+ HPCG routine
+ */
+
+#include <vector>
+
+#include "LocalOrdering.hpp"
+#include "TrackedAllocator.hpp"
+
+static bool localOrderingEnabled = false;
+
+/*!
+  Selects whether OptimizeProblem renumbers the local rows of every level.
+
+  @param[in] enabled Non-zero to renumber
+*/
+void InitializeLocalOrdering(int enabled) {
+  localOrderingEnabled = (enabled != 0);
+  return;
+}
+
+bool UseLocalOrdering(void) {
+  return localOrderingEnabled;
+}
+
+/*!
+  Renumbers the local rows of one level: the interior rows, which have no halo columns, keep
+  their relative order and come first; the boundary rows follow, grouped by the first neighbor
+  they read from. The boundary rows, which OptimizeProblem lists in bmap and csrB, then form
+  one contiguous range at the end, and the values sent to a neighbor come mostly from its own
+  group of rows. Halo columns keep their numbers.
+
+  The row-wise matrix arrays, elementsToSend and the values of the f2cOperator of this level
+  are renumbered. The positions in the f2cOperator of the finer
+  level, which index the rows of this level, are permuted as well. Must be called inside
+  OptimizeProblem while the row-wise arrays still exist.
+
+  @param[inout] A      The matrix of the level
+  @param[inout] finer  The next finer level, whose f2cOperator points into A, or NULL on the finest level
+
+  @return The generated row behind every new row, to be kept in optData->localOrder; the
+          global row of a local row follows from it with GlobalRowOfLocalRow
+*/
+local_int_t * RenumberLocalRows(SparseMatrix & A, SparseMatrix * finer) {
+  const local_int_t nrow = A.localNumberOfRows;
+  const local_int_t ncol = A.localNumberOfColumns;
+  local_int_t * generatedRow = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(nrow+1), HPCG_MEM_MATRIX);
+  if (generatedRow == NULL) return NULL;
+
+  // Neighbor of every halo column, the halo columns are numbered neighbor after neighbor
+  int numberOfNeighbors = 0;
+  std::vector<int> ghostNeighbor(ncol - nrow + 1, 0);
+#ifndef HPCG_NO_MPI
+  numberOfNeighbors = A.numberOfSendNeighbors;
+  local_int_t ghost = 0;
+  for (int k = 0; k < numberOfNeighbors; k++)
+    for (local_int_t j = 0; j < A.receiveLength[k]; j++) ghostNeighbor[ghost++] = k;
+#endif
+
+  // Group 0 holds the interior rows, group k+1 the boundary rows whose first halo column belongs to neighbor k
+  std::vector<int> group(nrow);
+  std::vector<local_int_t> groupStart(numberOfNeighbors+2, 0);
+  for (local_int_t i = 0; i < nrow; i++) {
+    local_int_t firstGhost = ncol;
+    for (int j = 0; j < A.nonzerosInRow[i]; j++)
+      if (A.mtxIndL[i][j] >= nrow && A.mtxIndL[i][j] < firstGhost) firstGhost = A.mtxIndL[i][j];
+    group[i] = (firstGhost < ncol) ? ghostNeighbor[firstGhost - nrow] + 1 : 0;
+    groupStart[group[i]+1]++;
+  }
+  for (int k = 0; k <= numberOfNeighbors; k++) groupStart[k+1] += groupStart[k];
+  std::vector<local_int_t> order(nrow);
+  for (local_int_t i = 0; i < nrow; i++) {
+    order[i] = groupStart[group[i]]++;
+    generatedRow[order[i]] = i;
+  }
+
+  // Rows move with their arrays, local column indices are renamed
+  std::vector<char> nonzerosInRow(A.nonzerosInRow, A.nonzerosInRow + nrow);
+  std::vector<local_int_t *> mtxIndL(A.mtxIndL, A.mtxIndL + nrow);
+  std::vector<double *> matrixValues(A.matrixValues, A.matrixValues + nrow);
+  std::vector<double *> matrixDiagonal(A.matrixDiagonal, A.matrixDiagonal + nrow);
+  for (local_int_t i = 0; i < nrow; i++) {
+    const local_int_t ni = order[i];
+    A.nonzerosInRow[ni] = nonzerosInRow[i];
+    A.mtxIndL[ni] = mtxIndL[i];
+    A.matrixValues[ni] = matrixValues[i];
+    A.matrixDiagonal[ni] = matrixDiagonal[i];
+  }
+  for (local_int_t i = 0; i < nrow; i++)
+    for (int j = 0; j < A.nonzerosInRow[i]; j++)
+      if (A.mtxIndL[i][j] < nrow) A.mtxIndL[i][j] = order[A.mtxIndL[i][j]];
+
+#ifndef HPCG_NO_MPI
+  for (local_int_t i = 0; i < A.totalToBeSent; i++) A.elementsToSend[i] = order[A.elementsToSend[i]];
+#endif
+  if (A.mgData != NULL && A.mgData->f2cOperator != NULL) {
+    local_int_t * f2c = A.mgData->f2cOperator;
+    for (local_int_t i = 0; i < A.Ac->localNumberOfRows; i++) f2c[i] = order[f2c[i]];
+  }
+  if (finer != NULL && finer->mgData != NULL && finer->mgData->f2cOperator != NULL) {
+    local_int_t * f2c = finer->mgData->f2cOperator;
+    std::vector<local_int_t> fineRows(f2c, f2c + nrow);
+    for (local_int_t i = 0; i < nrow; i++) f2c[order[i]] = fineRows[i];
+  }
+  return generatedRow;
+}
+
+/*!
+  Moves the entries of a vector from the natural order of the generated problem to the local
+  order chosen by RenumberLocalRows. Does nothing if the rows were not renumbered.
+
+  @param[in]    A The fine level matrix after OptimizeProblem
+  @param[inout] v A vector of the fine level in the natural order
+*/
+void ApplyLocalOrdering(const SparseMatrix & A, Vector & v) {
+#ifndef HPCG_LOCAL_LONG_LONG
+  const struct optData * optData = (const struct optData *) A.optimizationData;
+  if (optData == NULL || optData->localOrder == NULL) return;
+  const local_int_t nrow = A.localNumberOfRows;
+  std::vector<double> values(v.values, v.values + nrow);
+  for (local_int_t i = 0; i < nrow; i++) v.values[i] = values[optData->localOrder[i]];
+#endif
+  return;
+}
@@ -0,0 +1,45 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file LocalOrdering.hpp
+
+ HPCG local renumbering of the rows: interior rows first, then the boundary rows grouped by neighbor
+ */
+
+#ifndef LOCALORDERING_HPP
+#define LOCALORDERING_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+void InitializeLocalOrdering(int enabled);
+bool UseLocalOrdering(void);
+local_int_t * RenumberLocalRows(SparseMatrix & A, SparseMatrix * finer);
+void ApplyLocalOrdering(const SparseMatrix & A, Vector & v);
+
+#endif // LOCALORDERING_HPP
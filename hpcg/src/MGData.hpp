@@ -45,6 +45,10 @@ struct MGData_STRUCT {
   Vector * rc; // coarse grid residual vector
   Vector * xc; // coarse grid solution vector
   Vector * Axf; // fine grid residual vector
+  double restrictionTime; //!< accumulated time of pre-smoothing, residual and restriction on this level
+  double prolongationTime; //!< accumulated time of prolongation and post-smoothing on this level
+  double cycleTime; //!< accumulated time of the V-cycles started on this level, coarser levels included
+  long long numberOfCycles; //!< number of V-cycles that went through this level
   /*!
    This is for storing optimized data structres created in OptimizeProblem and
    used inside optimized ComputeSPMV().
@@ -67,6 +71,10 @@ inline void InitializeMGData(local_int_t * f2cOperator, Vector * rc, Vector * xc
   data.rc = rc;
   data.xc = xc;
   data.Axf = Axf;
+  data.restrictionTime = 0.0;
+  data.prolongationTime = 0.0;
+  data.cycleTime = 0.0;
+  data.numberOfCycles = 0;
   return;
 }
 
@@ -77,7 +85,7 @@ inline void InitializeMGData(local_int_t * f2cOperator, Vector * rc, Vector * xc
  */
 inline void DeleteMGData(MGData & data) {
 
-  delete [] data.f2cOperator;
+  TrackedFree(data.f2cOperator);
   DeleteVector(*data.Axf);
   DeleteVector(*data.rc);
   DeleteVector(*data.xc);
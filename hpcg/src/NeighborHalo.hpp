@@ -0,0 +1,79 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file NeighborHalo.hpp
+
+ HPCG halo exchange through neighborhood collectives on a distributed graph communicator
+ */
+
+#ifndef NEIGHBORHALO_HPP
+#define NEIGHBORHALO_HPP
+
+#define HPCG_HALO_BACKEND_P2P      0 //!< MPI_Alltoallv on MPI_COMM_WORLD, point-to-point messages for split-phase exchanges
+#define HPCG_HALO_BACKEND_NEIGHBOR 1 //!< MPI_Ineighbor_alltoallv on a distributed graph communicator of the neighbors
+#define HPCG_HALO_BACKEND_RMA      2 //!< MPI_Put into windows over the ghost regions of the neighbors, see RmaHalo.hpp
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#include "Geometry.hpp"
+#include "TrackedAllocator.hpp"
+
+/*!
+  Distributed graph communicator of one level, with the neighbors of the level as both sources
+  and destinations in the order of A.neighbors, and the counts of the neighborhood collective.
+*/
+struct NeighborHalo_STRUCT {
+  MPI_Comm comm;         //!< distributed graph communicator, ranks are not reordered
+  int * sendCounts;      //!< values sent to each neighbor
+  int * sendDispls;      //!< numberOfSendNeighbors+1 offsets of these values in A.sendBuffer
+  int * receiveCounts;   //!< values received from each neighbor
+  int * receiveDispls;   //!< numberOfSendNeighbors+1 offsets of these values in the halo part of x
+  double * receiveBuffer; //!< fixed receive buffer bound to the persistent request, NULL without one
+  MPI_Request persistent; //!< persistent neighborhood alltoallv (MPI 4), MPI_REQUEST_NULL if the library has none
+};
+typedef struct NeighborHalo_STRUCT NeighborHalo;
+
+/*!
+  Frees the communicator, the persistent request and the counts of a neighborhood halo.
+
+  @param[inout] nh The neighborhood halo, may be NULL
+*/
+inline void DeleteNeighborHalo(NeighborHalo * nh) {
+  if (nh == NULL) return;
+  if (nh->persistent != MPI_REQUEST_NULL) MPI_Request_free(&nh->persistent);
+  if (nh->comm != MPI_COMM_NULL) MPI_Comm_free(&nh->comm);
+  TrackedFree(nh->sendCounts);
+  TrackedFree(nh->sendDispls);
+  TrackedFree(nh->receiveCounts);
+  TrackedFree(nh->receiveDispls);
+  TrackedFree(nh->receiveBuffer);
+  delete nh;
+}
+#endif
+
+#endif // NEIGHBORHALO_HPP
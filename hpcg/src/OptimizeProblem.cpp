@@ -32,6 +32,8 @@
  */
 
 #include "OptimizeProblem.hpp"
+#include "LocalOrdering.hpp"
+#include "ParallelScan.hpp"
 /*!
   Optimizes the data structures used for CG iteration to increase the
   performance of the benchmark version of the preconditioned CG algorithm.
@@ -49,6 +51,9 @@
 */
 #include "stdio.h"
 #include "math.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
 
 #include "mkl.h"
 
@@ -56,38 +61,271 @@
 #include <omp.h>
 #endif
 
+static bool retainOptimizedCsr = false;
+static int optimizeInPlace = 1;
+static OptimizeProblemStats optimizeStats = { 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+/*!
+  Selects whether OptimizeProblem keeps the CSR arrays of every level in optData->csr after
+  the MKL handles are created, for a checkpoint or a check of the optimized levels right after it.
+
+  @param[in] retain true to keep the arrays
+
+  @see ReleaseOptimizedCsr
+*/
+void RetainOptimizedCsr(bool retain) {
+  retainOptimizedCsr = retain;
+  return;
+}
+
+/*!
+  Selects whether OptimizeProblem packs the local CSR block into the mtxL and mtxA slabs of a level
+  instead of copying it into new arrays, which keeps the level from holding both at the same time.
+
+  @param[in] enabled 1 to pack in place (the default), 0 to copy
+
+  @see GetOptimizeProblemStats
+*/
+void InitializeOptimizeInPlace(int enabled) {
+  optimizeInPlace = enabled;
+  return;
+}
+
+/*!
+  @param[out] stats Levels converted by the last OptimizeProblem call and the tracked bytes of this process
+                    before, at the peak of and after the conversion
+*/
+void GetOptimizeProblemStats(OptimizeProblemStats & stats) {
+  stats = optimizeStats;
+  return;
+}
+
+/*!
+  Frees the CSR arrays kept by OptimizeProblem on every level, once nothing reads them any more.
+
+  @param[inout] A The fine level of the hierarchy
+*/
+void ReleaseOptimizedCsr(SparseMatrix & A) {
+  for (SparseMatrix * Ac = &A; Ac != NULL; Ac = Ac->Ac) {
+    struct optData * optData = (struct optData *) Ac->optimizationData;
+    if (optData == NULL) continue;
+    DeleteOptimizedCsr(optData->csr);
+    optData->csr = NULL;
+  }
+  return;
+}
+
+#ifndef HPCG_LOCAL_LONG_LONG
+/*!
+  Creates and optimizes the MKL handles of one level from its CSR arrays and allocates the
+  work arrays of the optimized kernels. Shared by OptimizeProblem and the checkpoint reload.
+
+  @param[inout] A       The matrix of the level, receives optData as its optimizationData
+  @param[inout] optData Optimization data with diag, bmap, nrow_b, cmat and localOrder already set
+  @param[in]    csr     The local and halo CSR blocks; MKL copies them, the caller keeps ownership
+  @param[inout] t7      Accumulates the time spent inside MKL
+
+  @return Returns zero on success and a non-zero value if memory is exhausted, in which case
+          no handle was created and A is unchanged
+*/
+int CreateOptimizedLevel(SparseMatrix & A, struct optData * optData, const OptimizedCsr & csr, double & t7) {
+    const local_int_t nrow = csr.nrow;
+    // Allocated first, so a failure leaves nothing behind for the caller to release
+    double *dtmp = (double *)TrackedMalloc(sizeof(double)*4*nrow, HPCG_MEM_SCRATCH);
+    if ( dtmp == NULL ) return 1;
+
+    double t1 = mytimer();
+
+    sparse_status_t status = SPARSE_STATUS_SUCCESS;
+    struct matrix_descr descr;
+    sparse_matrix_t csrA = NULL, csrB = NULL;
+    descr.type = SPARSE_MATRIX_TYPE_SYMMETRIC;
+    descr.mode = SPARSE_FILL_MODE_FULL;
+    descr.diag = SPARSE_DIAG_NON_UNIT;
+
+    status = mkl_sparse_d_create_csr ( &csrA, SPARSE_INDEX_BASE_ZERO, nrow, nrow, csr.ia, csr.ia+1, csr.ja, csr.a );
+
+    status = mkl_sparse_d_create_csr ( &csrB, SPARSE_INDEX_BASE_ZERO, csr.nrow_b, csr.ncol, csr.ia_b, csr.ia_b+1, csr.ja_b, csr.a_b );
+
+    status = mkl_sparse_set_symgs_hint ( csrA, SPARSE_OPERATION_NON_TRANSPOSE, descr, 20);
+    status = mkl_sparse_set_memory_hint( csrA, SPARSE_MEMORY_NONE);
+
+
+    descr.type = SPARSE_MATRIX_TYPE_GENERAL;
+    descr.mode = SPARSE_FILL_MODE_FULL;
+    descr.diag = SPARSE_DIAG_NON_UNIT;
+    status = mkl_sparse_set_mv_hint ( csrB, SPARSE_OPERATION_NON_TRANSPOSE, descr, 199);
+
+    status = mkl_sparse_optimize( csrA );
+
+    status = mkl_sparse_optimize(csrB);
+
+    t7 += (mytimer() - t1);
+
+    // MKL keeps its own copy of both matrices; account for it as plain CSR storage
+    double mklBytes = (double)(nrow + 1 + csr.nnz)*sizeof(local_int_t) + (double)csr.nnz*sizeof(double)
+                    + (double)(csr.nrow_b + 1 + csr.nnz_b)*sizeof(local_int_t) + (double)csr.nnz_b*sizeof(double);
+    TrackMemory(HPCG_MEM_MKL, mklBytes);
+
+    optData->csrA  = csrA;
+    optData->csrB  = csrB;
+    optData->dtmp  = dtmp;
+    optData->dtmp2 = dtmp + nrow;
+    optData->dtmp3 = dtmp + 2*nrow;
+    optData->dtmp4 = dtmp + 3*nrow;
+    optData->mklBytes = mklBytes;
+
+    A.optimizationData = optData;
+    return 0;
+}
+#endif
+
+#ifndef HPCG_LOCAL_LONG_LONG
+/*!
+  Checks that the rows of a level are stored one after the other in the mtxL and mtxA slabs,
+  as GenerateProblem and ImportProblem lay them out. Local ordering permutes the row pointers,
+  so a renumbered level fails the check and is copied instead.
+
+  @param[in] A The matrix of the level
+
+  @return true if row i+1 starts no earlier than the end of row i in both slabs
+*/
+static bool RowsFollowSlabs(const SparseMatrix & A) {
+  const local_int_t nrow = A.localNumberOfRows;
+  if ( A.mtxL == NULL || A.mtxA == NULL || nrow == 0 ) return false;
+  if ( A.mtxIndL[0] != A.mtxL || A.matrixValues[0] != A.mtxA ) return false;
+  int ordered = 1;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for reduction(&:ordered)
+#endif
+  for ( local_int_t i = 0; i < nrow; i++ ) {
+    const local_int_t offset = A.mtxIndL[i] - A.mtxL;
+    if ( A.matrixValues[i] - A.mtxA != offset ) ordered = 0;
+    if ( i+1 < nrow && A.mtxIndL[i+1] - A.mtxIndL[i] < A.nonzerosInRow[i] ) ordered = 0;
+  }
+  return ordered != 0;
+}
+
+/*!
+  Packs the local entries of every row into CSR order at the start of the mtxL and mtxA slabs and
+  copies the halo entries of the boundary rows to ja_b and a_b, in one pass over the rows.
+
+  Every block of rows is first packed at the start of its own part of the slabs, which only moves
+  entries down inside the block, so the blocks are independent. The blocks are then moved down to
+  their final offsets in order, each one onto space its predecessors have already vacated.
+
+  @param[inout] A      The matrix of the level; its rows must pass RowsFollowSlabs
+  @param[in]    nthr   Number of row blocks, one per thread
+  @param[in]    ia     Row offsets of the local block
+  @param[in]    ia_b   Row offsets of the halo block
+  @param[in]    bmap   Local row of every boundary row, in increasing order
+  @param[in]    nrow_b Number of boundary rows
+  @param[out]   ja_b   Column indices of the halo block
+  @param[out]   a_b    Values of the halo block
+*/
+static void CompactRowsInPlace(SparseMatrix & A, local_int_t nthr, const local_int_t * ia, const local_int_t * ia_b,
+    const local_int_t * bmap, local_int_t nrow_b, local_int_t * ja_b, double * a_b) {
+  const local_int_t nrow = A.localNumberOfRows;
+  const int nblocks = nthr > 0 ? (int) nthr : 1;
+  std::vector<local_int_t> blockStart(nblocks, 0);
+
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for num_threads(nblocks) schedule(static, 1)
+#endif
+  for ( int t = 0; t < nblocks; t++ ) {
+    const local_int_t begin = (t*nrow)/nblocks, end = ((t+1)*nrow)/nblocks;
+    if ( begin == end ) continue;
+    local_int_t w = A.mtxIndL[begin] - A.mtxL;
+    blockStart[t] = w;
+    local_int_t k = std::lower_bound(bmap, bmap + nrow_b, begin) - bmap;
+    for ( local_int_t i = begin; i < end; i++ ) {
+      const local_int_t * const cur_inds = A.mtxIndL[i];
+      const double * const cur_vals = A.matrixValues[i];
+      const int n = A.nonzerosInRow[i];
+      // The halo entries go first, the local pass below may overwrite them
+      if ( k < nrow_b && bmap[k] == i ) {
+        local_int_t p = ia_b[k];
+        for ( int j = 0; j < n; j++ ) {
+          if ( cur_inds[j] >= nrow ) {
+            ja_b[p] = cur_inds[j];
+            a_b[p] = cur_vals[j];
+            p++;
+          }
+        }
+        k++;
+      }
+      for ( int j = 0; j < n; j++ ) {
+        if ( cur_inds[j] < nrow ) {
+          const local_int_t col = cur_inds[j];
+          const double val = cur_vals[j];
+          A.mtxL[w] = col;
+          A.mtxA[w] = val;
+          w++;
+        }
+      }
+    }
+  }
+
+  for ( int t = 1; t < nblocks; t++ ) {
+    const local_int_t begin = (t*nrow)/nblocks, end = ((t+1)*nrow)/nblocks;
+    if ( begin == end || blockStart[t] == ia[begin] ) continue;
+    const size_t len = ia[end] - ia[begin];
+    memmove(A.mtxL + ia[begin], A.mtxL + blockStart[t], len*sizeof(local_int_t));
+    memmove(A.mtxA + ia[begin], A.mtxA + blockStart[t], len*sizeof(double));
+  }
+  return;
+}
+#endif
+
 void OptimizeProblem(SparseMatrix * A, double & t7)
 {
     t7 = 0.0;
+    const double t0 = mytimer();
+    optimizeStats.levels = 0;
+    optimizeStats.inPlaceLevels = 0;
+    optimizeStats.bytesBefore = ResetTrackedWindowPeak();
+    optimizeStats.conversionPeakBytes = optimizeStats.peakBytes = optimizeStats.bytesBefore;
+    double bytesNow = 0.0;
 #ifndef HPCG_LOCAL_LONG_LONG
-    double t1 = 0.0;
   // This function can be used to completely transform any part of the data structures.
   // Right now it does nothing, so compiling with a check for unused variables results in complaints
 
 //    SparseMatrix *Ac = &A;
     SparseMatrix *Ac = A;
+    SparseMatrix *finer = NULL;
     while (Ac != NULL) {
-    local_int_t i, j, k, l, p;
-    struct optData *optData = (struct optData *)mkl_malloc(sizeof(struct optData),128);
+    local_int_t i, j, k, p;
+    struct optData *optData = (struct optData *)TrackedMalloc(sizeof(struct optData), HPCG_MEM_MATRIX);
     const local_int_t nrow = Ac->localNumberOfRows;
     const local_int_t ncol = Ac->localNumberOfColumns;
     local_int_t nnz = 0, nrow_b = 0, nnz_b = 0;
     local_int_t nthr = A->nproc;
-    if( Ac->mtxIndG ) { MKL_free(Ac->mtxIndG);       Ac->mtxIndG       = NULL; }
+    if( Ac->mtxIndG ) { TrackedFree(Ac->mtxIndG);       Ac->mtxIndG       = NULL; }
+
+    // Interior rows first, boundary rows last; bmap below then lists one contiguous range
+    local_int_t *localOrder = NULL;
+    if ( UseLocalOrdering() && Ac->geom->size > 1 )
+    {
+        localOrder = RenumberLocalRows(*Ac, finer);
+        if ( localOrder == NULL ) return;
+    }
+    // The optimized restriction and prolongation compute the structured injection on the fly,
+    // which renumbered rows do not follow; they keep using f2cOperator instead
+    if( localOrder == NULL && Ac->mgData != NULL && Ac->mgData->f2cOperator ) { TrackedFree(Ac->mgData->f2cOperator); Ac->mgData->f2cOperator = NULL; }
 
-    local_int_t *ia   = (local_int_t*)mkl_malloc(sizeof(local_int_t)*(nrow+1), 512);
-    local_int_t *ia_b = (local_int_t*)mkl_malloc(sizeof(local_int_t)*(nrow+1), 512);
-    local_int_t *bmap = (local_int_t*)mkl_malloc(sizeof(local_int_t)*nrow, 512);
-    double *diag = (double *)mkl_malloc(sizeof(double)*nrow, 512);
+    local_int_t *ia   = (local_int_t*)TrackedMalloc(sizeof(local_int_t)*(nrow+1), HPCG_MEM_MATRIX);
+    local_int_t *rowHalo = (local_int_t*)TrackedMalloc(sizeof(local_int_t)*nrow, HPCG_MEM_MATRIX);
+    local_int_t *bmap = (local_int_t*)TrackedMalloc(sizeof(local_int_t)*nrow, HPCG_MEM_MATRIX);
+    double *diag = (double *)TrackedMalloc(sizeof(double)*nrow, HPCG_MEM_MATRIX);
 
-    if ( ia == NULL || ia_b == NULL || bmap == NULL || diag == NULL || optData == NULL ) return;
+    if ( ia == NULL || rowHalo == NULL || bmap == NULL || diag == NULL || optData == NULL ) return;
 
     init_optData(*optData);
 
     //calculate mkl csr arrays from hpcg matrix representation
-    ia_b[0] = ia[0] = 0;
+    ia[0] = 0;
 #ifndef HPCG_NO_OPENMP    
-    #pragma omp parallel num_threads(nthr) default(shared) private(i,j) reduction(+:nnz)
+    #pragma omp parallel num_threads(nthr) default(shared) private(i,j) reduction(+:nnz,nrow_b)
 #endif    
     {
 #ifndef HPCG_NO_OPENMP    
@@ -100,75 +338,95 @@ void OptimizeProblem(SparseMatrix * A, double & t7)
         {
             const double * const cur_vals = Ac->matrixValues[i];
             const local_int_t *  const cur_inds = Ac->mtxIndL[i];
-            ia_b[i+1] = ia[i+1] = 0;
+            rowHalo[i] = ia[i+1] = 0;
             for (j = 0; j < Ac->nonzerosInRow[i]; j++)
             {
                 if ( cur_inds[j] < nrow ) ia[i+1] ++;
-                else                      ia_b[i+1] ++;
+                else                      rowHalo[i] ++;
                 if ( cur_inds[j] == i )
                 {
                     diag[i] = cur_vals[j];
                 }
             }
             nnz += ia[i+1];//Ac->nonzerosInRow[i];
+            if ( rowHalo[i] > 0 ) nrow_b ++;
         }
     }
 
-    for ( i = 0; i < nrow; i ++ ) ia[i+1] += ia[i];
-    nrow_b = 0;
-    for ( i = 0; i < nrow; i ++ )
+    ParallelPrefixSum(ia+1, nrow);
+
+    // Boundary rows in order with their halo counts, then the counts become the offsets of the halo block
+    local_int_t *ia_b = (local_int_t*)TrackedMalloc(sizeof(local_int_t)*(nrow_b+1), HPCG_MEM_MATRIX);
+    if ( ia_b == NULL ) return;
+    ia_b[0] = 0;
+    ParallelSelectRows(rowHalo, nrow, bmap, ia_b+1);
+    TrackedFree(rowHalo);
+    nnz_b = ParallelPrefixSum(ia_b+1, nrow_b);
+
+    // The compressed format is built from the row-wise arrays, so it has to happen before they go away
+    CompressedMatrix *cmat = NULL;
+    if ( UseCompressedMatrix() )
     {
-        if( ia_b[i+1] > 0 )
-        {
-            nnz_b += ia_b[i+1];
-            nrow_b ++;
-        }
+        cmat = BuildCompressedMatrix(*Ac);
+        if ( cmat == NULL ) return;
     }
 
-    local_int_t *ja = (local_int_t *)mkl_malloc(sizeof(local_int_t)*nnz, 512);
-    double *a = (double *)mkl_malloc(sizeof(double)*nnz, 512);
+    local_int_t *ja_b = (local_int_t *)TrackedMalloc(sizeof(local_int_t)*nnz_b, HPCG_MEM_MATRIX);
+    double *a_b = (double *)TrackedMalloc(sizeof(double)*nnz_b, HPCG_MEM_MATRIX);
+
+    if ( (ja_b == NULL || a_b == NULL) && nnz_b > 0 ) return;
+
+    local_int_t *ja = NULL;
+    double *a = NULL;
+    if ( optimizeInPlace && RowsFollowSlabs(*Ac) )
+    {
+        // The slabs become ja and a; they keep their generated size until the level is released
+        CompactRowsInPlace(*Ac, nthr, ia, ia_b, bmap, nrow_b, ja_b, a_b);
+        ja = Ac->mtxL; Ac->mtxL = NULL;
+        a  = Ac->mtxA; Ac->mtxA = NULL;
+        optimizeStats.inPlaceLevels ++;
+    } else
+    {
+        ja = (local_int_t *)TrackedMalloc(sizeof(local_int_t)*nnz, HPCG_MEM_MATRIX);
+        a = (double *)TrackedMalloc(sizeof(double)*nnz, HPCG_MEM_MATRIX);
 
-    if ( ja == NULL || a == NULL ) return;
+        if ( ja == NULL || a == NULL ) return;
 #ifndef HPCG_NO_OPENMP
-    #pragma omp parallel num_threads(nthr) default(shared) private(i,j,k,l,p)
+        #pragma omp parallel num_threads(nthr) default(shared) private(i,j,k)
 #endif
-    {
-#ifndef HPCG_NO_OPENMP    
-        int ithr = omp_get_thread_num();
+        {
+#ifndef HPCG_NO_OPENMP
+            int ithr = omp_get_thread_num();
 #else
-	int ithr = 0;
+            int ithr = 0;
 #endif
 
-        for (i = (ithr*nrow)/nthr; i < (ithr+1)*nrow/nthr; i++ )
-        {
-            const double * const cur_vals = Ac->matrixValues[i];
-            const local_int_t *  const cur_inds = Ac->mtxIndL[i];
-            k = ia[i];
-            for (j = 0; j<Ac->nonzerosInRow[i]; j++)
+            for (i = (ithr*nrow)/nthr; i < (ithr+1)*nrow/nthr; i++ )
             {
-                if ( cur_inds[j] < nrow )
+                const double * const cur_vals = Ac->matrixValues[i];
+                const local_int_t *  const cur_inds = Ac->mtxIndL[i];
+                k = ia[i];
+                for (j = 0; j<Ac->nonzerosInRow[i]; j++)
                 {
-                    a [k] = cur_vals[j];
-                    ja[k] = cur_inds[j];
-                    k ++;
+                    if ( cur_inds[j] < nrow )
+                    {
+                        a [k] = cur_vals[j];
+                        ja[k] = cur_inds[j];
+                        k ++;
+                    }
                 }
             }
         }
-    }
-
-    local_int_t *ja_b = (local_int_t *)mkl_malloc(sizeof(local_int_t)*nnz_b, 512);
-    double *a_b = (double *)mkl_malloc(sizeof(double)*nnz_b, 512);
-
-    if ( (ja_b == NULL || a_b == NULL) && nnz_b > 0 ) return;
-
-    p = k = 0;
-    for (i = 0; i < nrow; i++ )
-    {
-        const double * const cur_vals = Ac->matrixValues[i];
-        const local_int_t *  const cur_inds = Ac->mtxIndL[i];
 
-        if ( ia_b[i+1] > 0 )
+#ifndef HPCG_NO_OPENMP
+        #pragma omp parallel for num_threads(nthr) private(i,j,p)
+#endif
+        for (k = 0; k < nrow_b; k++ )
         {
+            i = bmap[k];
+            const double * const cur_vals = Ac->matrixValues[i];
+            const local_int_t *  const cur_inds = Ac->mtxIndL[i];
+            p = ia_b[k];
             for (j = 0; j<Ac->nonzerosInRow[i]; j++)
             {
                 if ( cur_inds[j] >= nrow )
@@ -178,70 +436,49 @@ void OptimizeProblem(SparseMatrix * A, double & t7)
                     p ++;
                 }
             }
-            bmap[k] = i;
-            ia_b[k+1] = ia_b[i+1];
-            k ++;
         }
     }
-    for ( i = 0; i < nrow_b; i ++ ) ia_b[i+1] += ia_b[i];
-
-    if(Ac->mtxL) { MKL_free(Ac->mtxL); Ac->mtxL          = NULL;}
-    if(Ac->mtxA) { MKL_free(Ac->mtxA); Ac->mtxA          = NULL;}
-    if(Ac->nonzerosInRow) { MKL_free(Ac->nonzerosInRow); Ac->nonzerosInRow = NULL; }
-    if(Ac->matrixValues) { MKL_free(Ac->matrixValues);  Ac->matrixValues  = NULL; }
-    if(Ac->mtxIndL) { MKL_free(Ac->mtxIndL);       Ac->mtxIndL       = NULL; }
 
-    t1 = mytimer();
+    if(Ac->mtxL) { TrackedFree(Ac->mtxL); Ac->mtxL          = NULL;}
+    if(Ac->mtxA) { TrackedFree(Ac->mtxA); Ac->mtxA          = NULL;}
+    if(Ac->nonzerosInRow) { TrackedFree(Ac->nonzerosInRow); Ac->nonzerosInRow = NULL; }
+    if(Ac->matrixValues) { TrackedFree(Ac->matrixValues);  Ac->matrixValues  = NULL; }
+    if(Ac->mtxIndL) { TrackedFree(Ac->mtxIndL);       Ac->mtxIndL       = NULL; }
 
-    sparse_status_t status = SPARSE_STATUS_SUCCESS;
-    struct matrix_descr descr;
-    sparse_matrix_t csrA = NULL, csrB = NULL;
-    descr.type = SPARSE_MATRIX_TYPE_SYMMETRIC;
-    descr.mode = SPARSE_FILL_MODE_FULL;
-    descr.diag = SPARSE_DIAG_NON_UNIT;
-
-    status = mkl_sparse_d_create_csr ( &csrA, SPARSE_INDEX_BASE_ZERO, nrow, nrow, ia, ia+1, ja, a );
-
-    status = mkl_sparse_d_create_csr ( &csrB, SPARSE_INDEX_BASE_ZERO, nrow_b, ncol, ia_b, ia_b+1, ja_b, a_b );
-
-    status = mkl_sparse_set_symgs_hint ( csrA, SPARSE_OPERATION_NON_TRANSPOSE, descr, 20);
-    status = mkl_sparse_set_memory_hint( csrA, SPARSE_MEMORY_NONE);
-
-
-    descr.type = SPARSE_MATRIX_TYPE_GENERAL;
-    descr.mode = SPARSE_FILL_MODE_FULL;
-    descr.diag = SPARSE_DIAG_NON_UNIT;
-    status = mkl_sparse_set_mv_hint ( csrB, SPARSE_OPERATION_NON_TRANSPOSE, descr, 199);
-
-    status = mkl_sparse_optimize( csrA );
-
-    mkl_free(ia); mkl_free(ja); mkl_free(a);
-
-    status = mkl_sparse_optimize(csrB);
-
-    t7 += (mytimer() - t1);
-
-    mkl_free(ia_b); mkl_free(ja_b); mkl_free(a_b);
-
-    double *dtmp = (double *)mkl_malloc(sizeof(double)*4*nrow, 512);
-
-    if ( dtmp == NULL ) return;
-
-    optData->csrA  = csrA;
-    optData->csrB  = csrB;
     optData->diag  = diag;
-    optData->dtmp  = dtmp;
-    optData->dtmp2 = dtmp + nrow;
-    optData->dtmp3 = dtmp + 2*nrow;
-    optData->dtmp4 = dtmp + 3*nrow;
     optData->bmap  = bmap;
     optData->nrow_b = nrow_b;
+    optData->cmat = cmat;
+    optData->deepHalo = NULL;
+    optData->localOrder = localOrder;
+    optData->csr = NULL;
+
+    // The window is split around the MKL handles, whose own copy sits on top of the CSR arrays either way
+    optimizeStats.conversionPeakBytes = std::max(optimizeStats.conversionPeakBytes, GetTrackedWindowPeak(bytesNow));
+    OptimizedCsr csr = { nrow, ncol, nnz, nrow_b, nnz_b, ia, ja, a, ia_b, ja_b, a_b, true };
+    if ( CreateOptimizedLevel(*Ac, optData, csr, t7) != 0 ) return;
+
+    // MKL holds its own copy from here on; a checkpoint written after this call still needs the arrays
+    if ( retainOptimizedCsr )
+    {
+        optData->csr = (OptimizedCsr *)TrackedMalloc(sizeof(OptimizedCsr), HPCG_MEM_MATRIX);
+        if ( optData->csr == NULL ) return;
+        *optData->csr = csr;
+    } else
+    {
+        TrackedFree(ia); TrackedFree(ja); TrackedFree(a);
+        TrackedFree(ia_b); TrackedFree(ja_b); TrackedFree(a_b);
+    }
 
-
-
-    Ac->optimizationData = optData;
+    optimizeStats.peakBytes = std::max(optimizeStats.peakBytes, GetTrackedWindowPeak(bytesNow));
+    ResetTrackedWindowPeak();
+    optimizeStats.levels ++;
+    finer = Ac;
     Ac = Ac->Ac;
     }//while Ac!=NULL
+    optimizeStats.bytesAfter = bytesNow;
+    optimizeStats.time = mytimer() - t0;
+    optimizeStats.mklTime = t7;
 #else
     return;
 #endif
@@ -250,6 +487,26 @@ void OptimizeProblem(SparseMatrix * A, double & t7)
 // Helper function (see OptimizeProblem.hpp for details)
 double OptimizeProblemMemoryUse(const SparseMatrix & A) {
 
-  return 0.0;
+  double numBytes = 0.0;
+  const SparseMatrix * Ac = &A;
+  while ( Ac != NULL ) {
+    const struct optData *optData = (const struct optData *)Ac->optimizationData;
+    if ( optData != NULL ) {
+      double nrow = (double) Ac->localNumberOfRows;
+      numBytes += sizeof(struct optData);
+      numBytes += nrow*sizeof(double);      // diag
+      numBytes += 4.0*nrow*sizeof(double);  // dtmp, dtmp2, dtmp3, dtmp4
+      numBytes += nrow*sizeof(local_int_t); // bmap
+      numBytes += optData->mklBytes;        // csrA and csrB handles
+      if ( optData->localOrder != NULL ) numBytes += nrow*sizeof(local_int_t); // localOrder
+      if ( optData->cmat != NULL ) {
+        numBytes += sizeof(CompressedMatrix);
+        numBytes += optData->cmat->nnz*((double) sizeof(double)); // values
+        numBytes += CompressedMatrixIndexBytes(*optData->cmat);
+      }
+    }
+    Ac = Ac->Ac;
+  }
+  return numBytes;
 
 }
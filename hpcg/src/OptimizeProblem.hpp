@@ -36,7 +36,27 @@
 #include "mkl_spblas.h"
 #include "mkl_service.h"
 //int OptimizeProblem(SparseMatrix & A, CGData & data,  Vector & b, Vector & x, Vector & xexact);
+
+//! Memory of this process around the conversion done by OptimizeProblem, in tracked bytes over all subsystems
+struct OptimizeProblemStats {
+  int levels;         //!< levels converted
+  int inPlaceLevels;  //!< levels whose local CSR block was packed into the generated slabs
+  double bytesBefore; //!< tracked bytes when OptimizeProblem started
+  double conversionPeakBytes; //!< largest tracked bytes while the row-wise arrays are converted to CSR, before the MKL handles exist
+  double peakBytes;   //!< largest tracked bytes during OptimizeProblem, including the creation of the MKL handles
+  double bytesAfter;  //!< tracked bytes when OptimizeProblem returned
+  double time;        //!< wall-clock time of the whole OptimizeProblem call
+  double mklTime;     //!< part of time spent creating and optimizing the MKL handles (t7)
+};
+
 void OptimizeProblem(SparseMatrix * A, double & t7);
+void RetainOptimizedCsr(bool retain);
+void InitializeOptimizeInPlace(int enabled);
+void GetOptimizeProblemStats(OptimizeProblemStats & stats);
+void ReleaseOptimizedCsr(SparseMatrix & A);
+#ifndef HPCG_LOCAL_LONG_LONG
+int CreateOptimizedLevel(SparseMatrix & A, struct optData * optData, const OptimizedCsr & csr, double & t7);
+#endif
 
 // This helper function should be implemented in a non-trivial way if OptimizeProblem is non-trivial
 // It should return as type double, the total number of bytes allocated and retained after calling OptimizeProblem.
@@ -0,0 +1,72 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file OptimizedCsr.hpp
+
+ HPCG local CSR arrays handed to the MKL sparse handles of one level
+ */
+
+#ifndef OPTIMIZEDCSR_HPP
+#define OPTIMIZEDCSR_HPP
+
+#include "Geometry.hpp"
+#include "TrackedAllocator.hpp"
+
+/*!
+  The two CSR matrices OptimizeProblem builds for a level: the local block, whose columns are
+  all below nrow, and the halo block, which holds the halo columns of the boundary rows listed
+  in optData->bmap. They are normally released once MKL has its copy; they are kept when a
+  later step (a checkpoint) still has to read them.
+*/
+struct OptimizedCsr_STRUCT {
+  local_int_t nrow;   //!< rows of the local block
+  local_int_t ncol;   //!< columns of the halo block, local rows plus halo entries
+  local_int_t nnz;    //!< nonzeros of the local block
+  local_int_t nrow_b; //!< rows of the halo block
+  local_int_t nnz_b;  //!< nonzeros of the halo block
+  local_int_t * ia;   //!< row pointers of the local block, nrow+1 entries
+  local_int_t * ja;   //!< column indices of the local block
+  double * a;         //!< values of the local block
+  local_int_t * ia_b; //!< row pointers of the halo block, nrow_b+1 entries
+  local_int_t * ja_b; //!< column indices of the halo block
+  double * a_b;       //!< values of the halo block
+  bool owned;         //!< the arrays come from TrackedMalloc and go away with the struct
+};
+typedef struct OptimizedCsr_STRUCT OptimizedCsr;
+
+inline void DeleteOptimizedCsr(OptimizedCsr * csr) {
+  if (csr == NULL) return;
+  if (csr->owned) {
+    TrackedFree(csr->ia); TrackedFree(csr->ja); TrackedFree(csr->a);
+    TrackedFree(csr->ia_b); TrackedFree(csr->ja_b); TrackedFree(csr->a_b);
+  }
+  TrackedFree(csr);
+  return;
+}
+
+#endif // OPTIMIZEDCSR_HPP
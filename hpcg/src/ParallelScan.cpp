@@ -0,0 +1,141 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ParallelScan.cpp
+
+ HPCG routine
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "ParallelScan.hpp"
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+// Below this many values per thread the serial loops are faster than a parallel region
+#define HPCG_SCAN_MIN_PER_THREAD 4096
+
+/*!
+  Replaces values by their inclusive prefix sum, values[i] = values[0] + ... + values[i].
+
+  Every thread scans its own block of values, the block totals are scanned by one thread,
+  and every thread then adds the total of the blocks before it to its block.
+
+  @param[inout] values Array of n values
+  @param[in]    n      Number of values
+
+  @return The sum of all values
+*/
+local_int_t ParallelPrefixSum(local_int_t * values, local_int_t n) {
+  if (n <= 0) return 0;
+#ifndef HPCG_NO_OPENMP
+  const int maxThreads = omp_get_max_threads();
+  if (maxThreads > 1 && n >= 2*HPCG_SCAN_MIN_PER_THREAD) {
+    std::vector<local_int_t> blockStart(maxThreads+1, 0);
+    #pragma omp parallel
+    {
+      const int nthr = omp_get_num_threads(), ithr = omp_get_thread_num();
+      const local_int_t begin = ((long long) ithr*n)/nthr, end = ((long long) (ithr+1)*n)/nthr;
+      local_int_t sum = 0;
+      for (local_int_t i = begin; i < end; i++) {
+        sum += values[i];
+        values[i] = sum;
+      }
+      blockStart[ithr+1] = sum;
+      #pragma omp barrier
+      #pragma omp single
+      for (int t = 0; t < nthr; t++) blockStart[t+1] += blockStart[t];
+      const local_int_t offset = blockStart[ithr];
+      if (offset != 0)
+        for (local_int_t i = begin; i < end; i++) values[i] += offset;
+    }
+    return values[n-1];
+  }
+#endif
+  for (local_int_t i = 1; i < n; i++) values[i] += values[i-1];
+  return values[n-1];
+}
+
+/*!
+  Lists the rows with a positive count in increasing order, in two passes over the rows:
+  every thread counts the selected rows of its block, the counts are scanned, then every
+  thread writes its rows from the offset of its block.
+
+  @param[in]  counts    Array of n counts, e.g. the halo entries of every row
+  @param[in]  n         Number of rows
+  @param[out] rows      The selected rows; room for all selected rows
+  @param[out] rowCounts If not NULL, the count of every selected row, in the order of rows
+
+  @return The number of selected rows
+*/
+local_int_t ParallelSelectRows(const local_int_t * counts, local_int_t n, local_int_t * rows, local_int_t * rowCounts) {
+  if (n <= 0) return 0;
+#ifndef HPCG_NO_OPENMP
+  const int maxThreads = omp_get_max_threads();
+  if (maxThreads > 1 && n >= 2*HPCG_SCAN_MIN_PER_THREAD) {
+    std::vector<local_int_t> blockStart(maxThreads+1, 0);
+    int numberOfBlocks = 1;
+    #pragma omp parallel
+    {
+      const int nthr = omp_get_num_threads(), ithr = omp_get_thread_num();
+      const local_int_t begin = ((long long) ithr*n)/nthr, end = ((long long) (ithr+1)*n)/nthr;
+      local_int_t selected = 0;
+      for (local_int_t i = begin; i < end; i++)
+        if (counts[i] > 0) selected++;
+      blockStart[ithr+1] = selected;
+      #pragma omp barrier
+      #pragma omp single
+      {
+        for (int t = 0; t < nthr; t++) blockStart[t+1] += blockStart[t];
+        numberOfBlocks = nthr;
+      }
+      local_int_t k = blockStart[ithr];
+      for (local_int_t i = begin; i < end; i++) {
+        if (counts[i] > 0) {
+          rows[k] = i;
+          if (rowCounts != NULL) rowCounts[k] = counts[i];
+          k++;
+        }
+      }
+    }
+    return blockStart[numberOfBlocks];
+  }
+#endif
+  local_int_t k = 0;
+  for (local_int_t i = 0; i < n; i++) {
+    if (counts[i] > 0) {
+      rows[k] = i;
+      if (rowCounts != NULL) rowCounts[k] = counts[i];
+      k++;
+    }
+  }
+  return k;
+}
@@ -0,0 +1,42 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ParallelScan.hpp
+
+ HPCG prefix sums and row selection shared by the setup code
+ */
+
+#ifndef PARALLELSCAN_HPP
+#define PARALLELSCAN_HPP
+
+#include "Geometry.hpp"
+
+local_int_t ParallelPrefixSum(local_int_t * values, local_int_t n);
+local_int_t ParallelSelectRows(const local_int_t * counts, local_int_t n, local_int_t * rows, local_int_t * rowCounts);
+
+#endif // PARALLELSCAN_HPP
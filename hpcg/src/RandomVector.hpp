@@ -0,0 +1,94 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file RandomVector.hpp
+
+ HPCG counter-based random vectors keyed by global row
+ */
+
+#ifndef RANDOMVECTOR_HPP
+#define RANDOMVECTOR_HPP
+
+#include <stdint.h>
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+#include "RowIndexing.hpp"
+
+#define HPCG_RANDOM_SEED 0x48504347u // "HPCG"
+
+/*!
+  Philox2x32-10 (Salmon et al., SC'11): ten rounds of a 32x32->64 bit multiply and a key
+  bump turn a 64-bit counter into 64 random bits. The result depends on the counter and the
+  key only, so any element can be drawn independently of all the others.
+
+  @param[in] counter The counter, here the global row
+  @param[in] key     The key, here the seed mixed with the stream number
+
+  @return 64 random bits
+*/
+inline uint64_t Philox2x32(uint64_t counter, uint32_t key) {
+  uint32_t c0 = (uint32_t) counter;
+  uint32_t c1 = (uint32_t) (counter >> 32);
+  for (int round = 0; round < 10; ++round) {
+    const uint64_t product = (uint64_t) 0xD256D193u * c0;
+    c0 = (uint32_t) (product >> 32) ^ key ^ c1;
+    c1 = (uint32_t) product;
+    key += 0x9E3779B9u;
+  }
+  return ((uint64_t) c1 << 32) | c0;
+}
+
+/*!
+  Fill the local rows of a vector with values in [1,2), the range of the former rand() based
+  fill. Element i gets the value drawn for the global row of local row i, so the vector is
+  the same for every rank and thread layout and for any local ordering chosen by
+  OptimizeProblem. The halo entries are zeroed: every kernel refreshes them before use.
+
+  @param[in]    A      The matrix whose rows the vector is laid out on
+  @param[inout] v      The vector, of length nrow or ncol of A
+  @param[in]    stream Selects an independent sequence, so that several vectors can be drawn
+*/
+inline void FillRandomVector(const SparseMatrix & A, Vector & v, uint32_t stream) {
+  const local_int_t nrow = A.localNumberOfRows;
+  const local_int_t localLength = v.localLength;
+  const uint32_t key = HPCG_RANDOM_SEED ^ (stream*0xBB67AE85u);
+  double * vv = v.values;
+  assert(localLength >= nrow);
+#ifndef HPCG_NO_OPENMP
+  #pragma omp parallel for simd
+#endif
+  for (local_int_t i=0; i<nrow; ++i) {
+    // The top 53 bits fill the mantissa exactly
+    const uint64_t bits = Philox2x32((uint64_t) GlobalRowOfLocalRow(A, i), key);
+    vv[i] = 1.0 + (double) (bits >> 11)*(1.0/9007199254740992.0);
+  }
+  for (local_int_t i=nrow; i<localLength; ++i) vv[i] = 0.0;
+  return;
+}
+
+#endif // RANDOMVECTOR_HPP
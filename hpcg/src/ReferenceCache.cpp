@@ -0,0 +1,185 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ReferenceCache.cpp
+
+ HPCG routine
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#endif
+
+#include "ReferenceCache.hpp"
+
+#define HPCG_REFERENCE_CACHE_VERSION 1
+
+static int referenceCacheStatus = HPCG_REFERENCE_CACHE_OFF;
+
+/*
+  FNV-1a hash of everything the cached results depend on: the integer sizes of the build, the
+  global and process grid, the z partitions, the hierarchy depth, the iteration and call counts
+  of the reference phases and the threads per rank, which the reference timings depend on.
+*/
+static unsigned long long ReferenceKey(const Geometry & geom, int numberOfMgLevels, int refMaxIters, int numberOfCalls) {
+  std::vector<long long> key;
+  key.push_back(HPCG_REFERENCE_CACHE_VERSION);
+  key.push_back(sizeof(local_int_t));
+  key.push_back(sizeof(global_int_t));
+  key.push_back(geom.size);
+  key.push_back(geom.numThreads);
+  key.push_back(geom.gnx);
+  key.push_back(geom.gny);
+  key.push_back(geom.gnz);
+  key.push_back(geom.npx);
+  key.push_back(geom.npy);
+  key.push_back(geom.npz);
+  key.push_back(geom.pz);
+  for (int i = 0; i < geom.npartz; i++) {
+    key.push_back(geom.partz_ids[i]);
+    key.push_back(geom.partz_nz[i]);
+  }
+  key.push_back(numberOfMgLevels);
+  key.push_back(refMaxIters);
+  key.push_back(numberOfCalls);
+
+  unsigned long long hash = 14695981039346656037ULL;
+  const unsigned char * p = (const unsigned char *) &key[0];
+  for (size_t i = 0; i < key.size()*sizeof(long long); i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static void ReferenceCachePath(const char * directory, unsigned long long key, char * path, size_t length) {
+  snprintf(path, length, "%s/hpcg-reference.%016llx.txt", directory, key);
+  return;
+}
+
+/*!
+  Looks up the results of the reference phases of an earlier run with the same problem, process
+  grid and reference settings. Rank 0 reads the cache file and shares its contents, so every
+  rank continues with the same values.
+
+  @param[in]  directory       Directory of the cache files
+  @param[in]  geom            The geometry of the fine level
+  @param[in]  numberOfMgLevels Number of levels of the hierarchy
+  @param[in]  refMaxIters     Iterations of the reference CG run
+  @param[in]  numberOfCalls   Repetitions of the reference SpMV+MG timing
+  @param[out] data            The cached results, valid if zero is returned
+
+  @return Returns zero on every rank if a matching entry was found and a non-zero value otherwise
+
+  @see WriteReferenceCache
+*/
+int ReadReferenceCache(const char * directory, const Geometry & geom, int numberOfMgLevels, int refMaxIters,
+    int numberOfCalls, ReferenceCacheData & data) {
+  const unsigned long long key = ReferenceKey(geom, numberOfMgLevels, refMaxIters, numberOfCalls);
+  double values[4] = { 1.0, 0.0, 0.0, 0.0 }; // error flag, refTolerance, totalNiters_ref, spmvMgTime
+  if (geom.rank == 0) {
+    char path[1200];
+    ReferenceCachePath(directory, key, path, sizeof(path));
+    FILE * file = fopen(path, "r");
+    if (file != NULL) {
+      int version = 0, niters = 0;
+      unsigned long long fileKey = 0;
+      if (fscanf(file, "hpcg-reference %d\n", &version) == 1 && version == HPCG_REFERENCE_CACHE_VERSION
+          && fscanf(file, "key %llx\n", &fileKey) == 1 && fileKey == key
+          && fscanf(file, "refTolerance %lf\n", &values[1]) == 1
+          && fscanf(file, "totalNiters_ref %d\n", &niters) == 1
+          && fscanf(file, "spmvMgTime %lf\n", &values[3]) == 1) {
+        values[0] = 0.0;
+        values[2] = niters;
+      }
+      fclose(file);
+    }
+  }
+#ifndef HPCG_NO_MPI
+  MPI_Bcast(values, 4, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#endif
+  if (values[0] != 0.0) return 1;
+  data.refTolerance = values[1];
+  data.totalNiters_ref = (int) values[2];
+  data.spmvMgTime = values[3];
+  referenceCacheStatus = HPCG_REFERENCE_CACHE_USED;
+  return 0;
+}
+
+/*!
+  Stores the results of the reference phases for later runs with the same key. Rank 0 writes a
+  small text file, through a temporary name so that a concurrent reader never sees half of it.
+  The values are printed with 17 significant digits and read back bit for bit.
+
+  @param[in] directory       Directory of the cache files, which must exist
+  @param[in] geom            The geometry of the fine level
+  @param[in] numberOfMgLevels Number of levels of the hierarchy
+  @param[in] refMaxIters     Iterations of the reference CG run
+  @param[in] numberOfCalls   Repetitions of the reference SpMV+MG timing
+  @param[in] data            The results of this run's reference phases
+
+  @return Returns zero on every rank if the entry was stored and a non-zero value otherwise
+
+  @see ReadReferenceCache
+*/
+int WriteReferenceCache(const char * directory, const Geometry & geom, int numberOfMgLevels, int refMaxIters,
+    int numberOfCalls, const ReferenceCacheData & data) {
+  const unsigned long long key = ReferenceKey(geom, numberOfMgLevels, refMaxIters, numberOfCalls);
+  int ierr = 0;
+  if (geom.rank == 0) {
+    char path[1200], temporary[1220];
+    ReferenceCachePath(directory, key, path, sizeof(path));
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    FILE * file = fopen(temporary, "w");
+    if (file == NULL) ierr = 1;
+    else {
+      if (fprintf(file, "hpcg-reference %d\nkey %016llx\nrefTolerance %.17g\ntotalNiters_ref %d\nspmvMgTime %.17g\n",
+            HPCG_REFERENCE_CACHE_VERSION, key, data.refTolerance, data.totalNiters_ref, data.spmvMgTime) < 0) ierr = 1;
+      if (fclose(file) != 0) ierr = 1;
+      if (ierr == 0 && rename(temporary, path) != 0) ierr = 1;
+      if (ierr != 0) remove(temporary);
+    }
+  }
+#ifndef HPCG_NO_MPI
+  MPI_Bcast(&ierr, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+  referenceCacheStatus = (ierr == 0) ? HPCG_REFERENCE_CACHE_STORED : HPCG_REFERENCE_CACHE_FAILED;
+  return ierr;
+}
+
+/*!
+  @return One of the HPCG_REFERENCE_CACHE_* values describing where the reference results of this run came from
+*/
+int GetReferenceCacheStatus(void) {
+  return referenceCacheStatus;
+}
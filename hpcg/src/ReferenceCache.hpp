@@ -0,0 +1,60 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ReferenceCache.hpp
+
+ HPCG cache of the results of the reference timing and convergence phases
+ */
+
+#ifndef REFERENCECACHE_HPP
+#define REFERENCECACHE_HPP
+
+#include "Geometry.hpp"
+
+#define HPCG_REFERENCE_CACHE_OFF    0 //!< no --ref-cache directory given, the reference phases ran
+#define HPCG_REFERENCE_CACHE_STORED 1 //!< the reference phases ran and their results were stored
+#define HPCG_REFERENCE_CACHE_USED   2 //!< the results of an earlier matching run replaced the reference phases
+#define HPCG_REFERENCE_CACHE_FAILED 3 //!< the reference phases ran but their results could not be stored
+
+/*!
+  What the optimized phases take from the reference phases of main.
+*/
+struct ReferenceCacheData_STRUCT {
+  double refTolerance; //!< residual reduction of CG_ref after refMaxIters iterations
+  int totalNiters_ref; //!< iterations run by CG_ref
+  double spmvMgTime;   //!< time of one reference SpMV+MG pair, times[8]
+};
+typedef struct ReferenceCacheData_STRUCT ReferenceCacheData;
+
+int ReadReferenceCache(const char * directory, const Geometry & geom, int numberOfMgLevels, int refMaxIters,
+    int numberOfCalls, ReferenceCacheData & data);
+int WriteReferenceCache(const char * directory, const Geometry & geom, int numberOfMgLevels, int refMaxIters,
+    int numberOfCalls, const ReferenceCacheData & data);
+int GetReferenceCacheStatus(void);
+
+#endif // REFERENCECACHE_HPP
@@ -41,6 +41,16 @@
 //#include "YAML_Doc.hpp"
 #include "OutputFile.hpp"
 #include "OptimizeProblem.hpp"
+#include "HugePageAllocator.hpp"
+#include "TrackedAllocator.hpp"
+#include "ThreadTeam.hpp"
+#include "ComputeMGTasks.hpp"
+#include "CommThread.hpp"
+#include "CACG.hpp"
+#include "HaloBenchmark.hpp"
+#include "Checkpoint.hpp"
+#include "CheckProblem.hpp"
+#include "ReferenceCache.hpp"
 
 #ifdef HPCG_DEBUG
 #include <fstream>
@@ -50,6 +60,61 @@ using std::endl;
 #endif
 
 
+/*!
+  Gathers the memory of the OptimizeProblem conversion from all ranks; every rank has to call it.
+
+  @param[out] stats The statistics of the conversion, with inPlaceLevels the smallest value over the ranks
+                    and the byte counts and times the largest value over the ranks
+*/
+static void GatherOptimizeProblemStats(OptimizeProblemStats & stats) {
+  GetOptimizeProblemStats(stats);
+#ifndef HPCG_NO_MPI
+  double localValues[6] = { stats.bytesBefore, stats.conversionPeakBytes, stats.peakBytes, stats.bytesAfter, stats.time, stats.mklTime }, values[6];
+  MPI_Allreduce(localValues, values, 6, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  stats.bytesBefore = values[0];
+  stats.conversionPeakBytes = values[1];
+  stats.peakBytes = values[2];
+  stats.bytesAfter = values[3];
+  stats.time = values[4];
+  stats.mklTime = values[5];
+  int inPlaceLevels = stats.inPlaceLevels;
+  MPI_Allreduce(&inPlaceLevels, &stats.inPlaceLevels, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+#endif
+  return;
+}
+
+/*!
+  Adds the OptimizeProblem Memory and OptimizeProblem Time sections under the given YAML element.
+
+  @param[inout] setup The Setup Information element
+  @param[in]    stats The statistics returned by GatherOptimizeProblemStats
+*/
+static void AddOptimizeProblemStats(OutputFile * setup, const OptimizeProblemStats & stats) {
+  setup->add("OptimizeProblem Memory","");
+  OutputFile * memory = setup->get("OptimizeProblem Memory");
+  if (stats.levels == 0) {
+    memory->add("Conversion","not run");
+    return;
+  }
+  if (stats.inPlaceLevels == stats.levels)
+    memory->add("Conversion","in place");
+  else if (stats.inPlaceLevels == 0)
+    memory->add("Conversion","copy");
+  else
+    memory->add("Conversion","in place on some levels, copy on the others");
+  memory->add("Levels converted in place",stats.inPlaceLevels);
+  memory->add("Max per-rank tracked before (Gbytes)",stats.bytesBefore/1000000000.0);
+  memory->add("Max per-rank tracked peak of the CSR conversion (Gbytes)",stats.conversionPeakBytes/1000000000.0);
+  memory->add("Max per-rank tracked peak with the MKL handles (Gbytes)",stats.peakBytes/1000000000.0);
+  memory->add("Max per-rank tracked after (Gbytes)",stats.bytesAfter/1000000000.0);
+  // The Optimization phase time of the benchmark summary only counts the MKL part
+  setup->add("OptimizeProblem Time","");
+  OutputFile * time = setup->get("OptimizeProblem Time");
+  time->add("Max per-rank total (sec)",stats.time);
+  time->add("Max per-rank MKL handles (sec)",stats.mklTime);
+  return;
+}
+
 /*!
  Creates a YAML file and writes the information about the HPCG run, its results, and validity.
 
@@ -83,6 +148,165 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
   t4avg = t4avg/((double) A.geom->size);
 #endif
 
+  // Huge page usage is sampled while all matrices and vectors are still allocated
+  HugePageStats hugePageStats;
+  GetHugePageStats(hugePageStats);
+  double hugePageBytes[3] = { hugePageStats.mappedBytes, hugePageStats.backedBytes, (double) hugePageStats.fallbacks };
+#ifndef HPCG_NO_MPI
+  double localHugePageBytes[3] = { hugePageBytes[0], hugePageBytes[1], hugePageBytes[2] };
+  MPI_Allreduce(localHugePageBytes, hugePageBytes, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  // Snapshot bytes are summed over the ranks, the write or load time is the slowest rank
+  CheckpointStats checkpointStats;
+  GetCheckpointStats(checkpointStats);
+  double checkpointBytes = checkpointStats.bytes, checkpointTime = checkpointStats.time;
+#ifndef HPCG_NO_MPI
+  MPI_Allreduce(&checkpointStats.bytes, &checkpointBytes, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&checkpointStats.time, &checkpointTime, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  const char * checkpointStatus[4] = { "off", "written", "loaded", "failed" };
+
+  // Problem check times are the slowest rank
+  CheckProblemStats checkProblemStats;
+  GetCheckProblemStats(checkProblemStats);
+  double checkProblemTimes[2] = { checkProblemStats.time, checkProblemStats.optimizedTime };
+#ifndef HPCG_NO_MPI
+  double localCheckProblemTimes[2] = { checkProblemTimes[0], checkProblemTimes[1] };
+  MPI_Allreduce(localCheckProblemTimes, checkProblemTimes, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  const char * checkProblemMode[3] = { "reference", "fast", "fast and optimized" };
+  OptimizeProblemStats optimizeStats;
+  GatherOptimizeProblemStats(optimizeStats);
+  const int referenceCacheStatus = GetReferenceCacheStatus();
+  const char * referenceCacheStatusName[4] = { "off", "stored", "used", "failed" };
+
+  // OptimizeProblemMemoryUse reports the local part of the hierarchy
+  double fnbytes_OptimizedProblem = OptimizeProblemMemoryUse(A);
+
+  // Tracked allocations per subsystem, summed over ranks, plus the largest per-rank peak and peak RSS
+  double trackedCurrent[HPCG_MEM_COUNT], trackedPeak[HPCG_MEM_COUNT], trackedTotalPeak = 0.0;
+  GetTrackedMemory(trackedCurrent, trackedPeak, trackedTotalPeak);
+  double peakRSS = GetPeakRSS();
+  double trackedTotalPeakMax = trackedTotalPeak, peakRSSmin = peakRSS, peakRSSmax = peakRSS, peakRSSavg = peakRSS;
+#ifndef HPCG_NO_MPI
+  double localBytes = fnbytes_OptimizedProblem;
+  MPI_Allreduce(&localBytes, &fnbytes_OptimizedProblem, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  double localTracked[2*HPCG_MEM_COUNT];
+  for (int i=0; i<HPCG_MEM_COUNT; ++i) {
+    localTracked[i] = trackedCurrent[i];
+    localTracked[HPCG_MEM_COUNT+i] = trackedPeak[i];
+  }
+  double globalTracked[2*HPCG_MEM_COUNT];
+  MPI_Allreduce(localTracked, globalTracked, 2*HPCG_MEM_COUNT, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  for (int i=0; i<HPCG_MEM_COUNT; ++i) {
+    trackedCurrent[i] = globalTracked[i];
+    trackedPeak[i] = globalTracked[HPCG_MEM_COUNT+i];
+  }
+  MPI_Allreduce(&trackedTotalPeak, &trackedTotalPeakMax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(&peakRSS, &peakRSSmin, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&peakRSS, &peakRSSmax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(&peakRSS, &peakRSSavg, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  peakRSSavg = peakRSSavg/((double) A.geom->size);
+#endif
+
+  // Index storage of the CSR handles versus the compressed format, summed over levels and ranks
+  double indexStats[4] = { 0.0, 0.0, 0.0, 0.0 }; // nonzeros, CSR index bytes, compressed index bytes, exception rows
+  for (const SparseMatrix * Ai = &A; Ai != 0; Ai = Ai->Ac) {
+    const struct optData * optData = (const struct optData *) Ai->optimizationData;
+    if (optData == 0 || optData->cmat == 0) continue;
+    indexStats[0] += optData->cmat->nnz;
+    indexStats[1] += optData->mklBytes - optData->cmat->nnz*((double) sizeof(double)) + optData->nrow_b*((double) sizeof(local_int_t)); // ia, ja, ia_b, ja_b, bmap
+    indexStats[2] += CompressedMatrixIndexBytes(*optData->cmat);
+    indexStats[3] += optData->cmat->numberOfExceptions;
+  }
+#ifndef HPCG_NO_MPI
+  double localIndexStats[4] = { indexStats[0], indexStats[1], indexStats[2], indexStats[3] };
+  MPI_Allreduce(localIndexStats, indexStats, 4, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  // Per-level V-cycle timings (slowest rank) and fine grid rows whose residual was evaluated
+  std::vector<double> mgTimes(3*numberOfMgLevels, 0.0), mgRows(2*numberOfMgLevels, 0.0);
+  {
+    int level = 0;
+    for (const SparseMatrix * Ai = &A; Ai != 0 && Ai->mgData != 0; Ai = Ai->Ac, ++level) {
+      const struct optData * optData = (const struct optData *) Ai->optimizationData;
+      const MGData * mg = Ai->mgData;
+      const double cycles = (mg->numberOfCycles > 0) ? (double) mg->numberOfCycles : 1.0;
+      const bool fused = (optData != 0 && optData->cmat != 0);
+      const double nc = mg->rc->localLength;
+      mgTimes[3*level] = mg->restrictionTime/cycles;
+      mgTimes[3*level+1] = mg->prolongationTime/cycles;
+      mgTimes[3*level+2] = mg->cycleTime/cycles;
+      mgRows[2*level] = fused ? nc : (double) Ai->localNumberOfRows;
+      // Bytes of the residual rows that were skipped: matrix values and indices, plus the Axf write and read
+      mgRows[2*level+1] = fused ? (Ai->localNumberOfRows - nc)*(((double) Ai->localNumberOfNonzeros)/Ai->localNumberOfRows*
+                                  (sizeof(double)+sizeof(local_int_t)) + 2.0*sizeof(double)) : 0.0;
+    }
+  }
+#ifndef HPCG_NO_MPI
+  std::vector<double> localMgTimes(mgTimes), localMgRows(mgRows);
+  MPI_Allreduce(&localMgTimes[0], &mgTimes[0], 3*numberOfMgLevels, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(&localMgRows[0], &mgRows[0], 2*numberOfMgLevels, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  // Halo exchanges and bytes on the wire of every level (all levels, CG and MG), summed over ranks
+  std::vector<double> haloTraffic(2*numberOfMgLevels, 0.0);
+  std::vector<int> haloModes(numberOfMgLevels, HPCG_HALO_DOUBLE);
+#ifndef HPCG_NO_MPI
+  {
+    int level = 0;
+    for (const SparseMatrix * Ai = &A; Ai != 0 && level < numberOfMgLevels; Ai = Ai->Ac, ++level) {
+      if (Ai->haloPrecision == 0) continue;
+      haloModes[level] = Ai->haloPrecision->mode;
+      haloTraffic[2*level] = (double) Ai->haloPrecision->exchanges;
+      haloTraffic[2*level+1] = Ai->haloPrecision->bytesOnWire;
+    }
+  }
+  std::vector<double> localHaloTraffic(haloTraffic);
+  MPI_Allreduce(&localHaloTraffic[0], &haloTraffic[0], 2*numberOfMgLevels, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  // Lifetime of the non-blocking communication steps and the part the callers spent waiting, summed over ranks
+  CommThreadStats commStats;
+  GetCommThreadStats(commStats);
+  double commTimes[3] = { (double) commStats.operations, commStats.lifetime, commStats.waitTime };
+#ifndef HPCG_NO_MPI
+  double localCommTimes[3] = { commTimes[0], commTimes[1], commTimes[2] };
+  MPI_Allreduce(localCommTimes, commTimes, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  // Dispatch cost of the worker team against OpenMP parallel regions (slowest rank)
+  const ThreadTeamLevelTimes * teamLevels = 0;
+  double teamBarrierTime = 0.0;
+  const int teamNumberOfLevels = GetThreadTeamBenchmark(&teamLevels, teamBarrierTime);
+  std::vector<double> teamTimes(2*teamNumberOfLevels+1, 0.0);
+  teamTimes[0] = teamBarrierTime;
+  for (int i=0; i<teamNumberOfLevels; ++i) {
+    teamTimes[2*i+1] = teamLevels[i].teamTime;
+    teamTimes[2*i+2] = teamLevels[i].openmpTime;
+  }
+#ifndef HPCG_NO_MPI
+  std::vector<double> localTeamTimes(teamTimes);
+  MPI_Allreduce(&localTeamTimes[0], &teamTimes[0], 2*teamNumberOfLevels+1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+
+  // Seconds per halo exchange of every level and transport (slowest rank)
+  const HaloBenchmarkLevel * haloLevels = 0;
+  const int haloBenchLevels = GetHaloBenchmark(&haloLevels);
+  std::vector<double> haloBenchTimes(HPCG_HALO_TRANSPORTS*haloBenchLevels, 0.0);
+  for (int i=0; i<haloBenchLevels; ++i)
+    for (int t=0; t<HPCG_HALO_TRANSPORTS; ++t) haloBenchTimes[HPCG_HALO_TRANSPORTS*i+t] = haloLevels[i].time[t];
+#ifndef HPCG_NO_MPI
+  if (haloBenchLevels > 0) {
+    std::vector<double> localHaloBenchTimes(haloBenchTimes);
+    MPI_Allreduce(&localHaloBenchTimes[0], &haloBenchTimes[0], HPCG_HALO_TRANSPORTS*haloBenchLevels, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  }
+  long long windowExchanges = 0;
+  for (const SparseMatrix * Ai = &A; Ai != 0; Ai = Ai->Ac)
+    if (Ai->rmaHalo != 0) windowExchanges += Ai->rmaHalo->exchanges;
+#endif
+
   // initialize YAML doc
 
   if (A.geom->rank==0) { // Only PE 0 needs to compute and report timing results
@@ -158,13 +382,14 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
 
     // Data in GenerateProblem_ref
 
-    double numberOfNonzerosPerRow = 27.0; // We are approximating a 27-point finite element/volume/difference 3D stencil
     double size = ((double) A.geom->size); // Needed for estimating size of halo
 
     double fnbytes = ((double) sizeof(Geometry));      // Geometry struct in main.cpp
     fnbytes += ((double) sizeof(double)*fNumberOfCgSets); // testnorms_data in main.cpp
 
     // Model for GenerateProblem_ref.cpp
+#ifdef HPCG_LOCAL_LONG_LONG
+    double numberOfNonzerosPerRow = 27.0; // We are approximating a 27-point finite element/volume/difference 3D stencil
     fnbytes += fnrow*sizeof(char);      // array nonzerosInRow
     fnbytes += fnrow*((double) sizeof(global_int_t*)); // mtxIndG
     fnbytes += fnrow*((double) sizeof(local_int_t*));  // mtxIndL
@@ -173,6 +398,10 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     fnbytes += fnrow*numberOfNonzerosPerRow*((double) sizeof(local_int_t));  // mtxIndL[1..nrows]
     fnbytes += fnrow*numberOfNonzerosPerRow*((double) sizeof(double));       // matrixValues[1..nrows]
     fnbytes += fnrow*numberOfNonzerosPerRow*((double) sizeof(global_int_t)); // mtxIndG[1..nrows]
+#else
+    // OptimizeProblem releases the row-wise arrays once the CSR handles exist; they are counted in OptimizeProblemMemoryUse
+    fnbytes += fnrow*((double) sizeof(double*));      // matrixDiagonal
+#endif
     fnbytes += fnrow*((double) 3*sizeof(double)); // x, b, xexact
 
     // Model for CGData.hpp
@@ -183,8 +412,7 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     std::vector<double> fnbytesPerLevel(numberOfMgLevels); // Count byte usage per level (level 0 is main CG level)
     fnbytesPerLevel[0] = fnbytes;
 
-    // Benchmarker-provided model for OptimizeProblem.cpp
-    double fnbytes_OptimizedProblem = OptimizeProblemMemoryUse(A);
+    // Benchmarker-provided model for OptimizeProblem.cpp (summed over all ranks above)
     fnbytes += fnbytes_OptimizedProblem;
 
     Af = A.Ac;
@@ -199,6 +427,7 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
         fnbytes_Af += ((double) (sizeof(Geometry)+sizeof(SparseMatrix)+3*sizeof(Vector)+sizeof(MGData))); // Account for structs geomc, Ac, rc, xc, Axf - (minor)
 
         // Model for GenerateProblem.cpp (called within GenerateCoarseProblem.cpp)
+#ifdef HPCG_LOCAL_LONG_LONG
         fnbytes_Af += fnrow_Af*sizeof(char);      // array nonzerosInRow
         fnbytes_Af += fnrow_Af*((double) sizeof(global_int_t*)); // mtxIndG
         fnbytes_Af += fnrow_Af*((double) sizeof(local_int_t*));  // mtxIndL
@@ -207,6 +436,9 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
         fnbytes_Af += fnrow_Af*numberOfNonzerosPerRow*((double) sizeof(local_int_t));  // mtxIndL[1..nrows]
         fnbytes_Af += fnrow_Af*numberOfNonzerosPerRow*((double) sizeof(double));       // matrixValues[1..nrows]
         fnbytes_Af += fnrow_Af*numberOfNonzerosPerRow*((double) sizeof(global_int_t)); // mtxIndG[1..nrows]
+#else
+        fnbytes_Af += fnrow_Af*((double) sizeof(double*));      // matrixDiagonal
+#endif
 
         // Model for SetupHalo_ref.cpp
 #ifndef HPCG_NO_MPI
@@ -264,6 +496,22 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
 
     doc.add("Setup Information","");
     doc.get("Setup Information")->add("Setup Time",times[9]);
+    doc.get("Setup Information")->add("Checkpoint","");
+    doc.get("Setup Information")->get("Checkpoint")->add("Status",checkpointStatus[checkpointStats.status]);
+    if (checkpointStats.status == HPCG_CHECKPOINT_WRITTEN || checkpointStats.status == HPCG_CHECKPOINT_LOADED) {
+      doc.get("Setup Information")->get("Checkpoint")->add("Snapshot size (Gbytes)",checkpointBytes/1000000000.0);
+      doc.get("Setup Information")->get("Checkpoint")->add(checkpointStats.status == HPCG_CHECKPOINT_LOADED ? "Load time (sec)" : "Write time (sec)",checkpointTime);
+    }
+    doc.get("Setup Information")->add("Reference Cache","");
+    doc.get("Setup Information")->get("Reference Cache")->add("Status",referenceCacheStatusName[referenceCacheStatus]);
+    doc.get("Setup Information")->get("Reference Cache")->add("Reference results",
+        referenceCacheStatus == HPCG_REFERENCE_CACHE_USED ? "cached from an earlier run" : "computed in this run");
+    doc.get("Setup Information")->add("Problem Check","");
+    doc.get("Setup Information")->get("Problem Check")->add("Mode",checkProblemMode[checkProblemStats.mode]);
+    doc.get("Setup Information")->get("Problem Check")->add("Check time (sec)",checkProblemTimes[0]);
+    if (checkProblemStats.mode == HPCG_CHECK_OPTIMIZED)
+      doc.get("Setup Information")->get("Problem Check")->add("Optimized check time (sec)",checkProblemTimes[1]);
+    AddOptimizeProblemStats(doc.get("Setup Information"), optimizeStats);
 
     doc.add("Linear System Information","");
     doc.get("Linear System Information")->add("Number of Equations",A.totalNumberOfRows);
@@ -281,6 +529,132 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
         doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Postsmoother Steps",Af->mgData->numberOfPostsmootherSteps);
     	Af = Af->Ac;
     }
+    doc.get("Multigrid Information")->add("Level Timings","");
+    for (int i=0; i<numberOfMgLevels-1; ++i) {
+        doc.get("Multigrid Information")->get("Level Timings")->add("Grid Level",i);
+        doc.get("Multigrid Information")->get("Level Timings")->add("Fused residual and restriction",UseCompressedMatrix() ? 1 : 0);
+        doc.get("Multigrid Information")->get("Level Timings")->add("Task-based halo overlap",(UseMGTasks() && UseCompressedMatrix()) ? 1 : 0);
+        doc.get("Multigrid Information")->get("Level Timings")->add("V-cycle from this level (sec per cycle)",mgTimes[3*i+2]);
+        doc.get("Multigrid Information")->get("Level Timings")->add("Pre-smoothing and restriction (sec per cycle)",mgTimes[3*i]);
+        doc.get("Multigrid Information")->get("Level Timings")->add("Prolongation and post-smoothing (sec per cycle)",mgTimes[3*i+1]);
+        doc.get("Multigrid Information")->get("Level Timings")->add("Residual rows evaluated per cycle",(long long) mgRows[2*i]);
+        doc.get("Multigrid Information")->get("Level Timings")->add("Residual traffic avoided per cycle (Gbytes)",mgRows[2*i+1]/1000000000.0);
+    }
+
+    const char * haloModeNames[3] = { "double", "float", "16-bit blocks" };
+    doc.add("Halo Precision","");
+    for (int i=0; i<numberOfMgLevels; ++i) {
+      doc.get("Halo Precision")->add("Grid Level",i);
+      doc.get("Halo Precision")->add("Encoding inside MG",haloModeNames[haloModes[i]]);
+      doc.get("Halo Precision")->add("Exchanges per rank",(long long) (haloTraffic[2*i]/A.geom->size));
+      doc.get("Halo Precision")->add("Bytes on the wire per rank (Mbytes)",haloTraffic[2*i+1]/A.geom->size/1000000.0);
+    }
+
+    doc.add("Halo Backend","");
+#ifndef HPCG_NO_MPI
+    if (A.neighborHalo != NULL) {
+      doc.get("Halo Backend")->add("Transport","MPI_Ineighbor_alltoallv on a distributed graph communicator");
+      doc.get("Halo Backend")->add("Persistent requests",A.neighborHalo->persistent != MPI_REQUEST_NULL ? 1 : 0);
+    } else if (A.rmaHalo != NULL) {
+      doc.get("Halo Backend")->add("Transport","MPI_Put into ghost windows with post-start-complete-wait");
+      doc.get("Halo Backend")->add("Persistent requests",0);
+      doc.get("Halo Backend")->add("Exchanges through windows on rank 0",windowExchanges);
+    } else {
+      doc.get("Halo Backend")->add("Transport","MPI_Alltoallv on MPI_COMM_WORLD");
+      doc.get("Halo Backend")->add("Persistent requests",0);
+    }
+    doc.get("Halo Backend")->add("Neighbors of rank 0",A.numberOfSendNeighbors);
+#else
+    doc.get("Halo Backend")->add("Transport","none");
+#endif
+
+#ifndef HPCG_NO_MPI
+    if (A.haloDatatypes != NULL) {
+      const char * packNames[3] = { "index gather", "MPI datatypes", "strided kernels" };
+      doc.add("Halo Packing","");
+      int level = 0;
+      for (const SparseMatrix * Ai = &A; Ai != 0; Ai = Ai->Ac, ++level) {
+        doc.get("Halo Packing")->add("Grid Level",level);
+        const HaloDatatypes * hd = Ai->haloDatatypes;
+        doc.get("Halo Packing")->add("Path",packNames[hd != NULL ? hd->mode : HPCG_HALO_PACK_GATHER]);
+        if (hd == NULL) continue;
+        doc.get("Halo Packing")->add("Index gather (usec)",1.0e6*hd->packTime[0]);
+        doc.get("Halo Packing")->add("Strided kernels (usec)",1.0e6*hd->packTime[1]);
+        doc.get("Halo Packing")->add("MPI_Pack of the datatypes (usec)",1.0e6*hd->packTime[2]);
+      }
+    }
+#endif
+
+    if (haloBenchLevels > 0) {
+      doc.add("Halo Transport Benchmark","");
+      for (int i=0; i<haloBenchLevels; ++i) {
+        const double * t = &haloBenchTimes[HPCG_HALO_TRANSPORTS*i];
+        doc.get("Halo Transport Benchmark")->add("Grid Level",i);
+        doc.get("Halo Transport Benchmark")->add("Neighbors of rank 0",haloLevels[i].neighbors);
+        doc.get("Halo Transport Benchmark")->add("Kbytes sent per exchange on rank 0",haloLevels[i].bytes/1000.0);
+        doc.get("Halo Transport Benchmark")->add("MPI_Alltoallv (usec)",1.0e6*t[HPCG_HALO_ALLTOALLV]);
+        doc.get("Halo Transport Benchmark")->add("MPI_Isend and MPI_Irecv (usec)",1.0e6*t[HPCG_HALO_ISEND]);
+        doc.get("Halo Transport Benchmark")->add("MPI_Ineighbor_alltoallv (usec)",1.0e6*t[HPCG_HALO_NEIGHBOR]);
+        if (t[HPCG_HALO_PUT] > 0.0) doc.get("Halo Transport Benchmark")->add("MPI_Put (usec)",1.0e6*t[HPCG_HALO_PUT]);
+      }
+    }
+
+    doc.add("Communication Thread","");
+    doc.get("Communication Thread")->add("Enabled",commStats.enabled);
+    doc.get("Communication Thread")->add("MPI thread support level",commStats.threadLevel);
+    doc.get("Communication Thread")->add("Non-blocking steps per rank",(long long) (commTimes[0]/A.geom->size));
+    doc.get("Communication Thread")->add("Communication time per rank (sec)",commTimes[1]/A.geom->size);
+    doc.get("Communication Thread")->add("Time waited per rank (sec)",commTimes[2]/A.geom->size);
+    doc.get("Communication Thread")->add("Overlap achieved",(commTimes[1] > 0.0 && commTimes[2] < commTimes[1]) ? 1.0 - commTimes[2]/commTimes[1] : 0.0);
+
+    const DeepHalo * deepHalo = ((const struct optData *) A.optimizationData)->deepHalo;
+    if (deepHalo != NULL) {
+      doc.add("Deep Halo","");
+      doc.get("Deep Halo")->add("Ghost width",deepHalo->width);
+      doc.get("Deep Halo")->add("Extended subdomain points on rank 0",(long long) deepHalo->extendedLength);
+      doc.get("Deep Halo")->add("Ghost points on rank 0",(long long) (deepHalo->extendedLength - deepHalo->localNumberOfRows));
+      doc.get("Deep Halo")->add("Messages per exchange on rank 0",deepHalo->numberOfNeighbors);
+      doc.get("Deep Halo")->add("Kbytes sent per exchange on rank 0",sizeof(double)*deepHalo->totalToBeSent/1000.0);
+#ifndef HPCG_NO_MPI
+      doc.get("Deep Halo")->add("Messages for as many single layer exchanges on rank 0",deepHalo->width*A.numberOfSendNeighbors);
+      doc.get("Deep Halo")->add("Kbytes sent by as many single layer exchanges on rank 0",deepHalo->width*sizeof(double)*A.totalToBeSent/1000.0);
+#endif
+    }
+
+    CACGComparison cacg;
+    GetCACGComparison(cacg);
+    if (cacg.s > 0) {
+      const char * solvers[2] = { "CG", "CA-CG" };
+      doc.add("s-step CG Comparison","");
+      doc.get("s-step CG Comparison")->add("Steps per outer iteration",cacg.s);
+      doc.get("s-step CG Comparison")->add("Basis","Newton, Leja ordered Chebyshev shifts");
+      doc.get("s-step CG Comparison")->add("MG preconditioned",cacg.preconditioned);
+      doc.get("s-step CG Comparison")->add("Matrix powers ghost width",cacg.matrixPowers);
+      doc.get("s-step CG Comparison")->add("Largest eigenvalue estimate",cacg.lambdaMax);
+      doc.get("s-step CG Comparison")->add("Iterations",cacg.iterations);
+      for (int i=0; i<2; ++i) {
+        doc.get("s-step CG Comparison")->add(solvers[i],"");
+        doc.get("s-step CG Comparison")->get(solvers[i])->add("Time (sec)",cacg.time[i]);
+        doc.get("s-step CG Comparison")->get(solvers[i])->add("Global reductions per iteration",cacg.reductions[i]);
+        doc.get("s-step CG Comparison")->get(solvers[i])->add("Halo exchanges per iteration and rank",cacg.haloExchanges[i]);
+        doc.get("s-step CG Comparison")->get(solvers[i])->add("Halo volume per iteration and rank (Kbytes)",cacg.haloBytes[i]/1000.0);
+        doc.get("s-step CG Comparison")->get(solvers[i])->add("Final scaled residual",cacg.scaledResidual[i]);
+      }
+    }
+
+    doc.add("Thread Team","");
+    doc.get("Thread Team")->add("Enabled",UseThreadTeam() ? 1 : 0);
+    doc.get("Thread Team")->add("Threads",ThreadTeamSize());
+    if (teamNumberOfLevels > 0) {
+      doc.get("Thread Team")->add("Empty dispatch (usec)",teamTimes[0]*1000000.0);
+      doc.get("Thread Team")->add("Dispatch Timings","");
+      for (int i=0; i<teamNumberOfLevels; ++i) {
+        doc.get("Thread Team")->get("Dispatch Timings")->add("Grid Level",i);
+        doc.get("Thread Team")->get("Dispatch Timings")->add("Local rows on rank 0",(long long) teamLevels[i].rows);
+        doc.get("Thread Team")->get("Dispatch Timings")->add("Team vector update (usec)",teamTimes[2*i+1]*1000000.0);
+        doc.get("Thread Team")->get("Dispatch Timings")->add("OpenMP parallel region vector update (usec)",teamTimes[2*i+2]*1000000.0);
+      }
+    }
 
     doc.add("########## Memory Use Summary  ##########","");
 
@@ -297,6 +671,34 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
         doc.get("Memory Use Information")->get("Coarse Grids")->add("Memory used",fnbytesPerLevel[i]/1000000000.0);
     }
 
+    doc.get("Memory Use Information")->add("Huge Pages","");
+    doc.get("Memory Use Information")->get("Huge Pages")->add("Mode",hugePageStats.mode);
+    doc.get("Memory Use Information")->get("Huge Pages")->add("Memory mapped by huge page allocator (Gbytes)",hugePageBytes[0]/1000000000.0);
+    doc.get("Memory Use Information")->get("Huge Pages")->add("Memory backed by huge pages (Gbytes)",hugePageBytes[1]/1000000000.0);
+    doc.get("Memory Use Information")->get("Huge Pages")->add("Page size fallbacks",(long long) hugePageBytes[2]);
+
+    doc.get("Memory Use Information")->add("Tracked Allocations","");
+    for (int i=0; i<HPCG_MEM_COUNT; ++i) {
+      doc.get("Memory Use Information")->get("Tracked Allocations")->add(TrackedMemoryName(i),"");
+      doc.get("Memory Use Information")->get("Tracked Allocations")->get(TrackedMemoryName(i))->add("Current (Gbytes)",trackedCurrent[i]/1000000000.0);
+      doc.get("Memory Use Information")->get("Tracked Allocations")->get(TrackedMemoryName(i))->add("Peak (Gbytes)",trackedPeak[i]/1000000000.0);
+    }
+    doc.get("Memory Use Information")->get("Tracked Allocations")->add("Max per-rank peak (Gbytes)",trackedTotalPeakMax/1000000000.0);
+    doc.get("Memory Use Information")->add("Peak RSS per rank (Gbytes)","");
+    doc.get("Memory Use Information")->get("Peak RSS per rank (Gbytes)")->add("Min",peakRSSmin/1000000000.0);
+    doc.get("Memory Use Information")->get("Peak RSS per rank (Gbytes)")->add("Avg",peakRSSavg/1000000000.0);
+    doc.get("Memory Use Information")->get("Peak RSS per rank (Gbytes)")->add("Max",peakRSSmax/1000000000.0);
+
+    doc.add("Compressed Index Format","");
+    doc.get("Compressed Index Format")->add("Enabled",UseCompressedMatrix() ? 1 : 0);
+    if (indexStats[0] > 0.0) {
+      doc.get("Compressed Index Format")->add("CSR index bytes per nonzero",indexStats[1]/indexStats[0]);
+      doc.get("Compressed Index Format")->add("Compressed index bytes per nonzero",indexStats[2]/indexStats[0]);
+      doc.get("Compressed Index Format")->add("Total bytes per nonzero (CSR)",indexStats[1]/indexStats[0] + sizeof(double));
+      doc.get("Compressed Index Format")->add("Total bytes per nonzero (compressed)",indexStats[2]/indexStats[0] + sizeof(double));
+      doc.get("Compressed Index Format")->add("Exception rows",(long long) indexStats[3]);
+    }
+
     doc.add("########## V&V Testing Summary  ##########","");
     doc.add("Spectral Convergence Tests","");
     if (testcg_data.count_fail==0)
@@ -397,6 +799,9 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
         doc.get(" Final Summary ")->add("HPCG result is VALID with a GFLOP/s rating of", totalGflops);
         doc.get(" Final Summary ")->add("    HPCG 2.4 Rating (for historical value) is", totalGflops24);
         printf("HPCG result is VALID with a GFLOP/s rating of %lf\n",totalGflops);
+      if (referenceCacheStatus == HPCG_REFERENCE_CACHE_USED) {
+        doc.get(" Final Summary ")->add("Reference tolerance and SpMV+MG time taken from a cache","The reference phases did not run");
+      }
       if (!A.isDotProductOptimized) {
         doc.get(" Final Summary ")->add("Reference version of ComputeDotProduct used","Performance results are most likely suboptimal");
       }
@@ -438,3 +843,124 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
   }
   return;
 }
+
+/*!
+ Creates a YAML file with the rates of a run on an imported matrix (see ImportProblem). The
+ operation counts are those of ReportResults for a single level, whose preconditioner is one
+ symmetric Gauss-Seidel sweep, and the iteration counts are the ones actually performed. The
+ run has no reference phase and no validation, so the result is a throughput figure only.
+
+  @param[in] A              The imported matrix
+  @param[in] matrixFile     Path of the matrix file
+  @param[in] format         The HPCG_IMPORT_* format of the file
+  @param[in] numberOfCgSets Number of timed CG runs performed
+  @param[in] totalNiters    Iterations of all timed CG runs
+  @param[in] scaledResidual Scaled residual at the end of the last timed run
+  @param[in] errors         Number of timed CG runs that returned an error
+  @param[in] times          Vector of cumulative timings of the timed runs, times[7] and times[9] hold the optimization and setup times
+  @param[in] params         The parameters of the run
+
+  @see ReportResults
+*/
+void ReportImportedResults(const SparseMatrix & A, const char * matrixFile, int format, int numberOfCgSets, int totalNiters,
+    double scaledResidual, int errors, double times[], const HPCG_Params & params) {
+
+  // Largest per-rank peak of the tracked allocations and of the resident set
+  double trackedCurrent[HPCG_MEM_COUNT], trackedPeak[HPCG_MEM_COUNT], trackedTotalPeak = 0.0;
+  GetTrackedMemory(trackedCurrent, trackedPeak, trackedTotalPeak);
+  double peaks[2] = { trackedTotalPeak, GetPeakRSS() };
+#ifndef HPCG_NO_MPI
+  double localPeaks[2] = { peaks[0], peaks[1] };
+  MPI_Allreduce(localPeaks, peaks, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  OptimizeProblemStats optimizeStats;
+  GatherOptimizeProblemStats(optimizeStats);
+
+  if (A.geom->rank==0) {
+    double fNumberOfCgSets = numberOfCgSets;
+    double fniters = totalNiters;
+    double fnrow = A.totalNumberOfRows;
+    double fnnz = A.totalNumberOfNonzeros;
+
+    // Op counts come from implementation of CG in CG.cpp (include 1 extra for the CG preamble ops)
+    double fnops_ddot = (3.0*fniters+fNumberOfCgSets)*2.0*fnrow; // 3 ddots with nrow adds and nrow mults
+    double fnops_waxpby = (3.0*fniters+fNumberOfCgSets)*2.0*fnrow; // 3 WAXPBYs with nrow adds and nrow mults
+    double fnops_sparsemv = (fniters+fNumberOfCgSets)*2.0*fnnz; // 1 SpMV with nnz adds and nnz mults
+    double fnops_precond = fniters*4.0*fnnz; // One symmetric GS sweep
+    double fnops = fnops_ddot+fnops_waxpby+fnops_sparsemv+fnops_precond;
+
+    char buf[1024];
+    sprintf(buf, "import-%dp-%dt", A.geom->size, A.geom->numThreads);
+    std::string fileName(buf);
+    OutputFile doc(fileName, "V3.1", "", params.yamlFileName);
+
+    doc.add("Machine Summary","");
+    doc.get("Machine Summary")->add("Distributed Processes",A.geom->size);
+    doc.get("Machine Summary")->add("Threads per processes",A.geom->numThreads);
+
+    const char * formatNames[3] = { "binary coordinate (HPCGCOO1)", "binary CSR (HPCGCSR1)", "Matrix Market coordinate" };
+    doc.add("Imported Problem","");
+    doc.get("Imported Problem")->add("Matrix file",matrixFile);
+    doc.get("Imported Problem")->add("Format",formatNames[format]);
+    doc.get("Imported Problem")->add("Row distribution","contiguous blocks of rows");
+    doc.get("Imported Problem")->add("Preconditioner","one symmetric Gauss-Seidel sweep on the rows of each process");
+
+    doc.add("Setup Information","");
+    doc.get("Setup Information")->add("Setup Time",times[9]);
+    AddOptimizeProblemStats(doc.get("Setup Information"), optimizeStats);
+
+    doc.add("Linear System Information","");
+    doc.get("Linear System Information")->add("Number of Equations",A.totalNumberOfRows);
+    doc.get("Linear System Information")->add("Number of Nonzero Terms",A.totalNumberOfNonzeros);
+
+    doc.add("Memory Use Information","");
+    doc.get("Memory Use Information")->add("Max per-rank peak of tracked allocations (Gbytes)",peaks[0]/1000000000.0);
+    doc.get("Memory Use Information")->add("Max per-rank peak RSS (Gbytes)",peaks[1]/1000000000.0);
+
+    doc.add("Iteration Count Information","");
+    doc.get("Iteration Count Information")->add("Number of CG sets",numberOfCgSets);
+    doc.get("Iteration Count Information")->add("Total number of iterations",totalNiters);
+    doc.get("Iteration Count Information")->add("Scaled residual of the last set",scaledResidual);
+
+    doc.add("Benchmark Time Summary","");
+    doc.get("Benchmark Time Summary")->add("Optimization phase",times[7]);
+    doc.get("Benchmark Time Summary")->add("DDOT",times[1]);
+    doc.get("Benchmark Time Summary")->add("WAXPBY",times[2]);
+    doc.get("Benchmark Time Summary")->add("SpMV",times[3]);
+    doc.get("Benchmark Time Summary")->add("MG",times[5]);
+    doc.get("Benchmark Time Summary")->add("ALL_reduce",times[4]);
+    doc.get("Benchmark Time Summary")->add("Total",times[0]);
+
+    doc.add("Floating Point Operations Summary","");
+    doc.get("Floating Point Operations Summary")->add("Raw DDOT",fnops_ddot);
+    doc.get("Floating Point Operations Summary")->add("Raw WAXPBY",fnops_waxpby);
+    doc.get("Floating Point Operations Summary")->add("Raw SpMV",fnops_sparsemv);
+    doc.get("Floating Point Operations Summary")->add("Raw MG",fnops_precond);
+    doc.get("Floating Point Operations Summary")->add("Total",fnops);
+
+    double totalGflops = fnops/times[0]/1.0E9;
+    doc.add("GFLOP/s Summary","");
+    doc.get("GFLOP/s Summary")->add("Raw DDOT",fnops_ddot/times[1]/1.0E9);
+    doc.get("GFLOP/s Summary")->add("Raw WAXPBY",fnops_waxpby/times[2]/1.0E9);
+    doc.get("GFLOP/s Summary")->add("Raw SpMV",fnops_sparsemv/(times[3])/1.0E9);
+    doc.get("GFLOP/s Summary")->add("Raw MG",fnops_precond/(times[5])/1.0E9);
+    doc.get("GFLOP/s Summary")->add("Raw Total",totalGflops);
+    doc.get("GFLOP/s Summary")->add("Total with setup and optimization phase overhead",fnops/(times[0]+times[7]+times[9])/1.0E9);
+
+    doc.add(" Final Summary ","");
+    if (errors == 0) {
+      doc.get(" Final Summary ")->add("Imported matrix run with a GFLOP/s rating of",totalGflops);
+      printf("Imported matrix run with a GFLOP/s rating of %lf\n",totalGflops);
+    } else {
+      doc.get(" Final Summary ")->add("Imported matrix run","FAILED.");
+      doc.get(" Final Summary ")->add("Timed CG runs with errors",errors);
+    }
+    doc.get(" Final Summary ")->add("Not an HPCG result","The imported matrix is not validated and the run may NOT be submitted.");
+
+    std::string yaml = doc.generate();
+#ifdef HPCG_DEBUG
+    HPCG_fout << yaml;
+#endif
+  }
+  return;
+}
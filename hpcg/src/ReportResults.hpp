@@ -34,5 +34,7 @@
 
 void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgSets, int refMaxIters, int optMaxIters, double times[],
     const TestCGData & testcg_data, const TestSymmetryData & testsymmetry_data, const TestNormsData & testnorms_data, int global_failure, bool quickPath, const HPCG_Params& params);
+void ReportImportedResults(const SparseMatrix & A, const char * matrixFile, int format, int numberOfCgSets, int totalNiters,
+    double scaledResidual, int errors, double times[], const HPCG_Params & params);
 
 #endif // REPORTRESULTS_HPP
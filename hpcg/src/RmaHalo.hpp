@@ -0,0 +1,88 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file RmaHalo.hpp
+
+ HPCG halo exchange through MPI_Put into the ghost regions of the neighbors
+ */
+
+#ifndef RMAHALO_HPP
+#define RMAHALO_HPP
+
+#define HPCG_RMA_MAX_WINDOWS 4 //!< vectors of one level that can expose their ghost region
+
+#ifndef HPCG_NO_MPI
+#include <mpi.h>
+#include "Geometry.hpp"
+#include "TrackedAllocator.hpp"
+
+/*!
+  One-sided halo state of one level: the neighbor group used for the post-start-complete-wait
+  synchronization, where the values of this rank land in the ghost region of each neighbor,
+  and one window per registered vector exposing the ghost part of that vector.
+*/
+struct RmaHalo_STRUCT {
+  MPI_Group group;              //!< the neighbors of the level, both as origins and as targets
+  local_int_t * targetOffset;   //!< per neighbor, offset of the values sent by this rank in the ghost region of the neighbor
+  int numberOfWindows;          //!< vectors registered with RegisterHaloWindow
+  double * ghosts[HPCG_RMA_MAX_WINDOWS]; //!< ghost part of each registered vector, x.values + localNumberOfRows
+  MPI_Win windows[HPCG_RMA_MAX_WINDOWS]; //!< window over that ghost part
+  long long exchanges;          //!< exchanges that went through a window
+};
+typedef struct RmaHalo_STRUCT RmaHalo;
+
+/*!
+  Returns the window exposing the ghost region of a vector of this level.
+
+  @param[in] rh    The one-sided halo of the level
+  @param[in] ghost The ghost part of the vector, x.values + localNumberOfRows
+
+  @return The index of the window or -1 if the vector was not registered
+*/
+inline int FindHaloWindow(const RmaHalo & rh, const double * ghost) {
+  for (int i = 0; i < rh.numberOfWindows; i++)
+    if (rh.ghosts[i] == ghost) return i;
+  return -1;
+}
+
+/*!
+  Frees the windows, the group and the offsets of a one-sided halo. Collective, since the
+  windows are freed on MPI_COMM_WORLD.
+
+  @param[inout] rh The one-sided halo, may be NULL
+*/
+inline void DeleteRmaHalo(RmaHalo * rh) {
+  if (rh == NULL) return;
+  for (int i = 0; i < rh->numberOfWindows; i++) MPI_Win_free(&rh->windows[i]);
+  if (rh->group != MPI_GROUP_NULL) MPI_Group_free(&rh->group);
+  TrackedFree(rh->targetOffset);
+  delete rh;
+}
+#endif
+
+#endif // RMAHALO_HPP
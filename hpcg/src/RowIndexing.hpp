@@ -0,0 +1,108 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file RowIndexing.hpp
+
+ HPCG closed-form mapping between local and global row numbers of the structured decomposition
+ */
+
+#ifndef ROWINDEXING_HPP
+#define ROWINDEXING_HPP
+
+#include "Geometry.hpp"
+#include "SparseMatrix.hpp"
+
+/*!
+  Global row of a local row in the natural ordering of the generated problem: local rows run
+  x fastest over the nx by ny by nz box of this rank, whose first point is (gix0, giy0, giz0).
+
+  @param[in] geom     The geometry of the level
+  @param[in] localRow Local row, 0 to nx*ny*nz-1
+
+  @return The global row of the same grid point
+*/
+inline global_int_t LocalToGlobalRow(const Geometry & geom, local_int_t localRow) {
+  const local_int_t iz = localRow/(geom.nx*geom.ny);
+  const local_int_t iy = localRow/geom.nx%geom.ny;
+  const local_int_t ix = localRow%geom.nx;
+  return ((geom.giz0+iz)*geom.gny + geom.giy0+iy)*geom.gnx + geom.gix0+ix;
+}
+
+/*!
+  Local row of a global row owned by this rank, in the natural ordering of the generated problem.
+
+  @param[in] geom      The geometry of the level
+  @param[in] globalRow Global row of a grid point inside the box of this rank
+
+  @return The local row of the same grid point
+*/
+inline local_int_t GlobalToLocalRow(const Geometry & geom, global_int_t globalRow) {
+  const global_int_t giz = globalRow/(geom.gnx*geom.gny);
+  const global_int_t giy = globalRow/geom.gnx%geom.gny;
+  const global_int_t gix = globalRow%geom.gnx;
+  return (local_int_t) (((giz-geom.giz0)*geom.ny + (giy-geom.giy0))*geom.nx + (gix-geom.gix0));
+}
+
+/*!
+  Global row of a local row of the matrix. The optimized setup keeps no mapping arrays: the row
+  follows from the geometry, through the local ordering once OptimizeProblem has renumbered the
+  rows. The reference setup keeps its localToGlobalMap.
+
+  @param[in] A        The matrix
+  @param[in] localRow Local row of A
+
+  @return The global row
+*/
+inline global_int_t GlobalRowOfLocalRow(const SparseMatrix & A, local_int_t localRow) {
+#ifdef HPCG_LOCAL_LONG_LONG
+  return A.localToGlobalMap[localRow];
+#else
+  const struct optData * optData = (const struct optData *) A.optimizationData;
+  if (optData != NULL && optData->localOrder != NULL) localRow = optData->localOrder[localRow];
+  return LocalToGlobalRow(*A.geom, localRow);
+#endif
+}
+
+/*!
+  Local row of a global row owned by this rank, for the matrix as generated, before
+  OptimizeProblem may renumber the rows.
+
+  @param[in] A         The matrix
+  @param[in] globalRow Global row owned by this rank
+
+  @return The local row
+*/
+inline local_int_t LocalRowOfGlobalRow(const SparseMatrix & A, global_int_t globalRow) {
+#ifdef HPCG_LOCAL_LONG_LONG
+  return A.globalToLocalMap.find(globalRow)->second;
+#else
+  return GlobalToLocalRow(*A.geom, globalRow);
+#endif
+}
+
+#endif // ROWINDEXING_HPP
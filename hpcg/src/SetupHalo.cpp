@@ -41,8 +41,18 @@
 #include <omp.h>
 #endif
 
+#include <vector>
+
 #include "SetupHalo.hpp"
 #include "SetupHalo_ref.hpp"
+#include "DeepHalo.hpp"
+#include "HaloPrecision.hpp"
+#include "NeighborHalo.hpp"
+#include "RmaHalo.hpp"
+#include "HaloDatatypes.hpp"
+#include "ExchangeHalo.hpp"
+#include "RowIndexing.hpp"
+#include "mytimer.hpp"
 
 /*!
   Prepares system matrix data structure and creates data necessary necessary
@@ -55,6 +65,12 @@
 
 void SetupHalo(SparseMatrix & A)
 {
+#ifndef HPCG_NO_MPI
+    A.haloPrecision = NULL;
+    A.neighborHalo = NULL;
+    A.rmaHalo = NULL;
+    A.haloDatatypes = NULL;
+#endif
 #if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
     if( A.geom->size > 1 )
     {
@@ -66,6 +82,7 @@ void SetupHalo(SparseMatrix & A)
 
         int nproc = A.nproc;
         nproc = (nproc > A.numOfBoundaryRows) ? A.numOfBoundaryRows : nproc;
+        if ( nproc < 1 ) nproc = 1; // an imported matrix may leave a rank without boundary rows
 
         local_int_t totalToBeSent = 0, totalToBeReceived = 0, cnt = 0;
         local_int_t number_of_neighbors = A.numberOfSendNeighbors;
@@ -80,11 +97,11 @@ void SetupHalo(SparseMatrix & A)
         std::map< global_int_t, local_int_t > externalToLocalMap;
         local_int_t receiveEntryCount = 0, sendEntryCount = 0;
 
-        map_send      = (global_int_t*) MKL_malloc( sizeof(global_int_t)*A.numOfBoundaryRows*number_of_neighbors, 512 );
-        map_neib_s    = (local_int_t *) MKL_malloc( sizeof(local_int_t )*A.geom->size                           , 512 );
-        neighbors     = (int*         ) MKL_malloc( sizeof(int         )*number_of_neighbors                    , 512 );
-        receiveLength = (local_int_t *) MKL_malloc( sizeof(local_int_t )*number_of_neighbors                    , 512 );
-        sendLength    = (local_int_t *) MKL_malloc( sizeof(local_int_t )*number_of_neighbors                    , 512 );
+        map_send      = (global_int_t*) TrackedMalloc(sizeof(global_int_t)*A.numOfBoundaryRows*number_of_neighbors, HPCG_MEM_HALO);
+        map_neib_s    = (local_int_t *) TrackedMalloc(sizeof(local_int_t )*A.geom->size, HPCG_MEM_HALO);
+        neighbors     = (int*         ) TrackedMalloc(sizeof(int         )*number_of_neighbors, HPCG_MEM_HALO);
+        receiveLength = (local_int_t *) TrackedMalloc(sizeof(local_int_t )*number_of_neighbors, HPCG_MEM_HALO);
+        sendLength    = (local_int_t *) TrackedMalloc(sizeof(local_int_t )*number_of_neighbors, HPCG_MEM_HALO);
 
         if ( map_neib_s == NULL || map_send == NULL || neighbors == NULL || receiveLength == NULL || sendLength == NULL ) return;
 
@@ -118,21 +135,21 @@ void SetupHalo(SparseMatrix & A)
             {
                 if( mtxIndL[i][j] < 0 )
                 {
-                    global_int_t curIndex = mtxIndG[i][j];
-                    int rankIdOfColumnEntry = ComputeRankOfMatrixRow(*(A.geom), curIndex);
+                    // GenerateProblem stored the owner of every off-process column as -1-rank
+                    int rankIdOfColumnEntry = -1-mtxIndL[i][j];
                     local_int_t jj = map_neib_s[rankIdOfColumnEntry];
 
                     if ( map_send[jj*A.numOfBoundaryRows + row] < 0 )
                     {
-                        map_send[jj*A.numOfBoundaryRows + row] = A.localToGlobalMap[i];
+                        map_send[jj*A.numOfBoundaryRows + row] = LocalToGlobalRow(*A.geom, i);
                         totalToBeSent++;
                     }
                 }
             }
         }
-        sendBuffer       = (double      *) MKL_malloc(sizeof(double      )*totalToBeSent, 512);
-        elementsToSend   = (local_int_t *) MKL_malloc(sizeof(local_int_t )*totalToBeSent, 512);
-        elementsToSend_G = (global_int_t*) MKL_malloc(sizeof(global_int_t)*totalToBeSent, 512);
+        sendBuffer       = (double      *) TrackedMalloc(sizeof(double      )*totalToBeSent, HPCG_MEM_HALO);
+        elementsToSend   = (local_int_t *) TrackedMalloc(sizeof(local_int_t )*totalToBeSent, HPCG_MEM_HALO);
+        elementsToSend_G = (global_int_t*) TrackedMalloc(sizeof(global_int_t)*totalToBeSent, HPCG_MEM_HALO);
 
         if ( sendBuffer == NULL || elementsToSend == NULL || elementsToSend_G == NULL ) return;
 
@@ -150,8 +167,8 @@ void SetupHalo(SparseMatrix & A)
             }
         }
 
-        all_send = (local_int_t *) MKL_malloc(sizeof(local_int_t )*A.geom->size, 512);
-        all_recv = (local_int_t *) MKL_malloc(sizeof(local_int_t )*A.geom->size, 512);
+        all_send = (local_int_t *) TrackedMalloc(sizeof(local_int_t )*A.geom->size, HPCG_MEM_HALO);
+        all_recv = (local_int_t *) TrackedMalloc(sizeof(local_int_t )*A.geom->size, HPCG_MEM_HALO);
 
         if ( all_send == NULL || all_recv == NULL ) return;
 
@@ -167,13 +184,13 @@ void SetupHalo(SparseMatrix & A)
             receiveLength[ i ] = all_recv[ neighbors[i] ];
             totalToBeRecv += receiveLength[ i ];
         }
-        elementsToRecv_G = (global_int_t*) MKL_malloc(sizeof(global_int_t)*totalToBeRecv, 512);
+        elementsToRecv_G = (global_int_t*) TrackedMalloc(sizeof(global_int_t)*totalToBeRecv, HPCG_MEM_HALO);
 
         if ( elementsToRecv_G == NULL ) return;
 
         int MPI_MY_TAG = 98;
 
-        MPI_Request *request = (MPI_Request*) MKL_malloc(sizeof(MPI_Request)*number_of_neighbors, 512);
+        MPI_Request *request = (MPI_Request*) TrackedMalloc(sizeof(MPI_Request)*number_of_neighbors, HPCG_MEM_HALO);
 
         if (request == NULL ) return;
 
@@ -201,7 +218,7 @@ void SetupHalo(SparseMatrix & A)
 #endif
         for( local_int_t i = 0; i < totalToBeSent; i++ )
         {
-            elementsToSend[ i ] = A.globalToLocalMap[ elementsToSend_G[ i ] ];
+            elementsToSend[ i ] = GlobalToLocalRow(*A.geom, elementsToSend_G[ i ]);
         }
 
         receiveEntryCount = 0;
@@ -228,10 +245,10 @@ void SetupHalo(SparseMatrix & A)
             }
         }
 
-        local_int_t *sdispls = (local_int_t*) MKL_malloc( sizeof(local_int_t)*A.geom->size, 128 );
-        local_int_t *rdispls = (local_int_t*) MKL_malloc( sizeof(local_int_t)*A.geom->size, 128 );
-        local_int_t *scounts = (local_int_t*) MKL_malloc( sizeof(local_int_t)*A.geom->size, 128 );
-        local_int_t *rcounts = (local_int_t*) MKL_malloc( sizeof(local_int_t)*A.geom->size, 128 );
+        local_int_t *sdispls = (local_int_t*) TrackedMalloc(sizeof(local_int_t)*A.geom->size, HPCG_MEM_HALO);
+        local_int_t *rdispls = (local_int_t*) TrackedMalloc(sizeof(local_int_t)*A.geom->size, HPCG_MEM_HALO);
+        local_int_t *scounts = (local_int_t*) TrackedMalloc(sizeof(local_int_t)*A.geom->size, HPCG_MEM_HALO);
+        local_int_t *rcounts = (local_int_t*) TrackedMalloc(sizeof(local_int_t)*A.geom->size, HPCG_MEM_HALO);
         local_int_t tmp_s = 0, tmp_r = 0;
 
         if(sdispls == NULL || rdispls == NULL || scounts == NULL || rcounts == NULL) return;
@@ -266,13 +283,13 @@ void SetupHalo(SparseMatrix & A)
         A.sendLength = sendLength;
         A.sendBuffer = sendBuffer;
 
-        MKL_free(map_send);
-        MKL_free(map_neib_s);
-        MKL_free(elementsToSend_G);
-        MKL_free(all_send);
-        MKL_free(all_recv);
-        MKL_free(elementsToRecv_G);
-        MKL_free(request);
+        TrackedFree(map_send);
+        TrackedFree(map_neib_s);
+        TrackedFree(elementsToSend_G);
+        TrackedFree(all_send);
+        TrackedFree(all_recv);
+        TrackedFree(elementsToRecv_G);
+        TrackedFree(request);
     } else {
         A.numberOfExternalValues = 0;
         A.localNumberOfColumns = A.localNumberOfRows;
@@ -284,3 +301,566 @@ void SetupHalo(SparseMatrix & A)
     SetupHalo_ref(A);
 #endif
 }
+
+// Box of grid points [lo, hi) in each dimension, global coordinates
+struct GridBox {
+    global_int_t lo[3];
+    global_int_t hi[3];
+};
+
+// z extent of the ranks of process plane ipz
+static void ProcessPlaneZ(const Geometry & geom, int ipz, global_int_t & z0, local_int_t & nz)
+{
+    int first = 0;
+    z0 = 0;
+    nz = geom.nz;
+    for (int i = 0; i < geom.npartz; i++) {
+        int last = geom.partz_ids[i];
+        if (ipz < last) {
+            z0 += (global_int_t)(ipz - first)*geom.partz_nz[i];
+            nz = geom.partz_nz[i];
+            return;
+        }
+        z0 += (global_int_t)(last - first)*geom.partz_nz[i];
+        first = last;
+    }
+}
+
+// Owned box of the rank at (ipx, ipy, ipz) in the process grid
+static GridBox OwnedBox(const Geometry & geom, int ipx, int ipy, int ipz)
+{
+    GridBox box;
+    local_int_t nz;
+    box.lo[0] = (global_int_t) ipx*geom.nx;
+    box.lo[1] = (global_int_t) ipy*geom.ny;
+    ProcessPlaneZ(geom, ipz, box.lo[2], nz);
+    box.hi[0] = box.lo[0] + geom.nx;
+    box.hi[1] = box.lo[1] + geom.ny;
+    box.hi[2] = box.lo[2] + nz;
+    return box;
+}
+
+// Owned box grown by width layers, clipped to the global domain
+static GridBox ExtendedBox(const Geometry & geom, const GridBox & owned, int width)
+{
+    const global_int_t gn[3] = { geom.gnx, geom.gny, geom.gnz };
+    GridBox box;
+    for (int d = 0; d < 3; d++) {
+        box.lo[d] = (owned.lo[d] - width > 0) ? owned.lo[d] - width : 0;
+        box.hi[d] = (owned.hi[d] + width < gn[d]) ? owned.hi[d] + width : gn[d];
+    }
+    return box;
+}
+
+/*!
+  Builds the ghost region of the given width for kernels that run several steps between
+  exchanges, such as matrix powers, and attaches it to the optimized data of A.
+
+  The rows of the extended subdomain are generated from the geometry in the same way as
+  GenerateProblem does for the owned rows. Every rank of the 26 process grid neighbors gets
+  the intersection of its extended box with the owned box of this rank, so that all width
+  layers travel in one message per neighbor (see ExchangeDeepHalo). The width may not
+  exceed the local dimensions of any rank, so that ghost points only come from neighbors.
+
+  @param[inout] A     The known system matrix, after OptimizeProblem
+  @param[in]    width Number of ghost layers, 1 to HPCG_DEEP_HALO_MAX_WIDTH
+
+  @return Returns zero on success and a non-zero value if the width is not supported on some rank
+          or the local rows were renumbered.
+
+  @see ExchangeDeepHalo
+*/
+int SetupDeepHalo(SparseMatrix & A, int width)
+{
+    const Geometry & geom = *A.geom;
+    struct optData *optData = (struct optData *)A.optimizationData;
+
+    // The ghost layers are found from the grid coordinates, which renumbered rows no longer follow
+    int ierr = (optData == NULL || optData->localOrder != NULL || width < 1 || width > HPCG_DEEP_HALO_MAX_WIDTH) ? 1 : 0;
+    if (width > geom.nx || width > geom.ny) ierr = 1;
+    for (int i = 0; i < geom.npartz; i++)
+        if (width > geom.partz_nz[i]) ierr = 1;
+#ifndef HPCG_NO_MPI
+    int localError = ierr;
+    MPI_Allreduce(&localError, &ierr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+    if (ierr) return ierr;
+
+    const GridBox owned = OwnedBox(geom, geom.ipx, geom.ipy, geom.ipz);
+    const GridBox extended = ExtendedBox(geom, owned, width);
+    const local_int_t ex = extended.hi[0] - extended.lo[0];
+    const local_int_t ey = extended.hi[1] - extended.lo[1];
+    const local_int_t ez = extended.hi[2] - extended.lo[2];
+    const local_int_t boxLength = ex*ey*ez;
+    const local_int_t nx = geom.nx, ny = geom.ny;
+
+    // Ring of every point of the extended box and the number of points per ring
+    std::vector<unsigned char> ring(boxLength);
+    std::vector<local_int_t> ringCount(width+1, 0);
+    for (local_int_t iz = 0; iz < ez; iz++)
+        for (local_int_t iy = 0; iy < ey; iy++)
+            for (local_int_t ix = 0; ix < ex; ix++) {
+                const global_int_t g[3] = { extended.lo[0] + ix, extended.lo[1] + iy, extended.lo[2] + iz };
+                global_int_t distance = 0;
+                for (int d = 0; d < 3; d++) {
+                    global_int_t out = (g[d] < owned.lo[d]) ? owned.lo[d] - g[d] : (g[d] >= owned.hi[d] ? g[d] - owned.hi[d] + 1 : 0);
+                    if (out > distance) distance = out;
+                }
+                ring[(iz*ey + iy)*ex + ix] = (unsigned char) distance;
+                ringCount[distance]++;
+            }
+
+    DeepHalo * halo = new DeepHalo;
+    halo->width = width;
+    halo->localNumberOfRows = A.localNumberOfRows;
+    halo->extendedLength = boxLength;
+    halo->ringStart = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(width+2), HPCG_MEM_HALO);
+    halo->ringStart[0] = 0;
+    for (int d = 0; d <= width; d++) halo->ringStart[d+1] = halo->ringStart[d] + ringCount[d];
+
+    // Extended index of every box point: owned points in local order, then ring by ring
+    std::vector<local_int_t> boxIndex(boxLength);
+    std::vector<local_int_t> boxPoint(boxLength);
+    std::vector<local_int_t> next(halo->ringStart, halo->ringStart + width + 1);
+    for (local_int_t iz = 0; iz < ez; iz++)
+        for (local_int_t iy = 0; iy < ey; iy++)
+            for (local_int_t ix = 0; ix < ex; ix++) {
+                const local_int_t point = (iz*ey + iy)*ex + ix;
+                local_int_t index;
+                if (ring[point] == 0) {
+                    const local_int_t lx = extended.lo[0] + ix - owned.lo[0];
+                    const local_int_t ly = extended.lo[1] + iy - owned.lo[1];
+                    const local_int_t lz = extended.lo[2] + iz - owned.lo[2];
+                    index = (lz*ny + ly)*nx + lx;
+                } else {
+                    index = next[ring[point]]++;
+                }
+                boxIndex[point] = index;
+                boxPoint[index] = point;
+            }
+
+    // 27-point rows of rings 0 to width-1, their columns lie within one more ring
+    const local_int_t numberOfRows = halo->ringStart[width];
+    halo->rowStart = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(numberOfRows+1), HPCG_MEM_HALO);
+    halo->columns = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*27*numberOfRows, HPCG_MEM_HALO);
+    halo->values = (double *) TrackedMalloc(sizeof(double)*27*numberOfRows, HPCG_MEM_HALO);
+    local_int_t nnz = 0;
+    halo->rowStart[0] = 0;
+    for (local_int_t i = 0; i < numberOfRows; i++) {
+        const local_int_t point = boxPoint[i];
+        const local_int_t ix = point%ex, iy = (point/ex)%ey, iz = point/(ex*ey);
+        for (int sz = -1; sz <= 1; sz++) {
+            if (iz+sz < 0 || iz+sz >= ez) continue;
+            for (int sy = -1; sy <= 1; sy++) {
+                if (iy+sy < 0 || iy+sy >= ey) continue;
+                for (int sx = -1; sx <= 1; sx++) {
+                    if (ix+sx < 0 || ix+sx >= ex) continue;
+                    halo->columns[nnz] = boxIndex[((iz+sz)*ey + iy+sy)*ex + ix+sx];
+                    halo->values[nnz] = (sz == 0 && sy == 0 && sx == 0) ? 26.0 : -1.0;
+                    nnz++;
+                }
+            }
+        }
+        halo->rowStart[i+1] = nnz;
+    }
+
+    // Exchange lists: what each neighbor needs of the owned box, and where its points go
+    std::vector<int> neighbors;
+    std::vector<local_int_t> sendLength, receiveLength, elementsToSend, elementsToReceive;
+    for (int dz = -1; dz <= 1; dz++)
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++) {
+                const int qx = geom.ipx + dx, qy = geom.ipy + dy, qz = geom.ipz + dz;
+                if ((dx == 0 && dy == 0 && dz == 0) || qx < 0 || qx >= geom.npx || qy < 0 || qy >= geom.npy || qz < 0 || qz >= geom.npz) continue;
+                const GridBox neighborOwned = OwnedBox(geom, qx, qy, qz);
+                const GridBox neighborExtended = ExtendedBox(geom, neighborOwned, width);
+                GridBox send, receive;
+                for (int d = 0; d < 3; d++) {
+                    send.lo[d] = owned.lo[d] > neighborExtended.lo[d] ? owned.lo[d] : neighborExtended.lo[d];
+                    send.hi[d] = owned.hi[d] < neighborExtended.hi[d] ? owned.hi[d] : neighborExtended.hi[d];
+                    receive.lo[d] = extended.lo[d] > neighborOwned.lo[d] ? extended.lo[d] : neighborOwned.lo[d];
+                    receive.hi[d] = extended.hi[d] < neighborOwned.hi[d] ? extended.hi[d] : neighborOwned.hi[d];
+                }
+                local_int_t nsend = 0, nrecv = 0;
+                for (global_int_t gz = send.lo[2]; gz < send.hi[2]; gz++)
+                    for (global_int_t gy = send.lo[1]; gy < send.hi[1]; gy++)
+                        for (global_int_t gx = send.lo[0]; gx < send.hi[0]; gx++, nsend++)
+                            elementsToSend.push_back(((gz - owned.lo[2])*ny + gy - owned.lo[1])*nx + gx - owned.lo[0]);
+                for (global_int_t gz = receive.lo[2]; gz < receive.hi[2]; gz++)
+                    for (global_int_t gy = receive.lo[1]; gy < receive.hi[1]; gy++)
+                        for (global_int_t gx = receive.lo[0]; gx < receive.hi[0]; gx++, nrecv++)
+                            elementsToReceive.push_back(boxIndex[((gz - extended.lo[2])*ey + gy - extended.lo[1])*ex + gx - extended.lo[0]]);
+                neighbors.push_back(qx + qy*geom.npx + qz*geom.npx*geom.npy);
+                sendLength.push_back(nsend);
+                receiveLength.push_back(nrecv);
+            }
+
+    const int numberOfNeighbors = neighbors.size();
+    halo->numberOfNeighbors = numberOfNeighbors;
+    halo->totalToBeSent = elementsToSend.size();
+    halo->totalToBeReceived = elementsToReceive.size();
+    halo->neighbors = (int *) TrackedMalloc(sizeof(int)*numberOfNeighbors, HPCG_MEM_HALO);
+    halo->sendLength = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*numberOfNeighbors, HPCG_MEM_HALO);
+    halo->receiveLength = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*numberOfNeighbors, HPCG_MEM_HALO);
+    halo->elementsToSend = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*halo->totalToBeSent, HPCG_MEM_HALO);
+    halo->elementsToReceive = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*halo->totalToBeReceived, HPCG_MEM_HALO);
+    halo->sendBuffer = (double *) TrackedMalloc(sizeof(double)*halo->totalToBeSent, HPCG_MEM_HALO);
+    halo->receiveBuffer = (double *) TrackedMalloc(sizeof(double)*halo->totalToBeReceived, HPCG_MEM_HALO);
+    for (int i = 0; i < numberOfNeighbors; i++) {
+        halo->neighbors[i] = neighbors[i];
+        halo->sendLength[i] = sendLength[i];
+        halo->receiveLength[i] = receiveLength[i];
+    }
+    for (local_int_t i = 0; i < halo->totalToBeSent; i++) halo->elementsToSend[i] = elementsToSend[i];
+    for (local_int_t i = 0; i < halo->totalToBeReceived; i++) halo->elementsToReceive[i] = elementsToReceive[i];
+
+    DeleteDeepHalo(optData->deepHalo);
+    optData->deepHalo = halo;
+    return 0;
+}
+
+/*!
+  Selects the encoding of the halos exchanged inside the MG preconditioner on every level and
+  allocates the encoded message buffers. Exchanges outside of ComputeMG, such as the SpMV of
+  the CG iteration, always send double values. Every level also starts counting its halo
+  traffic for ReportResults.
+
+  @param[inout] A          The fine level matrix, coarse levels are reached through A.Ac
+  @param[in]    mode       HPCG_HALO_DOUBLE, HPCG_HALO_FLOAT or HPCG_HALO_BLOCK16
+  @param[in]    firstLevel Levels from this one down to the coarsest use the encoding, the finer ones stay exact
+
+  @return Returns zero on success and a non-zero value if the mode is unknown.
+*/
+int SetupHaloPrecision(SparseMatrix & A, int mode, int firstLevel)
+{
+    if (mode < HPCG_HALO_DOUBLE || mode > HPCG_HALO_BLOCK16) return 1;
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+    int level = 0;
+    for (SparseMatrix * Al = &A; Al != 0; Al = Al->Ac, level++) {
+        DeleteHaloPrecision(Al->haloPrecision);
+        HaloPrecision * hp = new HaloPrecision;
+        const int num_neighbors = Al->numberOfSendNeighbors;
+        hp->mode = (level >= firstLevel && Al->geom->size > 1) ? mode : HPCG_HALO_DOUBLE;
+        hp->exchanges = 0;
+        hp->bytesOnWire = 0.0;
+        hp->sendOffset = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(num_neighbors+1), HPCG_MEM_HALO);
+        hp->receiveOffset = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(num_neighbors+1), HPCG_MEM_HALO);
+        hp->sendOffset[0] = hp->receiveOffset[0] = 0;
+        for (int i = 0; i < num_neighbors; i++) {
+            // Keep every message 8-byte aligned
+            hp->sendOffset[i+1] = hp->sendOffset[i] + (HaloEncodedBytes(hp->mode, Al->sendLength[i]) + 7)/8*8;
+            hp->receiveOffset[i+1] = hp->receiveOffset[i] + (HaloEncodedBytes(hp->mode, Al->receiveLength[i]) + 7)/8*8;
+        }
+        hp->sendBytes = NULL;
+        hp->receiveBytes = NULL;
+        if (hp->mode != HPCG_HALO_DOUBLE) {
+            hp->sendBytes = (unsigned char *) TrackedMalloc(hp->sendOffset[num_neighbors], HPCG_MEM_HALO);
+            hp->receiveBytes = (unsigned char *) TrackedMalloc(hp->receiveOffset[num_neighbors], HPCG_MEM_HALO);
+        }
+        Al->haloPrecision = hp;
+    }
+#endif
+    return 0;
+}
+
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+/*!
+  Creates the distributed graph communicator of one level, whose sources and destinations are
+  A.neighbors in order, with the counts and offsets of MPI_Ineighbor_alltoallv. When the MPI
+  library provides MPI_Neighbor_alltoallv_init (MPI 4), the collective is also set up once as
+  a persistent request that sends from A.sendBuffer and receives into a buffer of the level.
+  Collective.
+
+  @param[in] A The matrix of the level
+
+  @return The neighborhood halo of the level
+
+  @see DeleteNeighborHalo
+*/
+NeighborHalo * NewNeighborHalo(const SparseMatrix & A)
+{
+    NeighborHalo * nh = new NeighborHalo;
+    const int num_neighbors = A.numberOfSendNeighbors;
+    MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD, num_neighbors, A.neighbors, MPI_UNWEIGHTED,
+                                   num_neighbors, A.neighbors, MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &nh->comm);
+    nh->sendCounts = (int *) TrackedMalloc(sizeof(int)*(num_neighbors+1), HPCG_MEM_HALO);
+    nh->sendDispls = (int *) TrackedMalloc(sizeof(int)*(num_neighbors+1), HPCG_MEM_HALO);
+    nh->receiveCounts = (int *) TrackedMalloc(sizeof(int)*(num_neighbors+1), HPCG_MEM_HALO);
+    nh->receiveDispls = (int *) TrackedMalloc(sizeof(int)*(num_neighbors+1), HPCG_MEM_HALO);
+    int sendOffset = 0, receiveOffset = 0;
+    for (int i = 0; i < num_neighbors; i++) {
+        nh->sendCounts[i] = A.sendLength[i];
+        nh->sendDispls[i] = sendOffset;
+        nh->receiveCounts[i] = A.receiveLength[i];
+        nh->receiveDispls[i] = receiveOffset;
+        sendOffset += A.sendLength[i];
+        receiveOffset += A.receiveLength[i];
+    }
+    nh->sendDispls[num_neighbors] = sendOffset;
+    nh->receiveDispls[num_neighbors] = receiveOffset;
+    nh->receiveBuffer = NULL;
+    nh->persistent = MPI_REQUEST_NULL;
+#if MPI_VERSION >= 4
+    nh->receiveBuffer = (double *) TrackedMalloc(sizeof(double)*(receiveOffset+1), HPCG_MEM_HALO);
+    MPI_Neighbor_alltoallv_init(A.sendBuffer, nh->sendCounts, nh->sendDispls, MPI_DOUBLE,
+                                nh->receiveBuffer, nh->receiveCounts, nh->receiveDispls, MPI_DOUBLE,
+                                nh->comm, MPI_INFO_NULL, &nh->persistent);
+#endif
+    return nh;
+}
+
+/*!
+  Creates the one-sided halo state of one level: the group of the neighbors and, for each
+  neighbor, the offset in its ghost region where the values sent by this rank land. The
+  offsets are learnt from the neighbors with one message each. No window exists until
+  vectors are registered with RegisterHaloWindow.
+
+  @param[in] A The matrix of the level
+
+  @return The one-sided halo of the level
+
+  @see DeleteRmaHalo
+*/
+RmaHalo * NewRmaHalo(const SparseMatrix & A)
+{
+    RmaHalo * rh = new RmaHalo;
+    const int num_neighbors = A.numberOfSendNeighbors;
+    MPI_Group world;
+    MPI_Comm_group(MPI_COMM_WORLD, &world);
+    MPI_Group_incl(world, num_neighbors, A.neighbors, &rh->group);
+    MPI_Group_free(&world);
+    rh->numberOfWindows = 0;
+    rh->exchanges = 0;
+
+    // Tell every neighbor where its values go in the ghost region of this rank
+    std::vector<local_int_t> receiveOffset(num_neighbors+1, 0);
+    for (int i = 0; i < num_neighbors; i++) receiveOffset[i+1] = receiveOffset[i] + A.receiveLength[i];
+    rh->targetOffset = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(num_neighbors+1), HPCG_MEM_HALO);
+    std::vector<MPI_Request> request(2*num_neighbors+1);
+    const int MPI_MY_TAG = 97;
+    for (int i = 0; i < num_neighbors; i++)
+        MPI_Irecv(rh->targetOffset+i, 1, MPI_INT, A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, &request[i]);
+    for (int i = 0; i < num_neighbors; i++)
+        MPI_Isend(&receiveOffset[i], 1, MPI_INT, A.neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, &request[num_neighbors+i]);
+    MPI_Waitall(2*num_neighbors, &request[0], MPI_STATUSES_IGNORE);
+    return rh;
+}
+#endif
+
+/*!
+  Exposes the ghost region of a vector of one level in an MPI window, so that one-sided halo
+  exchanges of that vector put the values of the neighbors straight into x. Exchanges of
+  vectors that were not registered use the two-sided transport. Collective, and must be made
+  in the same order on all ranks.
+
+  @param[inout] A The matrix of the level, with the one-sided halo selected by SetupHaloBackend
+  @param[in]    x A vector of the level, which must outlive A
+
+  @return Returns zero if the window was created or the one-sided halo is not in use, and a
+          non-zero value if the level already has HPCG_RMA_MAX_WINDOWS windows.
+*/
+int RegisterHaloWindow(SparseMatrix & A, Vector & x)
+{
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+    RmaHalo * rh = A.rmaHalo;
+    if (rh == NULL) return 0;
+    double * ghost = x.values + A.localNumberOfRows;
+    if (FindHaloWindow(*rh, ghost) >= 0) return 0;
+    if (rh->numberOfWindows == HPCG_RMA_MAX_WINDOWS) return 1;
+
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, (char *) "no_locks", (char *) "true"); // only post-start-complete-wait epochs
+    const local_int_t numberOfGhosts = A.localNumberOfColumns - A.localNumberOfRows;
+    MPI_Win_create(ghost, sizeof(double)*numberOfGhosts, sizeof(double), info, MPI_COMM_WORLD, &rh->windows[rh->numberOfWindows]);
+    MPI_Info_free(&info);
+    rh->ghosts[rh->numberOfWindows++] = ghost;
+#endif
+    return 0;
+}
+
+/*!
+  Selects how the double precision halos are exchanged on every level.
+
+  - HPCG_HALO_BACKEND_P2P keeps MPI_Alltoallv on MPI_COMM_WORLD, or one message pair per
+    neighbor for split-phase exchanges.
+  - HPCG_HALO_BACKEND_NEIGHBOR posts MPI_Ineighbor_alltoallv on a distributed graph
+    communicator of the neighbors, see NewNeighborHalo.
+  - HPCG_HALO_BACKEND_RMA puts the packed values into windows over the ghost regions of the
+    neighbors, synchronized by post-start-complete-wait on the neighbor group, see
+    NewRmaHalo. The restriction vectors of the coarse levels are registered here; the fine
+    level vectors are registered by the caller with RegisterHaloWindow.
+
+  Must be called after OptimizeProblem, which may replace the send buffers. Collective.
+
+  @param[inout] A       The fine level matrix, coarse levels are reached through A.Ac
+  @param[in]    backend HPCG_HALO_BACKEND_P2P, HPCG_HALO_BACKEND_NEIGHBOR or HPCG_HALO_BACKEND_RMA
+
+  @return Returns zero on success and a non-zero value if the backend is unknown.
+*/
+int SetupHaloBackend(SparseMatrix & A, int backend)
+{
+    if (backend < HPCG_HALO_BACKEND_P2P || backend > HPCG_HALO_BACKEND_RMA) return 1;
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+    for (SparseMatrix * Al = &A; Al != 0; Al = Al->Ac) {
+        DeleteNeighborHalo(Al->neighborHalo);
+        DeleteRmaHalo(Al->rmaHalo);
+        Al->neighborHalo = NULL;
+        Al->rmaHalo = NULL;
+        if (Al->geom->size == 1) continue;
+        if (backend == HPCG_HALO_BACKEND_NEIGHBOR) Al->neighborHalo = NewNeighborHalo(*Al);
+        if (backend == HPCG_HALO_BACKEND_RMA) Al->rmaHalo = NewRmaHalo(*Al);
+    }
+    for (SparseMatrix * Al = &A; Al->Ac != 0; Al = Al->Ac)
+        RegisterHaloWindow(*Al->Ac, *Al->mgData->xc);
+#endif
+    return 0;
+}
+
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+// Describes the points sent to each neighbor as a box of the local grid, or returns NULL if
+// a send list is not a box traversed in lexicographic order
+static HaloDatatypes * NewHaloDatatypes(const SparseMatrix & A)
+{
+    const local_int_t nx = A.geom->nx, ny = A.geom->ny, nz = A.geom->nz;
+    if ((long long) nx*ny*nz != A.localNumberOfRows) return NULL;
+    const int num_neighbors = A.numberOfSendNeighbors;
+
+    HaloDatatypes * hd = new HaloDatatypes;
+    hd->mode = HPCG_HALO_PACK_STRIDED;
+    hd->numberOfNeighbors = num_neighbors;
+    hd->nx = nx;
+    hd->ny = ny;
+    hd->box = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*6*(num_neighbors+1), HPCG_MEM_HALO);
+    hd->sliceStart = (local_int_t *) TrackedMalloc(sizeof(local_int_t)*(num_neighbors+1), HPCG_MEM_HALO);
+    hd->types = (MPI_Datatype *) TrackedMalloc(sizeof(MPI_Datatype)*(num_neighbors+1), HPCG_MEM_HALO);
+    for (int i = 0; i < num_neighbors; i++) hd->types[i] = MPI_DATATYPE_NULL;
+    hd->sliceStart[0] = 0;
+
+    const local_int_t * elementsToSend = A.elementsToSend;
+    for (int i = 0; i < num_neighbors; i++) {
+        const local_int_t n = A.sendLength[i];
+        local_int_t lo[3] = { nx, ny, nz }, hi[3] = { -1, -1, -1 };
+        for (local_int_t k = 0; k < n; k++) {
+            const local_int_t e = elementsToSend[k];
+            const local_int_t c[3] = { e%nx, (e/nx)%ny, e/(nx*ny) };
+            for (int d = 0; d < 3; d++) {
+                if (c[d] < lo[d]) lo[d] = c[d];
+                if (c[d] > hi[d]) hi[d] = c[d];
+            }
+        }
+        local_int_t * b = hd->box + 6*i;
+        for (int d = 0; d < 3; d++) {
+            b[d] = lo[d];
+            b[3+d] = (n > 0) ? hi[d] - lo[d] + 1 : 0;
+        }
+        bool isBox = (long long) b[3]*b[4]*b[5] == n;
+        local_int_t k = 0;
+        for (local_int_t z = 0; isBox && z < b[5]; z++)
+            for (local_int_t y = 0; isBox && y < b[4]; y++)
+                for (local_int_t x = 0; isBox && x < b[3]; x++, k++)
+                    isBox = elementsToSend[k] == ((b[2] + z)*ny + b[1] + y)*nx + b[0] + x;
+        if (!isBox) {
+            DeleteHaloDatatypes(hd);
+            return NULL;
+        }
+        hd->sliceStart[i+1] = hd->sliceStart[i] + b[5];
+
+        int sizes[3] = { (int) nz, (int) ny, (int) nx };
+        int subsizes[3] = { (int) b[5], (int) b[4], (int) b[3] };
+        int starts[3] = { (int) b[2], (int) b[1], (int) b[0] };
+        MPI_Type_create_subarray(3, sizes, subsizes, starts, MPI_ORDER_C, MPI_DOUBLE, &hd->types[i]);
+        MPI_Type_commit(&hd->types[i]);
+        elementsToSend += n;
+    }
+    return hd;
+}
+
+// Times the index gather, the strided kernels and MPI_Pack of the datatypes on one level,
+// and checks that the strided kernels produce the gathered buffer. Returns false otherwise.
+static bool TimeHaloPacking(SparseMatrix & A, HaloDatatypes & hd)
+{
+    const int nrep = 100;
+    const local_int_t n = A.totalToBeSent;
+    double * xv = (double *) TrackedMalloc(sizeof(double)*(A.localNumberOfRows+1), HPCG_MEM_SCRATCH);
+    double * gathered = (double *) TrackedMalloc(sizeof(double)*(n+1), HPCG_MEM_SCRATCH);
+    for (local_int_t i = 0; i < A.localNumberOfRows; i++) xv[i] = (double) i;
+
+    A.haloDatatypes = NULL;
+    PackHalo(A, xv);
+    double t0 = mytimer();
+    for (int k = 0; k < nrep; k++) PackHalo(A, xv);
+    hd.packTime[0] = (mytimer() - t0)/nrep;
+    for (local_int_t i = 0; i < n; i++) gathered[i] = A.sendBuffer[i];
+
+    A.haloDatatypes = &hd;
+    PackHalo(A, xv);
+    bool same = true;
+    for (local_int_t i = 0; i < n; i++) same = same && A.sendBuffer[i] == gathered[i];
+    t0 = mytimer();
+    for (int k = 0; k < nrep; k++) PackHalo(A, xv);
+    hd.packTime[1] = (mytimer() - t0)/nrep;
+    A.haloDatatypes = NULL;
+
+    const int bytes = (int) (sizeof(double)*n);
+    t0 = mytimer();
+    for (int k = 0; k < nrep; k++) {
+        int position = 0;
+        for (int i = 0; i < hd.numberOfNeighbors; i++)
+            MPI_Pack(xv, 1, hd.types[i], A.sendBuffer, bytes, &position, MPI_COMM_WORLD);
+    }
+    hd.packTime[2] = (mytimer() - t0)/nrep;
+
+    TrackedFree(gathered);
+    TrackedFree(xv);
+    return same;
+}
+#endif
+
+/*!
+  Replaces the index list gather of the halo send buffer on every level where the points sent
+  to each neighbor form a face, edge or corner box of the local grid, which is the case for
+  the generated problem in its natural ordering.
+
+  - HPCG_HALO_PACK_DATATYPE sends straight from x with one MPI subarray datatype per
+    neighbor, leaving the packing, if any, to the MPI library.
+  - HPCG_HALO_PACK_STRIDED copies the boxes into the send buffer with strided kernels.
+  - HPCG_HALO_PACK_AUTO picks the datatypes on a level unless MPI_Pack of them is slower
+    than the strided kernels there.
+
+  The three ways of packing are timed on every level for ReportResults. Levels where some
+  rank does not send boxes keep the gather. Collective.
+
+  @param[inout] A    The fine level matrix, coarse levels are reached through A.Ac
+  @param[in]    mode One of the HPCG_HALO_PACK values, HPCG_HALO_PACK_GATHER keeps the gather everywhere
+
+  @return Returns zero on success and a non-zero value if the mode is unknown.
+*/
+int SetupHaloDatatypes(SparseMatrix & A, int mode)
+{
+    if (mode < HPCG_HALO_PACK_GATHER || mode > HPCG_HALO_PACK_AUTO) return 1;
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+    for (SparseMatrix * Al = &A; Al != 0; Al = Al->Ac) {
+        DeleteHaloDatatypes(Al->haloDatatypes);
+        Al->haloDatatypes = NULL;
+        if (mode == HPCG_HALO_PACK_GATHER || Al->geom->size == 1) continue;
+
+        HaloDatatypes * hd = NewHaloDatatypes(*Al);
+        int boxes = (hd != NULL && TimeHaloPacking(*Al, *hd)) ? 1 : 0;
+        int allBoxes = 0;
+        MPI_Allreduce(&boxes, &allBoxes, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (!allBoxes) {
+            DeleteHaloDatatypes(hd);
+            continue;
+        }
+        // The blocking exchange is collective with the gather and the strided kernels, so all ranks take the same path
+        double packTime[3] = { hd->packTime[0], hd->packTime[1], hd->packTime[2] };
+        MPI_Allreduce(packTime, hd->packTime, 3, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        hd->mode = mode;
+        if (mode == HPCG_HALO_PACK_AUTO)
+            hd->mode = (hd->packTime[2] <= hd->packTime[1]) ? HPCG_HALO_PACK_DATATYPE : HPCG_HALO_PACK_STRIDED;
+        Al->haloDatatypes = hd;
+    }
+#endif
+    return 0;
+}
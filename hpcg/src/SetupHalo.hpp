@@ -28,7 +28,17 @@
 #ifndef SETUPHALO_HPP
 #define SETUPHALO_HPP
 #include "SparseMatrix.hpp"
+#include "Vector.hpp"
 
 void SetupHalo(SparseMatrix & A);
+int SetupDeepHalo(SparseMatrix & A, int width);
+int SetupHaloPrecision(SparseMatrix & A, int mode, int firstLevel);
+int SetupHaloBackend(SparseMatrix & A, int backend);
+int RegisterHaloWindow(SparseMatrix & A, Vector & x);
+int SetupHaloDatatypes(SparseMatrix & A, int mode);
+#if !defined(HPCG_LOCAL_LONG_LONG) && !defined(HPCG_NO_MPI)
+NeighborHalo * NewNeighborHalo(const SparseMatrix & A);
+RmaHalo * NewRmaHalo(const SparseMatrix & A);
+#endif
 
 #endif // SETUPHALO_HPP
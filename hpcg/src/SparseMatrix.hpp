@@ -53,6 +53,13 @@ using GlobalToLocalMap = std::unordered_map< global_int_t, local_int_t >;
 #include "mkl_spblas.h"
 #include "mkl_service.h"
 #include "stdio.h"
+#include "CompressedMatrix.hpp"
+#include "DeepHalo.hpp"
+#include "HaloPrecision.hpp"
+#include "NeighborHalo.hpp"
+#include "RmaHalo.hpp"
+#include "HaloDatatypes.hpp"
+#include "OptimizedCsr.hpp"
 
 struct optData
 {
@@ -65,6 +72,11 @@ struct optData
     local_int_t *bmap;
     void *csrA;
     void *csrB;
+    double mklBytes; //!< estimated storage held inside the csrA and csrB handles
+    CompressedMatrix *cmat; //!< compressed index copy of the local rows, NULL unless --compressed-index=1
+    DeepHalo *deepHalo; //!< ghost region of width > 1 of the fine level, NULL unless --deep-halo=k
+    local_int_t *localOrder; //!< generated row behind every local row, NULL unless --local-order=1
+    OptimizedCsr *csr; //!< CSR arrays behind csrA and csrB, NULL unless kept for a checkpoint
 };
 
 struct SparseMatrix_STRUCT {
@@ -80,8 +92,8 @@ struct SparseMatrix_STRUCT {
   local_int_t ** mtxIndL; //!< matrix indices as local values
   double ** matrixValues; //!< values of matrix entries
   double ** matrixDiagonal; //!< values of matrix diagonal entries
-  GlobalToLocalMap globalToLocalMap; //!< global-to-local mapping
-  std::vector< global_int_t > localToGlobalMap; //!< local-to-global mapping
+  GlobalToLocalMap globalToLocalMap; //!< global-to-local mapping, reference setup only (see RowIndexing.hpp)
+  std::vector< global_int_t > localToGlobalMap; //!< local-to-global mapping, reference setup only (see RowIndexing.hpp)
   mutable bool isDotProductOptimized;
   mutable bool isSpmvOptimized;
   mutable bool isMgOptimized;
@@ -103,6 +115,10 @@ struct SparseMatrix_STRUCT {
   local_int_t * receiveLength; //!< lenghts of messages received from neighboring processes
   local_int_t * sendLength; //!< lenghts of messages sent to neighboring processes
   double * sendBuffer; //!< send buffer for non-blocking sends
+  HaloPrecision * haloPrecision; //!< halo encoding inside the MG preconditioner and traffic of this level, NULL until SetupHaloPrecision
+  NeighborHalo * neighborHalo; //!< neighborhood collective state of this level, NULL unless SetupHaloBackend selects that backend
+  RmaHalo * rmaHalo; //!< one-sided halo state and windows of this level, NULL unless SetupHaloBackend selects that backend
+  HaloDatatypes * haloDatatypes; //!< send boxes replacing the gather through elementsToSend, NULL unless SetupHaloDatatypes found them
 #endif
   local_int_t * boundaryRows; //!< rows that contain less than 27 nonzeros
   local_int_t numOfBoundaryRows;
@@ -156,11 +172,23 @@ inline void InitializeSparseMatrix(SparseMatrix & A, Geometry * geom) {
   A.receiveLength = 0;
   A.sendLength = 0;
   A.sendBuffer = 0;
+  A.haloPrecision = NULL;
+  A.neighborHalo = NULL;
+  A.rmaHalo = NULL;
+  A.haloDatatypes = NULL;
 #endif
   A.mgData = 0; // Fine-to-coarse grid transfer initially not defined.
   A.Ac =0;
   
   A.optimizationData=NULL;
+  A.mtxL = 0;
+  A.mtxG = 0;
+  A.mtxA = 0;
+  A.work = 0;
+  A.scounts = 0;
+  A.rcounts = 0;
+  A.sdispls = 0;
+  A.rdispls = 0;
   return;
 }
 
@@ -210,6 +238,7 @@ inline void ReplaceMKLMatrixDiagonal(SparseMatrix & A, Vector & diagonal)
         stat = mkl_sparse_d_set_value(csrA, i, i, diagonal.values[i]);
         optData->diag[i] = diagonal.values[i];
     }
+    if ( optData->cmat != NULL ) ReplaceCompressedMatrixDiagonal(*optData->cmat, diagonal.values);
 }
 /*!
   Deallocates the members of the data structure of the known system matrix provided they are not 0.
@@ -251,30 +280,44 @@ inline void DeleteMatrix(SparseMatrix & A) {
 
 #else
   if (A.title)                  delete [] A.title;
-  if (A.nonzerosInRow) { MKL_free(A.nonzerosInRow); A.nonzerosInRow  = NULL; }
-  if (A.matrixDiagonal){ MKL_free(A.matrixDiagonal);A.matrixDiagonal = NULL; }
-  if (A.boundaryRows)  { MKL_free( A.boundaryRows) ;A.boundaryRows   = NULL; }
+  if (A.nonzerosInRow) { TrackedFree(A.nonzerosInRow); A.nonzerosInRow  = NULL; }
+  if (A.matrixDiagonal){ TrackedFree(A.matrixDiagonal);A.matrixDiagonal = NULL; }
+  if (A.boundaryRows)  { TrackedFree( A.boundaryRows) ;A.boundaryRows   = NULL; }
 
 #ifndef HPCG_NO_MPI
-  MKL_free(A.elementsToSend);
-  MKL_free(A.neighbors);
-  MKL_free(A.receiveLength);
-  MKL_free(A.sendLength);
-  MKL_free(A.sendBuffer);
+  TrackedFree(A.elementsToSend);
+  TrackedFree(A.neighbors);
+  TrackedFree(A.receiveLength);
+  TrackedFree(A.sendLength);
+  TrackedFree(A.sendBuffer);
+  TrackedFree(A.scounts);
+  TrackedFree(A.rcounts);
+  TrackedFree(A.sdispls);
+  TrackedFree(A.rdispls);
+  DeleteHaloPrecision(A.haloPrecision);
+  DeleteNeighborHalo(A.neighborHalo);
+  DeleteRmaHalo(A.rmaHalo);
+  DeleteHaloDatatypes(A.haloDatatypes);
 #endif
+  TrackedFree(A.work);
 
   struct optData *optData = (struct optData *)A.optimizationData;
   if ( optData != NULL )
   {
-      MKL_free(optData->dtmp);
-      MKL_free(optData->bmap);
-      MKL_free(optData->diag);
+      TrackedFree(optData->dtmp);
+      TrackedFree(optData->bmap);
+      TrackedFree(optData->diag);
 
       sparse_matrix_t csrA = (sparse_matrix_t)optData->csrA;
       sparse_matrix_t csrB = (sparse_matrix_t)optData->csrB;
       mkl_sparse_destroy(csrA);
       mkl_sparse_destroy(csrB);
-      MKL_free(optData);
+      TrackMemory(HPCG_MEM_MKL, -optData->mklBytes);
+      DeleteCompressedMatrix(optData->cmat);
+      DeleteDeepHalo(optData->deepHalo);
+      TrackedFree(optData->localOrder);
+      DeleteOptimizedCsr(optData->csr);
+      TrackedFree(optData);
   }
 
   if (A.geom!=0) { DeleteGeometry(*A.geom); delete A.geom; A.geom = 0;}
@@ -294,6 +337,11 @@ inline void init_optData(struct optData optData)
     optData.csrA  = NULL;
     optData.csrB  = NULL;
     optData.bmap  = NULL;
+    optData.mklBytes = 0.0;
+    optData.cmat  = NULL;
+    optData.deepHalo = NULL;
+    optData.localOrder = NULL;
+    optData.csr = NULL;
 }
 
 #endif // SPARSEMATRIX_HPP
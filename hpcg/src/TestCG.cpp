@@ -47,6 +47,7 @@ using std::endl;
 
 #include "TestCG.hpp"
 #include "CG.hpp"
+#include "RowIndexing.hpp"
 
 /*!
   Test the correctness of the Preconditined CG implementation by using a system matrix with a dominant diagonal.
@@ -78,7 +79,7 @@ int TestCG(SparseMatrix & A, CGData & data, Vector & b, Vector & x, TestCGData &
   // Modify the matrix diagonal to greatly exaggerate diagonal values.
   // CG should converge in about 10 iterations for this problem, regardless of problem size
   for (local_int_t i=0; i< A.localNumberOfRows; ++i) {
-    global_int_t globalRowID = A.localToGlobalMap[i];
+    global_int_t globalRowID = GlobalRowOfLocalRow(A, i);
     if (globalRowID<9) {
       double scale = (globalRowID+2)*1.0e6;
       ScaleVectorValue(exaggeratedDiagA, i, scale);
@@ -52,6 +52,7 @@ using std::endl;
 #include "ComputeResidual.hpp"
 #include "Geometry.hpp"
 #include "SparseMatrix.hpp"
+#include "RandomVector.hpp"
 #include "TestSymmetry.hpp"
 
 /*!
@@ -88,8 +89,8 @@ int TestSymmetry(SparseMatrix & A, Vector & b, Vector & xexact, TestSymmetryData
  // Test symmetry of matrix
 
  // First load vectors with random values
- FillRandomVector(x_ncol);
- FillRandomVector(y_ncol);
+ FillRandomVector(A, x_ncol, 1);
+ FillRandomVector(A, y_ncol, 2);
 
  double xNorm2, yNorm2;
  double ANorm = 2 * 26.0;
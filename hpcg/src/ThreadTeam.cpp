@@ -0,0 +1,357 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ThreadTeam.cpp
+
+ HPCG routine
+ */
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#ifndef HPCG_NO_OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__linux__) && !defined(HPCG_NO_OPENMP)
+#include <pthread.h>
+#include <sched.h>
+#define HPCG_TEAM_AFFINITY
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEAM_PAUSE() _mm_pause()
+#else
+#define TEAM_PAUSE()
+#endif
+
+#include "ThreadTeam.hpp"
+#include "SparseMatrix.hpp"
+#include "TrackedAllocator.hpp"
+#include "mytimer.hpp"
+
+// Waiting threads poll this many times before they start yielding the core
+#define TEAM_SPIN_LIMIT 1000
+// Idle workers yield this many times before they block on the condition variable
+#define TEAM_YIELD_LIMIT 100
+
+static int teamSize = 1;        // threads in the team, including the master
+static bool teamActive = false; // true once the workers are running
+static std::vector<std::thread> teamWorkers;
+
+// Dispatch state, published by the master through teamGeneration
+static ThreadTeamKernel teamKernel = 0;
+static void * teamArgs = 0;
+static bool teamStop = false;
+static std::atomic<unsigned long> teamGeneration(0);
+static std::atomic<int> teamSleepers(0);
+static std::mutex teamMutex;
+static std::condition_variable teamWakeup;
+
+// Sense-reversing barrier closing every dispatch
+static std::atomic<int> barrierCount(0);
+static std::atomic<int> barrierSense(0);
+static int masterSense = 0;
+
+static std::vector<double> teamPartials;
+static int partialThreads = 1; // number of partial sums written by the last dispatch
+
+static std::vector<ThreadTeamLevelTimes> benchmarkLevels;
+static double benchmarkBarrierTime = 0.0;
+
+static void BarrierWait(int & localSense) {
+  localSense = 1 - localSense;
+  if (barrierCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // Last thread in: reset the count for the next episode, then release the others
+    barrierCount.store(teamSize, std::memory_order_relaxed);
+    barrierSense.store(localSense, std::memory_order_release);
+  } else {
+    // Yield once the wait gets long, in case the team shares cores with other threads
+    for (int spin=0; barrierSense.load(std::memory_order_acquire) != localSense; ++spin) {
+      if (spin < TEAM_SPIN_LIMIT) TEAM_PAUSE();
+      else std::this_thread::yield();
+    }
+  }
+  return;
+}
+
+static void WaitForDispatch(unsigned long & seen) {
+  for (int spin=0; spin<TEAM_SPIN_LIMIT+TEAM_YIELD_LIMIT; ++spin) {
+    if (teamGeneration.load(std::memory_order_acquire) != seen) {
+      seen = teamGeneration.load(std::memory_order_acquire);
+      return;
+    }
+    if (spin < TEAM_SPIN_LIMIT) TEAM_PAUSE();
+    else std::this_thread::yield();
+  }
+  // Long idle phases (MKL kernels, MPI waits) leave the cores to the OpenMP threads
+  std::unique_lock<std::mutex> lock(teamMutex);
+  teamSleepers.fetch_add(1);
+  while (teamGeneration.load() == seen) teamWakeup.wait(lock);
+  teamSleepers.fetch_sub(1);
+  seen = teamGeneration.load(std::memory_order_acquire);
+  return;
+}
+
+static void WorkerLoop(int tid) {
+  unsigned long seen = 0;
+  int localSense = 0;
+  while (true) {
+    WaitForDispatch(seen);
+    if (teamStop) break;
+    teamKernel(tid, teamSize, teamArgs);
+    BarrierWait(localSense);
+  }
+  return;
+}
+
+/*!
+  Starts the persistent worker team used by ThreadTeamRun.
+
+  The workers are started once and live until FinalizeThreadTeam, so a kernel dispatch costs
+  one release store plus one barrier instead of an OpenMP fork and join. On Linux worker t is
+  bound to the CPU set of OpenMP thread t, so the team and MKL share the same cores.
+
+  @param[in] numberOfThreads Team size including the calling thread; values below 2 leave the team
+                             disabled and ThreadTeamRun uses OpenMP parallel regions.
+*/
+void InitializeThreadTeam(int numberOfThreads) {
+  int maxThreads = 1;
+#ifndef HPCG_NO_OPENMP
+  maxThreads = omp_get_max_threads();
+#endif
+  if (numberOfThreads > maxThreads) maxThreads = numberOfThreads;
+  teamPartials.assign((size_t) maxThreads*HPCG_TEAM_PAD, 0.0);
+  if (numberOfThreads < 2 || teamActive) return;
+
+  teamSize = numberOfThreads;
+  teamStop = false;
+  barrierCount.store(teamSize);
+  barrierSense.store(0);
+  masterSense = 0;
+
+#ifdef HPCG_TEAM_AFFINITY
+  std::vector<cpu_set_t> masks(teamSize);
+  std::vector<int> haveMask(teamSize, 0);
+#pragma omp parallel num_threads(teamSize)
+  {
+    int t = omp_get_thread_num();
+    CPU_ZERO(&masks[t]);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &masks[t]) == 0) haveMask[t] = 1;
+  }
+#endif
+
+  for (int t=1; t<teamSize; ++t) {
+    teamWorkers.push_back(std::thread(WorkerLoop, t));
+#ifdef HPCG_TEAM_AFFINITY
+    if (haveMask[t]) pthread_setaffinity_np(teamWorkers.back().native_handle(), sizeof(cpu_set_t), &masks[t]);
+#endif
+  }
+  teamActive = true;
+  return;
+}
+
+/*!
+  Stops and joins the worker team.
+*/
+void FinalizeThreadTeam(void) {
+  if (!teamActive) return;
+  teamStop = true;
+  {
+    std::lock_guard<std::mutex> lock(teamMutex);
+    teamGeneration.fetch_add(1);
+  }
+  teamWakeup.notify_all();
+  for (size_t t=0; t<teamWorkers.size(); ++t) teamWorkers[t].join();
+  teamWorkers.clear();
+  teamActive = false;
+  teamSize = 1;
+  return;
+}
+
+bool UseThreadTeam(void) {
+  return teamActive;
+}
+
+int ThreadTeamSize(void) {
+  return teamSize;
+}
+
+/*!
+  Executes kernel on every thread and returns once all of them are done.
+
+  With the team running the calling thread takes part as thread 0. Otherwise the kernel runs
+  inside an OpenMP parallel region, so callers have a single code path either way.
+
+  @param[in] kernel The kernel, see ThreadTeamKernel
+  @param[in] args   Arguments passed unchanged to the kernel
+*/
+void ThreadTeamRun(ThreadTeamKernel kernel, void * args) {
+  if (teamActive) {
+    teamKernel = kernel;
+    teamArgs = args;
+    teamGeneration.fetch_add(1);
+    if (teamSleepers.load() > 0) {
+      std::lock_guard<std::mutex> lock(teamMutex);
+      teamWakeup.notify_all();
+    }
+    kernel(0, teamSize, args);
+    BarrierWait(masterSense);
+    partialThreads = teamSize;
+    return;
+  }
+#ifndef HPCG_NO_OPENMP
+#pragma omp parallel
+  {
+    const int numberOfThreads = omp_get_num_threads();
+    if (omp_get_thread_num() == 0) partialThreads = numberOfThreads;
+    kernel(omp_get_thread_num(), numberOfThreads, args);
+  }
+#else
+  partialThreads = 1;
+  kernel(0, 1, args);
+#endif
+  return;
+}
+
+/*!
+  Returns the per-thread slots for reductions: thread tid writes its partial sum to
+  element tid*HPCG_TEAM_PAD, one cache line per thread.
+*/
+double * ThreadTeamPartials(void) {
+  return &teamPartials[0];
+}
+
+/*!
+  Returns the sum of the partial sums written by the last ThreadTeamRun, in thread order.
+*/
+double ThreadTeamSumPartials(void) {
+  double sum = 0.0;
+  for (int t=0; t<partialThreads; ++t) sum += teamPartials[(size_t) t*HPCG_TEAM_PAD];
+  return sum;
+}
+
+struct BenchmarkArgs {
+  local_int_t n;
+  double * w;
+  double * x;
+  double * y;
+};
+
+static void EmptyKernel(int tid, int numberOfThreads, void * args) {
+  return;
+}
+
+static void InitKernel(int tid, int numberOfThreads, void * args) {
+  const BenchmarkArgs * a = (const BenchmarkArgs *) args;
+  local_int_t begin, end;
+  ThreadTeamRange(a->n, tid, numberOfThreads, begin, end);
+  for (local_int_t i=begin; i<end; ++i) { a->w[i] = 0.0; a->x[i] = 1.0; a->y[i] = 2.0; }
+  return;
+}
+
+static void UpdateKernel(int tid, int numberOfThreads, void * args) {
+  const BenchmarkArgs * a = (const BenchmarkArgs *) args;
+  local_int_t begin, end;
+  ThreadTeamRange(a->n, tid, numberOfThreads, begin, end);
+  for (local_int_t i=begin; i<end; ++i) a->w[i] = a->x[i] + 0.5*a->y[i];
+  return;
+}
+
+/*!
+  Measures the cost of a kernel dispatch through the team against an OpenMP parallel region.
+
+  For every MG level a vector update w = x + 0.5*y over the local rows of the level is
+  timed both ways, which shows how much of the short coarse level kernels is spent in
+  fork, join and barriers. The results are kept for ReportResults.
+
+  @param[in] A The fine grid matrix, the levels are reached through A.Ac
+*/
+void BenchmarkThreadTeam(const SparseMatrix & A) {
+  benchmarkLevels.clear();
+  benchmarkBarrierTime = 0.0;
+  if (!teamActive) return;
+
+  const int nrep = 200;
+  const local_int_t n0 = A.localNumberOfRows;
+  double * w = (double *) TrackedMalloc(sizeof(double)*3*n0, HPCG_MEM_SCRATCH);
+  if (w == 0) return;
+  double * x = w + n0;
+  double * y = w + 2*n0;
+  BenchmarkArgs args = { n0, w, x, y };
+  ThreadTeamRun(InitKernel, &args); // first touch by the owning threads
+
+  double t0 = mytimer();
+  for (int k=0; k<nrep; ++k) ThreadTeamRun(EmptyKernel, 0);
+  benchmarkBarrierTime = (mytimer() - t0)/nrep;
+
+  for (const SparseMatrix * Ac = &A; Ac != 0; Ac = Ac->Ac) {
+    ThreadTeamLevelTimes level;
+    const local_int_t n = Ac->localNumberOfRows;
+    level.rows = n;
+    args.n = n;
+    ThreadTeamRun(UpdateKernel, &args);
+    t0 = mytimer();
+    for (int k=0; k<nrep; ++k) ThreadTeamRun(UpdateKernel, &args);
+    level.teamTime = (mytimer() - t0)/nrep;
+
+#ifndef HPCG_NO_OPENMP
+#pragma omp parallel for num_threads(teamSize)
+#endif
+    for (local_int_t i=0; i<n; ++i) w[i] = x[i] + 0.5*y[i];
+    t0 = mytimer();
+    for (int k=0; k<nrep; ++k) {
+#ifndef HPCG_NO_OPENMP
+#pragma omp parallel for num_threads(teamSize)
+#endif
+      for (local_int_t i=0; i<n; ++i) w[i] = x[i] + 0.5*y[i];
+    }
+    level.openmpTime = (mytimer() - t0)/nrep;
+    benchmarkLevels.push_back(level);
+  }
+  TrackedFree(w);
+  return;
+}
+
+/*!
+  Returns the results of BenchmarkThreadTeam.
+
+  @param[out] levels       Per level timings, finest level first
+  @param[out] barrierTime  Seconds per dispatch of an empty kernel
+
+  @return The number of levels measured, zero if the benchmark did not run
+*/
+int GetThreadTeamBenchmark(const ThreadTeamLevelTimes ** levels, double & barrierTime) {
+  *levels = benchmarkLevels.empty() ? 0 : &benchmarkLevels[0];
+  barrierTime = benchmarkBarrierTime;
+  return (int) benchmarkLevels.size();
+}
@@ -0,0 +1,81 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ThreadTeam.hpp
+
+ HPCG persistent worker team for the vector kernels of the optimized code
+ */
+
+#ifndef THREADTEAM_HPP
+#define THREADTEAM_HPP
+
+#include "Geometry.hpp"
+
+#define HPCG_TEAM_PAD 8 //!< stride, in doubles, between the per-thread partial sums (one cache line)
+
+/*!
+  Kernel executed by every thread of the team.
+
+  @param[in] tid             Thread number, 0 is the calling (master) thread
+  @param[in] numberOfThreads Number of threads executing the kernel
+  @param[in] args            Kernel arguments
+*/
+typedef void (*ThreadTeamKernel)(int tid, int numberOfThreads, void * args);
+
+/*!
+  Returns the half-open range [begin,end) of n items owned by thread tid.
+
+  The partition only depends on n and the team size, so a thread always works on the same
+  rows of a given level and keeps the pages it touched first.
+*/
+inline void ThreadTeamRange(local_int_t n, int tid, int numberOfThreads, local_int_t & begin, local_int_t & end) {
+  begin = (local_int_t)(((long long) n*tid)/numberOfThreads);
+  end = (local_int_t)(((long long) n*(tid+1))/numberOfThreads);
+  return;
+}
+
+struct ThreadTeamLevelTimes_STRUCT {
+  local_int_t rows;     //!< local rows of the level
+  double teamTime;      //!< seconds per dispatch of a vector update through the team
+  double openmpTime;    //!< seconds per OpenMP parallel region running the same update
+};
+typedef struct ThreadTeamLevelTimes_STRUCT ThreadTeamLevelTimes;
+
+struct SparseMatrix_STRUCT;
+
+void InitializeThreadTeam(int numberOfThreads);
+void FinalizeThreadTeam(void);
+bool UseThreadTeam(void);
+int ThreadTeamSize(void);
+void ThreadTeamRun(ThreadTeamKernel kernel, void * args);
+double * ThreadTeamPartials(void);
+double ThreadTeamSumPartials(void);
+void BenchmarkThreadTeam(const struct SparseMatrix_STRUCT & A);
+int GetThreadTeamBenchmark(const ThreadTeamLevelTimes ** levels, double & barrierTime);
+
+#endif // THREADTEAM_HPP
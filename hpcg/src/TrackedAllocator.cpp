@@ -0,0 +1,211 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file TrackedAllocator.cpp
+
+ HPCG routine
+ */
+
+#include <map>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include "TrackedAllocator.hpp"
+#include "HugePageAllocator.hpp"
+
+struct TrackedBlock {
+  size_t size;
+  int subsystem;
+};
+
+static std::map< uintptr_t, TrackedBlock > trackedBlocks;
+static double trackedCurrent[HPCG_MEM_COUNT];
+static double trackedPeak[HPCG_MEM_COUNT];
+static double trackedTotal = 0.0;
+static double trackedTotalPeak = 0.0;
+static double trackedWindowPeak = 0.0;
+
+/*!
+  Adds (or with a negative value removes) bytes to the running count of a subsystem and updates the peaks.
+  Used directly for memory that is not allocated through TrackedMalloc, e.g. the MKL sparse handles.
+
+  @param[in] subsystem One of the HPCG_MEM_* values
+  @param[in] bytes     Number of bytes allocated (positive) or released (negative)
+*/
+void TrackMemory(int subsystem, double bytes) {
+  if (subsystem < 0 || subsystem >= HPCG_MEM_COUNT) return;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp critical (TrackedAllocator)
+#endif
+  {
+    trackedCurrent[subsystem] += bytes;
+    trackedTotal += bytes;
+    if (trackedCurrent[subsystem] > trackedPeak[subsystem]) trackedPeak[subsystem] = trackedCurrent[subsystem];
+    if (trackedTotal > trackedTotalPeak) trackedTotalPeak = trackedTotal;
+    if (trackedTotal > trackedWindowPeak) trackedWindowPeak = trackedTotal;
+  }
+  return;
+}
+
+/*!
+  Allocates storage through HugePageMalloc and charges it to a subsystem.
+
+  @param[in] size      Number of bytes requested
+  @param[in] subsystem One of the HPCG_MEM_* values
+
+  @return Pointer to the new storage or NULL if no memory is available
+
+  @see TrackedFree
+*/
+void * TrackedMalloc(size_t size, int subsystem) {
+  void * ptr = HugePageMalloc(size);
+  if (ptr == NULL) return NULL;
+  TrackedBlock block = { size, subsystem };
+#ifndef HPCG_NO_OPENMP
+  #pragma omp critical (TrackedAllocator)
+#endif
+  trackedBlocks[(uintptr_t) ptr] = block;
+  TrackMemory(subsystem, (double) size);
+  return ptr;
+}
+
+/*!
+  Releases storage obtained from TrackedMalloc and credits its subsystem.
+
+  @param[in] ptr Pointer returned by TrackedMalloc, may be NULL
+*/
+void TrackedFree(void * ptr) {
+  if (ptr == NULL) return;
+  bool found = false;
+  TrackedBlock block = { 0, 0 };
+#ifndef HPCG_NO_OPENMP
+  #pragma omp critical (TrackedAllocator)
+#endif
+  {
+    std::map< uintptr_t, TrackedBlock >::iterator it = trackedBlocks.find((uintptr_t) ptr);
+    if (it != trackedBlocks.end()) {
+      found = true;
+      block = it->second;
+      trackedBlocks.erase(it);
+    }
+  }
+  if (found) TrackMemory(block.subsystem, -((double) block.size));
+  HugePageFree(ptr);
+  return;
+}
+
+/*!
+  Returns the tracked bytes of this process.
+
+  @param[out] current   Array of HPCG_MEM_COUNT values with the bytes currently allocated per subsystem
+  @param[out] peak      Array of HPCG_MEM_COUNT values with the largest value each subsystem reached
+  @param[out] totalPeak Largest value reached by the sum over all subsystems
+*/
+void GetTrackedMemory(double * current, double * peak, double & totalPeak) {
+  for (int i = 0; i < HPCG_MEM_COUNT; ++i) {
+    current[i] = trackedCurrent[i];
+    peak[i] = trackedPeak[i];
+  }
+  totalPeak = trackedTotalPeak;
+  return;
+}
+
+/*!
+  Starts a measurement window: the window peak is reset to the bytes currently tracked over all subsystems.
+
+  @return The bytes currently tracked over all subsystems
+
+  @see GetTrackedWindowPeak
+*/
+double ResetTrackedWindowPeak(void) {
+  double current = 0.0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp critical (TrackedAllocator)
+#endif
+  {
+    trackedWindowPeak = trackedTotal;
+    current = trackedTotal;
+  }
+  return current;
+}
+
+/*!
+  @param[out] current Bytes currently tracked over all subsystems
+
+  @return The largest sum over all subsystems since the last call to ResetTrackedWindowPeak
+*/
+double GetTrackedWindowPeak(double & current) {
+  double peak = 0.0;
+#ifndef HPCG_NO_OPENMP
+  #pragma omp critical (TrackedAllocator)
+#endif
+  {
+    peak = trackedWindowPeak;
+    current = trackedTotal;
+  }
+  return peak;
+}
+
+/*!
+  @param[in] subsystem One of the HPCG_MEM_* values
+
+  @return The name used for the subsystem in the YAML report
+*/
+const char * TrackedMemoryName(int subsystem) {
+  switch (subsystem) {
+    case HPCG_MEM_MATRIX:  return "Matrix";
+    case HPCG_MEM_MKL:     return "MKL sparse handles (estimated)";
+    case HPCG_MEM_HALO:    return "Halo";
+    case HPCG_MEM_MG:      return "MG";
+    case HPCG_MEM_VECTOR:  return "CG vectors";
+    case HPCG_MEM_SCRATCH: return "Scratch";
+  }
+  return "Unknown";
+}
+
+/*!
+  @return The peak resident set size of this process in bytes, or 0 if it is not available.
+*/
+double GetPeakRSS(void) {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+  return (double) usage.ru_maxrss; // bytes on macOS
+#else
+  return 1024.0 * (double) usage.ru_maxrss; // kilobytes on Linux
+#endif
+#else
+  return 0.0;
+#endif
+}
@@ -0,0 +1,58 @@
+/*******************************************************************************
+* Copyright 2014-2022 Intel Corporation.
+*
+* This software and the related documents are Intel copyrighted  materials,  and
+* your use of  them is  governed by the  express license  under which  they were
+* provided to you (License).  Unless the License provides otherwise, you may not
+* use, modify, copy, publish, distribute,  disclose or transmit this software or
+* the related documents without Intel's prior written permission.
+*
+* This software and the related documents  are provided as  is,  with no express
+* or implied  warranties,  other  than those  that are  expressly stated  in the
+* License.
+*******************************************************************************/
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file TrackedAllocator.hpp
+
+ HPCG allocation wrapper that accounts bytes per subsystem
+ */
+
+#ifndef TRACKEDALLOCATOR_HPP
+#define TRACKEDALLOCATOR_HPP
+
+#include <cstddef>
+
+// Subsystems used to classify tracked allocations
+#define HPCG_MEM_MATRIX  0 //!< generated matrix arrays, CSR arrays, diagonal and boundary maps
+#define HPCG_MEM_MKL     1 //!< estimated size of the internal copies held by the MKL sparse handles
+#define HPCG_MEM_HALO    2 //!< halo exchange lists, buffers and counts
+#define HPCG_MEM_MG      3 //!< f2cOperator and the rc, xc, Axf vectors of every coarse level
+#define HPCG_MEM_VECTOR  4 //!< CG vectors, b, x, xexact and the temporaries of the validation tests
+#define HPCG_MEM_SCRATCH 5 //!< work arrays of the optimized kernels (optData->dtmp)
+#define HPCG_MEM_COUNT   6
+
+void * TrackedMalloc(size_t size, int subsystem);
+void TrackedFree(void * ptr);
+void TrackMemory(int subsystem, double bytes);
+void GetTrackedMemory(double * current, double * peak, double & totalPeak);
+double ResetTrackedWindowPeak(void);
+double GetTrackedWindowPeak(double & current);
+const char * TrackedMemoryName(int subsystem);
+double GetPeakRSS(void);
+
+#endif // TRACKEDALLOCATOR_HPP
@@ -37,6 +37,7 @@
 #include <cstdlib>
 #include "mkl.h"
 #include "Geometry.hpp"
+#include "TrackedAllocator.hpp"
 
 struct Vector_STRUCT {
   local_int_t localLength;  //!< length of local portion of the vector
@@ -55,10 +56,11 @@ typedef struct Vector_STRUCT Vector;
 
   @param[in] v
   @param[in] localLength Length of local portion of input vector
+  @param[in] subsystem Memory accounting category of the vector (HPCG_MEM_VECTOR or HPCG_MEM_MG)
  */
-inline void InitializeVector(Vector & v, local_int_t localLength) {
+inline void InitializeVector(Vector & v, local_int_t localLength, int subsystem = HPCG_MEM_VECTOR) {
   v.localLength = localLength;
-  v.values = (double*) MKL_malloc(sizeof(double)*localLength, 512); //new double[localLength];
+  v.values = (double*) TrackedMalloc(sizeof(double)*localLength, subsystem); //new double[localLength];
   v.optimizationData = 0;
   return;
 }
@@ -90,17 +92,6 @@ inline void ScaleVectorValue(Vector & v, local_int_t index, double value) {
   vv[index] *= value;
   return;
 }
-/*!
-  Fill the input vector with pseudo-random values.
-
-  @param[in] v
- */
-inline void FillRandomVector(Vector & v) {
-  local_int_t localLength = v.localLength;
-  double * vv = v.values;
-  for (int i=0; i<localLength; ++i) vv[i] = rand() / (double)(RAND_MAX) + 1.0;
-  return;
-}
 /*!
   Copy input vector to output vector.
 
@@ -128,7 +119,7 @@ inline void CopyVector(const Vector & v, Vector & w) {
 inline void DeleteVector(Vector & v) {
 
   //delete [] v.values;
-  MKL_free(v.values);
+  TrackedFree(v.values);
   v.localLength = 0;
   return;
 }
@@ -42,7 +42,8 @@
 
    Writes to A.dat, x.dat, xexact.dat and b.dat, respectivly.
 
-   NOTE:  THIS CODE ONLY WORKS ON SINGLE PROCESSOR RUNS
+   NOTE:  THIS CODE ONLY WORKS ON SINGLE PROCESSOR RUNS, BEFORE OptimizeProblem.
+   ExportProblem writes binary (and Matrix Market) files from runs on any number of processes.
 
    Read into MATLAB using:
 
@@ -61,6 +62,7 @@
   @return Returns with -1 if used with more than one MPI process. Returns with 0 otherwise.
 
   @see GenerateProblem
+  @see ExportProblem
 */
 int WriteProblem( const Geometry & geom, const SparseMatrix & A,
     const Vector b, const Vector x, const Vector xexact) {
@@ -57,7 +57,27 @@ struct HPCG_Params_STRUCT {
   local_int_t zl; //!< nz for processors in the z dimension with value less than pz
   local_int_t zu; //!< nz for processors in the z dimension with value greater than pz
   int runRealRef;  // default true, turn on reference implementation
+  int hugePages;   //!< huge page backing for large arrays: 0 off (default), 1 THP, 2 hugetlbfs 2 MB, 3 hugetlbfs 1 GB
+  int compressedIndex; //!< 1 builds the pattern-compressed index format used by the native SpMV kernels
+  int threadTeam; //!< 1 runs the vector kernels on a persistent worker team instead of OpenMP parallel regions
+  int mgTasks;  //!< 1 overlaps the halo exchanges of the V-cycle with task-parallel row blocks
+  int commThread; //!< 1 reserves one hardware thread per rank for an MPI progress agent (needs MPI_THREAD_MULTIPLE)
+  int cacgSteps; //!< s > 0 compares s-step CA-CG against CG after the timed runs (s iterations per global reduction)
+  int deepHalo; //!< k > 0 builds a ghost region of k layers on the fine level, used by the matrix powers kernel of --cacg
+  int mgHaloPrecision; //!< halo encoding inside the MG preconditioner: 0 double (default), 1 float, 2 16-bit blocks
+  int mgHaloLevel; //!< first MG level using --mg-halo-precision, finer levels exchange doubles
+  int haloBackend; //!< halo exchange backend, 0: MPI_Alltoallv and point-to-point, 1: neighborhood collectives, 2: one-sided MPI_Put
+  int haloBench; //!< exchanges timed per level and halo transport, 0 skips the benchmark
+  int haloPack; //!< halo packing, 0: index gather, 1: MPI datatypes, 2: strided kernels, 3: datatypes unless slower than the kernels
+  int localOrder; //!< 1 renumbers the local rows with the interior first and the boundary rows grouped by neighbor
+  int checkProblem; //!< 0 checks the generated levels with asserts, 1 fast check with a mismatch report, 2 also checks the CSR arrays after OptimizeProblem
+  int exportFormat; //!< files written by --export, 0: binary, 1: binary plus Matrix Market text
+  int optimizeInPlace; //!< 1 packs the row slabs into the CSR arrays of OptimizeProblem in place, 0 copies them
   char yamlFileName[1024];
+  char checkpointDir[1024]; //!< directory of the per-rank problem snapshots, empty to always generate the problem
+  char refCacheDir[1024]; //!< directory of the cached reference results, empty to always run the reference phases
+  char exportDir[1024]; //!< directory the optimized fine level is exported to, empty to skip the export
+  char matrixFile[1024]; //!< matrix imported instead of generating the problem (binary or Matrix Market), empty to generate it
  
 };
 /*!
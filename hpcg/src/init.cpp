@@ -92,7 +92,27 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
   iparams = (int *)malloc(sizeof(int) * nparams);
 
   params.runRealRef = 1;
+  params.hugePages = 0;
+  params.compressedIndex = 0;
+  params.threadTeam = 0;
+  params.mgTasks = 0;
+  params.commThread = 0;
+  params.cacgSteps = 0;
+  params.deepHalo = 0;
+  params.mgHaloPrecision = 0;
+  params.mgHaloLevel = 0;
+  params.haloBackend = 0;
+  params.haloBench = 0;
+  params.haloPack = 0;
+  params.localOrder = 0;
+  params.checkProblem = 0;
+  params.exportFormat = 0;
+  params.optimizeInPlace = 1;
   params.yamlFileName[0]='\0';
+  params.checkpointDir[0]='\0';
+  params.refCacheDir[0]='\0';
+  params.exportDir[0]='\0';
+  params.matrixFile[0]='\0';
 
   // Initialize iparams
   for (i = 0; i < nparams; ++i) iparams[i] = 0;
@@ -117,6 +137,150 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
       }
   }
 
+  /*Check for huge-pages*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--huge-pages="))
+      {
+          if (sscanf(argv[i]+strlen("--huge-pages="), "%d", &(params.hugePages)) != 1) params.hugePages = 0;
+      }
+  }
+
+  /*Check for compressed-index*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--compressed-index="))
+      {
+          if (sscanf(argv[i]+strlen("--compressed-index="), "%d", &(params.compressedIndex)) != 1) params.compressedIndex = 0;
+      }
+  }
+
+  /*Check for thread-team*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--thread-team="))
+      {
+          if (sscanf(argv[i]+strlen("--thread-team="), "%d", &(params.threadTeam)) != 1) params.threadTeam = 0;
+      }
+  }
+
+  /*Check for mg-tasks*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--mg-tasks="))
+      {
+          if (sscanf(argv[i]+strlen("--mg-tasks="), "%d", &(params.mgTasks)) != 1) params.mgTasks = 0;
+      }
+  }
+
+  /*Check for comm-thread*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--comm-thread="))
+      {
+          if (sscanf(argv[i]+strlen("--comm-thread="), "%d", &(params.commThread)) != 1) params.commThread = 0;
+      }
+  }
+
+  /*Check for cacg*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--cacg="))
+      {
+          if (sscanf(argv[i]+strlen("--cacg="), "%d", &(params.cacgSteps)) != 1) params.cacgSteps = 0;
+      }
+  }
+
+  /*Check for deep-halo*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--deep-halo="))
+      {
+          if (sscanf(argv[i]+strlen("--deep-halo="), "%d", &(params.deepHalo)) != 1) params.deepHalo = 0;
+      }
+  }
+
+  /*Check for mg-halo-precision*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--mg-halo-precision="))
+      {
+          if (sscanf(argv[i]+strlen("--mg-halo-precision="), "%d", &(params.mgHaloPrecision)) != 1) params.mgHaloPrecision = 0;
+      }
+  }
+
+  /*Check for mg-halo-level*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--mg-halo-level="))
+      {
+          if (sscanf(argv[i]+strlen("--mg-halo-level="), "%d", &(params.mgHaloLevel)) != 1) params.mgHaloLevel = 0;
+      }
+  }
+
+  /*Check for halo-backend*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--halo-backend="))
+      {
+          if (sscanf(argv[i]+strlen("--halo-backend="), "%d", &(params.haloBackend)) != 1) params.haloBackend = 0;
+      }
+  }
+
+  /*Check for halo-bench*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--halo-bench="))
+      {
+          if (sscanf(argv[i]+strlen("--halo-bench="), "%d", &(params.haloBench)) != 1) params.haloBench = 0;
+      }
+  }
+
+  /*Check for halo-pack*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--halo-pack="))
+      {
+          if (sscanf(argv[i]+strlen("--halo-pack="), "%d", &(params.haloPack)) != 1) params.haloPack = 0;
+      }
+  }
+
+  /*Check for local-order*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--local-order="))
+      {
+          if (sscanf(argv[i]+strlen("--local-order="), "%d", &(params.localOrder)) != 1) params.localOrder = 0;
+      }
+  }
+
+  /*Check for check-problem*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--check-problem="))
+      {
+          if (sscanf(argv[i]+strlen("--check-problem="), "%d", &(params.checkProblem)) != 1) params.checkProblem = 0;
+      }
+  }
+
+  /*Check for export-format*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--export-format="))
+      {
+          if (sscanf(argv[i]+strlen("--export-format="), "%d", &(params.exportFormat)) != 1) params.exportFormat = 0;
+      }
+  }
+
+  /*Check for optimize-in-place*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--optimize-in-place="))
+      {
+          if (sscanf(argv[i]+strlen("--optimize-in-place="), "%d", &(params.optimizeInPlace)) != 1) params.optimizeInPlace = 1;
+      }
+  }
+
 //strcpy(params.yamlFileName, optarg);
 
   for (i = 1; i <= argc && argv[i]; ++i)
@@ -128,6 +292,42 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
       }
   }
 
+  /*Check for checkpoint directory*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--checkpoint="))
+      {
+          if (sscanf(argv[i]+strlen("--checkpoint="), "%1023s", params.checkpointDir) != 1) params.checkpointDir[0] = '\0';
+      }
+  }
+
+  /*Check for reference cache directory*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--ref-cache="))
+      {
+          if (sscanf(argv[i]+strlen("--ref-cache="), "%1023s", params.refCacheDir) != 1) params.refCacheDir[0] = '\0';
+      }
+  }
+
+  /*Check for export directory*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--export="))
+      {
+          if (sscanf(argv[i]+strlen("--export="), "%1023s", params.exportDir) != 1) params.exportDir[0] = '\0';
+      }
+  }
+
+  /*Check for an imported matrix*/
+  for (i = 1; i <= argc && argv[i]; ++i)
+  {
+      if (startswith(argv[i],"--matrix="))
+      {
+          if (sscanf(argv[i]+strlen("--matrix="), "%1023s", params.matrixFile) != 1) params.matrixFile[0] = '\0';
+      }
+  }
+
   // Check if --rt was specified on the command line
   int * rt  = iparams+3;  // Assume runtime was not specified and will be read from the hpcg.dat file
   if (iparams[3]) rt = 0; // If --rt was specified, we already have the runtime, so don't read it from file
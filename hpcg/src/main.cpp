@@ -69,14 +69,116 @@ using std::endl;
 #include "Geometry.hpp"
 #include "SparseMatrix.hpp"
 #include "Vector.hpp"
+#include "RandomVector.hpp"
 #include "CGData.hpp"
 #include "TestCG.hpp"
 #include "TestSymmetry.hpp"
 #include "TestNorms.hpp"
+#include "HugePageAllocator.hpp"
+#include "CompressedMatrix.hpp"
+#include "ThreadTeam.hpp"
+#include "ComputeMGTasks.hpp"
+#include "CommThread.hpp"
+#include "CACG.hpp"
+#include "HaloBenchmark.hpp"
+#include "LocalOrdering.hpp"
+#include "Checkpoint.hpp"
+#include "ReferenceCache.hpp"
+#include "ExportProblem.hpp"
+#include "ImportProblem.hpp"
 
 #include <cmath>
 #include <cfloat>
 
+/*!
+  Runs the optimized CG on a matrix read by ImportProblem in place of the generated problem. The
+  rows are distributed in contiguous blocks and there is no grid to coarsen, so the preconditioner
+  is a single level: one symmetric Gauss-Seidel sweep on the rows of every rank. The CG sets of
+  50 iterations are timed for the running time of the benchmark; there are no reference or
+  validation phases.
+
+  @param[in] params The parameters of the run, params.matrixFile names the matrix
+
+  @return Returns zero on success and a non-zero value otherwise
+
+  @see ReportImportedResults
+*/
+static int RunImportedProblem(const HPCG_Params & params) {
+
+  const int rank = params.comm_rank;
+  // The rows of an imported matrix follow no stencil, keep the natural order and the general CSR kernels
+  if ((params.compressedIndex || params.localOrder) && rank==0)
+    HPCG_fout << "The compressed index format and the local row ordering need the generated problem, they are not used with --matrix." << endl;
+  InitializeCompressedMatrix(0);
+  InitializeLocalOrdering(0);
+
+  std::vector< double > times(10,0.0);
+  double setup_time = mytimer();
+
+  Geometry * geom = new Geometry(); // zeroed, DeleteMatrix may release it before ImportProblem fills it in
+  geom->size = params.comm_size;
+  geom->rank = rank;
+  geom->numThreads = params.numThreads;
+  SparseMatrix A;
+  InitializeSparseMatrix(A, geom);
+  A.nproc = MKL_Get_Max_Threads();
+  Vector b, x, xexact;
+  int format = 0;
+  int ierr = ImportProblem(params.matrixFile, A, b, x, xexact, format);
+  if (ierr) {
+    DeleteMatrix(A); // Also releases geom
+    return ierr;
+  }
+  SetupHalo(A);
+#ifndef HPCG_LOCAL_LONG_LONG
+  TrackedFree(A.mtxG);
+#endif
+  times[9] = mytimer() - setup_time;
+
+  double t7 = 0.0;
+  OptimizeProblem(&A, t7);
+  times[7] = t7;
+
+  CGData data;
+  InitializeSparseCGData(A, data);
+
+  // One untimed set gives the number of sets that fills the running time
+  const int maxIters = 50;
+  int niters = 0, totalNiters = 0, errors = 0;
+  double normr = 0.0, normr0 = 0.0;
+  std::vector< double > set_times(9,0.0);
+  ZeroVector(x);
+  double set_time = mytimer();
+  if (CG(A, data, b, x, maxIters, 0.0, niters, normr, normr0, &set_times[0], true)) ++errors;
+  set_time = mytimer() - set_time;
+#ifndef HPCG_NO_MPI
+  double local_set_time = set_time;
+  MPI_Allreduce(&local_set_time, &set_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  int numberOfCgSets = int(params.runningTime / set_time) + 1; // Run at least once, account for rounding
+
+  for (int i=0; i< numberOfCgSets; ++i) {
+    ZeroVector(x);
+#ifndef HPCG_NO_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    ierr = CG(A, data, b, x, maxIters, 0.0, niters, normr, normr0, &times[0], true);
+    if (ierr) ++errors;
+    totalNiters += niters;
+    if (rank==0) HPCG_fout << "Call [" << i << "] Scaled Residual [" << normr/normr0 << "]" << endl;
+  }
+  if (errors && rank==0) HPCG_fout << errors << " error(s) in call(s) to optimized CG." << endl;
+
+  ReportImportedResults(A, params.matrixFile, format, numberOfCgSets, totalNiters, normr/normr0, errors, &times[0], params);
+
+  DeleteMatrix(A);
+  DeleteCGData(data);
+  DeleteVector(x);
+  DeleteVector(b);
+  DeleteVector(xexact);
+  return errors;
+}
+
 /*!
   Main driver program: Construct synthetic problem, run V&V tests, compute benchmark parameters, run benchmark, report results.
 
@@ -88,14 +190,43 @@ using std::endl;
 */
 int main(int argc, char * argv[]) {
 
+  int mpiThreadLevel = 0;
 #ifndef HPCG_NO_MPI
-  MPI_Init(&argc, &argv);
+  // The communication agent calls MPI concurrently with the master thread
+  MPI_Init_thread(&argc, &argv, CommThreadRequested(argc, argv) ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED, &mpiThreadLevel);
 #endif
 
   HPCG_Params params;
 
   HPCG_Init(&argc, &argv, params);
 
+  // The agent takes one of the OpenMP threads of the rank
+  params.numThreads = InitializeCommThread(params.commThread, mpiThreadLevel);
+
+  // Large arrays allocated from here on may be backed by huge pages
+  InitializeHugePages(params.hugePages);
+  InitializeCompressedMatrix(params.compressedIndex);
+  // The compressed index format relies on the stencil offsets of the natural ordering
+  InitializeLocalOrdering(params.compressedIndex ? 0 : params.localOrder);
+  if (params.compressedIndex && params.localOrder && params.comm_rank==0)
+    HPCG_fout << "The local row ordering is not available with the compressed index format, keeping the natural ordering." << endl;
+  InitializeThreadTeam(params.threadTeam ? params.numThreads : 0);
+  InitializeMGTasks(params.mgTasks);
+  InitializeCheckProblem(params.checkProblem);
+  InitializeOptimizeInPlace(params.optimizeInPlace);
+
+  // An imported matrix replaces the generated problem and the benchmark phases
+  if (params.matrixFile[0] != '\0') {
+    int ierr = RunImportedProblem(params);
+    FinalizeThreadTeam();
+    FinalizeCommThread();
+    HPCG_Finalize();
+#ifndef HPCG_NO_MPI
+    MPI_Finalize();
+#endif
+    return ierr;
+  }
+
   // Check if QuickPath option is enabled.
   // If the running time is set to zero, we minimize all paths through the program
   bool quickPath = (params.runningTime==0);
@@ -150,13 +281,23 @@ int main(int argc, char * argv[]) {
   InitializeSparseMatrix(A, geom);
   A.nproc = nproc;
   Vector b, x, xexact;
-  GenerateProblem(A, &b, &x, &xexact);
-  SetupHalo(A);
   int numberOfMgLevels = 4; // Number of levels including first
   SparseMatrix * curLevelMatrix = &A;
-  for (int level = 1; level< numberOfMgLevels; ++level) {
-      GenerateCoarseProblem(*curLevelMatrix);
-      curLevelMatrix = curLevelMatrix->Ac; // Make the just-constructed coarse grid the next level
+
+  // A snapshot of an earlier run with the same configuration replaces the setup, the checks and OptimizeProblem.
+  // The reference timing phase needs the generated matrix, so snapshots are only used without it.
+  bool useCheckpoint = (params.checkpointDir[0] != '\0' && params.runRealRef == 0);
+  if (params.checkpointDir[0] != '\0' && params.runRealRef != 0 && rank==0)
+    HPCG_fout << "Checkpoints are only used with --run-real-ref=0, generating the problem." << endl;
+  double checkpointT7 = 0.0;
+  bool fromCheckpoint = useCheckpoint && ReadCheckpoint(params.checkpointDir, A, b, x, xexact, numberOfMgLevels, checkpointT7) == 0;
+  if (!fromCheckpoint) {
+    GenerateProblem(A, &b, &x, &xexact);
+    SetupHalo(A);
+    for (int level = 1; level< numberOfMgLevels; ++level) {
+        GenerateCoarseProblem(*curLevelMatrix);
+        curLevelMatrix = curLevelMatrix->Ac; // Make the just-constructed coarse grid the next level
+    }
   }
 
   setup_time = mytimer() - setup_time; // Capture total time of setup
@@ -166,8 +307,9 @@ int main(int argc, char * argv[]) {
   Vector * curb = &b;
   Vector * curx = &x;
   Vector * curxexact = &xexact;
-  for (int level = 0; level< numberOfMgLevels; ++level) {
-     CheckProblem(*curLevelMatrix, curb, curx, curxexact);
+  int checkFailures = 0; // Mismatches found by the fast checks, the reference check asserts instead
+  for (int level = 0; level< numberOfMgLevels && !fromCheckpoint; ++level) {
+     if (CheckGeneratedProblem(*curLevelMatrix, level, curb, curx, curxexact)) ++checkFailures;
      curLevelMatrix = curLevelMatrix->Ac; // Make the nextcoarse grid the next level
      curb = 0; // No vectors after the top level
      curx = 0;
@@ -180,7 +322,7 @@ int main(int argc, char * argv[]) {
       curLevelMatrix = &A;
       for (int level = 0; level< numberOfMgLevels; ++level)
       {
-          MKL_free(curLevelMatrix->mtxG);
+          TrackedFree(curLevelMatrix->mtxG);
           curLevelMatrix = curLevelMatrix->Ac;
       }
 //  }
@@ -200,15 +342,26 @@ int main(int argc, char * argv[]) {
 
   int numberOfCalls = 10;
   if (quickPath) numberOfCalls = 1; //QuickPath means we do on one call of each block of repetitive code
+  int refMaxIters = 50;
+
+  // Results of the reference phases of an earlier run with the same problem, process grid and settings
+  // replace both the SpMV+MG timing and the reference CG run
+  ReferenceCacheData refCache;
+  const int refTimingCalls = numberOfCalls;
+  bool fromRefCache = params.refCacheDir[0] != '\0' && params.runRealRef != 0
+      && ReadReferenceCache(params.refCacheDir, *geom, numberOfMgLevels, refMaxIters, refTimingCalls, refCache) == 0;
+  if (params.refCacheDir[0] != '\0' && params.runRealRef == 0 && rank==0)
+    HPCG_fout << "The reference cache is only used with --run-real-ref=1, ignoring it." << endl;
+
   double t_begin = mytimer();
-  if( params.runRealRef != 0 )
+  if( params.runRealRef != 0 && !fromRefCache )
   {
       Vector x_overlap, b_computed;
       InitializeVector(x_overlap, ncol); // Overlapped copy of x vector
       InitializeVector(b_computed, nrow); // Computed RHS vector
       // Record execution time of reference SpMV and MG kernels for reporting times
       // First load vector with random values
-      FillRandomVector(x_overlap);
+      FillRandomVector(A, x_overlap, 0);
         for (int i=0; i< numberOfCalls; ++i) {
           ierr = ComputeSPMV_ref(A, x_overlap, b_computed); // b_computed = A*x_overlap
           if (ierr) HPCG_fout << "Error in call to SpMV: " << ierr << ".\n" << endl;
@@ -219,6 +372,7 @@ int main(int argc, char * argv[]) {
       DeleteVector(b_computed);
   }
   times[8] = (mytimer() - t_begin)/((double) numberOfCalls);  // Total time divided by number of calls.
+  if (fromRefCache) times[8] = refCache.spmvMgTime;
 #ifdef HPCG_DEBUG
   if (rank==0) HPCG_fout << "Total SpMV+MG timing phase execution time in main (sec) = " << mytimer() - t1 << endl;
 #endif
@@ -230,13 +384,12 @@ int main(int argc, char * argv[]) {
 #ifdef HPCG_DEBUG
   t1 = mytimer();
 #endif
-  int global_failure = 0; // assume all is well: no failures
+  int global_failure = (checkFailures > 0); // assume all is well unless the problem checks failed
 
   int niters = 0;
   int totalNiters_ref = 0;
   double normr = 0.0;
   double normr0 = 0.0;
-  int refMaxIters = 50;
   numberOfCalls = 1; // Only need to run the residual reduction analysis once
 
   std::vector< double > ref_times(9,0.0);
@@ -247,8 +400,29 @@ int main(int argc, char * argv[]) {
   if( params.runRealRef == 0 )
   {
       // Call user-tunable set up function.
-      double t7 = 0.0;
-      OptimizeProblem(&A, t7);
+      double t7 = checkpointT7;
+      if (!fromCheckpoint) {
+          RetainOptimizedCsr(useCheckpoint || params.checkProblem == HPCG_CHECK_OPTIMIZED || params.exportDir[0] != '\0');
+          OptimizeProblem(&A, t7);
+          // The vectors follow the rows if OptimizeProblem renumbered them
+          ApplyLocalOrdering(A, b);
+          ApplyLocalOrdering(A, x);
+          ApplyLocalOrdering(A, xexact);
+          curLevelMatrix = &A;
+          for (int level = 0; level< numberOfMgLevels; ++level) {
+              if (CheckOptimizedProblem(*curLevelMatrix, level, level==0 ? &b : 0, level==0 ? &x : 0, level==0 ? &xexact : 0)) global_failure = 1;
+              curLevelMatrix = curLevelMatrix->Ac;
+          }
+          if (params.exportDir[0] != '\0') {
+              ierr = ExportProblem(params.exportDir, A, b, x, xexact, params.exportFormat);
+              if (ierr && rank==0) HPCG_fout << "Could not export the problem to " << params.exportDir << "." << endl;
+          }
+          if (useCheckpoint) {
+              ierr = WriteCheckpoint(params.checkpointDir, A, b, xexact, numberOfMgLevels);
+              if (ierr && rank==0) HPCG_fout << "Could not write the checkpoint to " << params.checkpointDir << "." << endl;
+          }
+          ReleaseOptimizedCsr(A);
+      }
       times[7] = t7;
       // Compute the residual reduction for the natural ordering and reference kernels
       for (int i=0; i< numberOfCalls; ++i)
@@ -261,7 +435,7 @@ int main(int argc, char * argv[]) {
   } else
   {
       // Compute the residual reduction for the natural ordering and reference kernels
-      for (int i=0; i< numberOfCalls; ++i)
+      for (int i=0; i< numberOfCalls && !fromRefCache; ++i)
       {
           ZeroVector(x);
           ierr = CG_ref( A, data, b, x, refMaxIters, tolerance, niters, normr, normr0, &ref_times[0], true);
@@ -270,8 +444,24 @@ int main(int argc, char * argv[]) {
       }
       // Call user-tunable set up function.
       double t7 = 0.0;
+      RetainOptimizedCsr(params.checkProblem == HPCG_CHECK_OPTIMIZED || params.exportDir[0] != '\0');
       OptimizeProblem(&A, t7);
       times[7] = t7;
+      // The vectors follow the rows if OptimizeProblem renumbered them
+      ApplyLocalOrdering(A, b);
+      ApplyLocalOrdering(A, x);
+      ApplyLocalOrdering(A, xexact);
+      // x holds the reference solution by now, only b and xexact are checked
+      curLevelMatrix = &A;
+      for (int level = 0; level< numberOfMgLevels; ++level) {
+          if (CheckOptimizedProblem(*curLevelMatrix, level, level==0 ? &b : 0, 0, level==0 ? &xexact : 0)) global_failure = 1;
+          curLevelMatrix = curLevelMatrix->Ac;
+      }
+      if (params.exportDir[0] != '\0') {
+          ierr = ExportProblem(params.exportDir, A, b, x, xexact, params.exportFormat);
+          if (ierr && rank==0) HPCG_fout << "Could not export the problem to " << params.exportDir << "." << endl;
+      }
+      ReleaseOptimizedCsr(A);
   }
 #ifdef HPCG_DEBUG
   if (rank==0) HPCG_fout << "Total problem setup time in main (sec) = " << mytimer() - t1 << endl;
@@ -280,8 +470,41 @@ int main(int argc, char * argv[]) {
   if (geom->size == 1) WriteProblem(*geom, A, b, x, xexact);
 #endif
 
+  // Halo encoding of the MG levels, the CG iteration always exchanges double values
+  ierr = SetupHaloPrecision(A, params.mgHaloPrecision, params.mgHaloLevel);
+  if (ierr && rank==0) HPCG_fout << "Unknown MG halo precision " << params.mgHaloPrecision << ", using double." << endl;
+
+  // Transport of the double precision halos on every level
+  ierr = SetupHaloBackend(A, params.haloBackend);
+  if (ierr && rank==0) HPCG_fout << "Unknown halo backend " << params.haloBackend << ", using MPI_Alltoallv." << endl;
+  ierr = SetupHaloDatatypes(A, params.haloPack);
+  if (ierr && rank==0) HPCG_fout << "Unknown halo packing " << params.haloPack << ", using the index gather." << endl;
+  // Fine level vectors exchanged by the optimized CG and MG, the coarse ones are registered by SetupHaloBackend
+  RegisterHaloWindow(A, data.p);
+  RegisterHaloWindow(A, data.z);
+  BenchmarkHaloTransports(A, params.haloBench);
+
+  // Ghost region of several layers for kernels that exchange once every few steps
+  if (params.deepHalo > 0) {
+    ierr = SetupDeepHalo(A, params.deepHalo);
+    if (ierr && rank==0) HPCG_fout << "Deep halo of width " << params.deepHalo << " is not supported by the local grid dimensions or the local row ordering." << endl;
+  }
+
+  // Dispatch overhead of the worker team on every MG level, reported in the YAML file
+  BenchmarkThreadTeam(A);
+
   if (rank == 0 && err_count) HPCG_fout << err_count << " error(s) in call(s) to reference CG." << endl;
-  refTolerance = normr / normr0;
+  if (fromRefCache) {
+    refTolerance = refCache.refTolerance;
+    totalNiters_ref = refCache.totalNiters_ref;
+  } else refTolerance = normr / normr0;
+  if (!fromRefCache && params.refCacheDir[0] != '\0' && params.runRealRef != 0) {
+    refCache.refTolerance = refTolerance;
+    refCache.totalNiters_ref = totalNiters_ref;
+    refCache.spmvMgTime = times[8];
+    ierr = WriteReferenceCache(params.refCacheDir, *geom, numberOfMgLevels, refMaxIters, refTimingCalls, refCache);
+    if (ierr && rank==0) HPCG_fout << "Could not store the reference results in " << params.refCacheDir << "." << endl;
+  }
 
   //////////////////////////////
   // Validation Testing Phase //
@@ -400,6 +623,12 @@ int main(int argc, char * argv[]) {
   // Test Norm Results
   ierr = TestNorms(testnorms_data);
 
+  // Compare the s-step solver against CG on the same number of iterations
+  if (params.cacgSteps > 0) {
+    ierr = CompareCACG(A, data, b, x, params.cacgSteps, optMaxIters);
+    if (ierr && rank==0) HPCG_fout << "Error in call to CompareCACG: " << ierr << ".\n" << endl;
+  }
+
   ////////////////////
   // Report Results //
   ////////////////////
@@ -415,6 +644,8 @@ int main(int argc, char * argv[]) {
   DeleteVector(xexact);
   delete [] testnorms_data.values;
 
+  FinalizeThreadTeam();
+  FinalizeCommThread();
   HPCG_Finalize();
   // Finish up
 #ifndef HPCG_NO_MPI